@@ -29,6 +29,9 @@ QString jsonCsvFileDialogFilter() { return QObject::tr("JSON & CSV files (*.json
 QString csvFileDialogFilter() { return QObject::tr("CSV files (*.csv);;All files (*.*)"); }
 QString const backupFileExtension = "btbackup";
 QString backupFileDialogFilter() { return QObject::tr("Beeftext backup files (*.%1);;All files (*.*)").arg(backupFileExtension); }
+QString const keystrokeTraceFileExtension = "bttrace";
+QString keystrokeTraceFileDialogFilter() { return QObject::tr("Beeftext keystroke trace files (*.%1);;All files (*.*)")
+   .arg(keystrokeTraceFileExtension); }
 Qt::DateFormat const kJsonExportDateFormat = Qt::ISODateWithMs;
 QChar const kEmojiDelimiter = '|';
 
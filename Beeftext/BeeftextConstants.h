@@ -28,6 +28,8 @@ QString jsonCsvFileDialogFilter(); ///< The file format filter for the import fi
 QString csvFileDialogFilter(); ///< The file format filter for CSV files.
 extern QString const backupFileExtension; ///< The extension for backup files.
 QString backupFileDialogFilter(); ///< The file format filter for the backup and restore file picker dialogs.
+extern QString const keystrokeTraceFileExtension; ///< The extension for keystroke trace files.
+QString keystrokeTraceFileDialogFilter(); ///< The file format filter for keystroke trace files.
 extern Qt::DateFormat const kJsonExportDateFormat; ///< The date/time export format used for JSon docs
 extern QChar const kEmojiDelimiter; ///< The delimiter for emojis
 
@@ -13,8 +13,9 @@
 #include "InputManager.h"
 #include "PreferencesManager.h"
 #include "BeeftextGlobals.h"
+#include "LatencyMonitor.h"
+#include "ForegroundContextService.h"
 #include "Clipboard/ClipboardManager.h"
-#include <Psapi.h>
 #include <XMiLib/SystemUtils.h>
 #include <XMiLib/Exception.h>
 
@@ -121,21 +122,14 @@ bool usePortableAppsFolderLayout()
 
 
 //**********************************************************************************************************************
+/// The name is cached by the foreground context service, which looks it up when the foreground window changes.
+///
 /// \return The name of the currently active application, including its extension (e.g. "explorer.exe")
 /// \return A null string in case of failure
 //**********************************************************************************************************************
 QString getActiveExecutableFileName()
 {
-   WCHAR buffer[MAX_PATH + 1] = { 0 };
-   DWORD processId = 0;
-   GetWindowThreadProcessId(GetForegroundWindow(), &processId);
-   // ReSharper disable once CppLocalVariableMayBeConst
-   HANDLE processHandle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
-   if (!processHandle)
-      return QString();
-   bool const ok = GetModuleFileNameEx(processHandle, nullptr, buffer, MAX_PATH);
-   CloseHandle(processHandle);
-   return ok ? QFileInfo(QDir::fromNativeSeparators(QString::fromWCharArray(buffer))).fileName() : QString();
+   return ForegroundContextService::instance().context().executableFileName;
 }
 
 
@@ -164,6 +158,7 @@ QString snippetToPlainText(QString const& snippet, bool isHtml)
 //**********************************************************************************************************************
 void performTextSubstitution(qint32 charCount, QString const& newText, bool isHtml, qint32 cursorPos)
 {
+   LatencyTimer const timer(TextSubstitutionStage);
    InputManager& inputManager = InputManager::instance();
    bool const wasKeyboardHookEnabled = inputManager.setKeyboardHookEnabled(false);
    // we disable the hook to prevent endless recursive substitution
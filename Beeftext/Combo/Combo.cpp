@@ -14,6 +14,7 @@
 #include "BeeftextUtils.h"
 #include "BeeftextGlobals.h"
 #include "BeeftextConstants.h"
+#include "LatencyMonitor.h"
 #include <utility>
 
 
@@ -179,6 +180,8 @@ void Combo::setSnippet(QString const& snippet)
    if (snippet_ != snippet)
    {
       snippet_ = snippet;
+      snippetTemplate_.reset();
+      this->invalidateEvaluatedSnippet();
       this->touch();
    }
 }
@@ -198,7 +201,12 @@ bool Combo::useHtml() const
 //**********************************************************************************************************************
 void Combo::setUseHtml(bool useHtml)
 {
-   useHtml_ = useHtml;
+   if (useHtml_ != useHtml)
+   {
+      useHtml_ = useHtml;
+      snippetTemplate_.reset();
+      this->invalidateEvaluatedSnippet();
+   }
 }
 
 
@@ -313,18 +321,26 @@ bool Combo::matchesForInput(QString const& input) const
 
 
 //**********************************************************************************************************************
+/// The number of characters to erase is the number of UTF-16 characters the user typed for the keyword, which can
+/// differ from the length of the keyword when matching ignores normalization.
+///
+/// \param[in] typedLength The number of UTF-16 characters typed by the user for the keyword
 /// \return true if the substitution was actually performed (it could a been cancelled, for instance by the user
 /// dismissing a variable input dialog.
 //*********************************************************************************************************************
-bool Combo::performSubstitution()
+bool Combo::performSubstitution(qint32 typedLength)
 {
    qint32 cursorLeftShift = -1;
    bool cancelled = false;
-   QMap<QString, QString> knownInputVariables;
-   QString const& newText = this->evaluatedSnippet(cancelled, QSet<QString>(), knownInputVariables, &cursorLeftShift);
+   EvaluationContext context;
+   QString newText;
+   {
+      LatencyTimer const timer(SnippetEvaluationStage);
+      newText = this->evaluatedSnippet(cancelled, context, &cursorLeftShift);
+   }
    if (!cancelled)
    {
-      performTextSubstitution(keyword_.size(), newText, useHtml_, cursorLeftShift);
+      performTextSubstitution(typedLength, newText, useHtml_, cursorLeftShift);
       lastUseDateTime_ = QDateTime::currentDateTime();
    }
    return !cancelled;
@@ -339,8 +355,12 @@ bool Combo::insertSnippet()
 {
    qint32 cursorLeftShift = -1;
    bool cancelled = false;
-   QMap<QString, QString> knownInputVariables;
-   QString const& newText = this->evaluatedSnippet(cancelled, QSet<QString>(), knownInputVariables, &cursorLeftShift);
+   EvaluationContext context;
+   QString newText;
+   {
+      LatencyTimer const timer(SnippetEvaluationStage);
+      newText = this->evaluatedSnippet(cancelled, context, &cursorLeftShift);
+   }
    if (!cancelled)
    {
       performTextSubstitution(0, newText, useHtml_, cursorLeftShift);
@@ -439,69 +459,97 @@ void Combo::touch()
 }
 
 
+//**********************************************************************************************************************
+/// \return The compiled snippet
+//**********************************************************************************************************************
+SpSnippetTemplate Combo::snippetTemplate() const
+{
+   if (!snippetTemplate_)
+      snippetTemplate_ = std::make_shared<SnippetTemplate>(snippet_, useHtml_);
+   return snippetTemplate_;
+}
+
+
 //**********************************************************************************************************************
 /// \param[out] outCancelled Did the user cancel user input
 /// \param[in] outCursorPos The final position of the cursor, relative to the beginning of the snippet
-/// \param[in] forbiddenSubCombos The text of the combos that are not allowed to be substituted using #{combo:}, to 
-/// avoid endless recursion
-/// \param[in,out] knownInputVariables The list of know input variables.
+/// \param[in,out] context The context of the evaluation
 /// \return The snippet text once it has been evaluated
 //**********************************************************************************************************************
-QString Combo::evaluatedSnippet(bool& outCancelled, QSet<QString> const& forbiddenSubCombos, 
-   QMap<QString, QString>& knownInputVariables, qint32* outCursorPos) const
+QString Combo::evaluatedSnippet(bool& outCancelled, EvaluationContext& context, qint32* outCursorPos) const
 {
    outCancelled = false;
-   QTextDocument remainingText;
-   if (this->useHtml())
-      remainingText.setHtml(snippet_);
-   else
-      remainingText.setPlainText(snippet_);
-   QTextDocument result;
-   QTextCursor resultCursor(&result);
+   CachedSnippet& cache = outCursorPos ? cachedSnippet_ : cachedSubSnippet_; // a nested cursor is not evaluated
+   if (cache.isValid)
+   {
+      if (cache.cursorPos >= 0)
+         *outCursorPos = cache.cursorPos;
+      return cache.text;
+   }
 
-   // The following regular expression detects the first variable #{}, ensuring the closing } is not preceded by a \.
-   // Lazy (a.k.a. non-greedy) operators are used to match the first variable with the smallest possible contents
-   // inside the #{}.
-   QRegularExpression const regexp(R"((#\{(.*?)(?<!\\)\}))");
+   // the local copy keeps the template alive if the combo is edited while a variable is evaluated
+   SpSnippetTemplate const snippetTemplate = this->snippetTemplate();
+   SnippetTemplate::VariableEvaluator const evaluator = [&](SnippetTemplate::Node const& variable, bool& outIsHtml,
+      bool& outVariableCancelled) -> QString
+   {
+      return evaluateVariable(variable, context, outIsHtml, outVariableCancelled);
+   };
+   qint32 cursorOffset = -1;
+   qint32* const cursorOffsetPtr = outCursorPos ? &cursorOffset : nullptr;
+   QString result;
+   qint32 cursorPos = -1;
+   if (snippetTemplate->isHtml())
+   {
+      QString plainText;
+      result = snippetTemplate->evaluateHtml(evaluator, outCancelled, cursorOffsetPtr, outCursorPos ? &plainText : 
+         nullptr);
+      if (cursorOffset >= 0)
+         cursorPos = printableCharacterCount(plainText.left(cursorOffset));
+   }
+   else
+   {
+      result = snippetTemplate->evaluatePlainText(evaluator, outCancelled, cursorOffsetPtr);
+      if (cursorOffset >= 0)
+         cursorPos = printableCharacterCount(result.left(cursorOffset));
+   }
+   if (cursorPos >= 0)
+      *outCursorPos = cursorPos;
 
-   while (true)
+   // the result is cached if evaluating the snippet again would produce the same result
+   if ((!outCancelled) && ComboManager::instance().comboListRef().dependencyGraph().hasStaticExpansion(this))
    {
-      QTextCursor cursor = remainingText.find(regexp);
-      if (cursor.isNull())
-      {
-         resultCursor.movePosition(QTextCursor::End);
-         resultCursor.insertHtml(remainingText.toHtml());
-         return this->useHtml() ? result.toHtml() : result.toPlainText();
-      }
-
-      // get the text of the variable
-      QString variable = cursor.selection().toPlainText();
-      variable = variable.mid(2, variable.size() - 3);
-
-      // delete the variable from the remaining text, copy the text before the variable to the result, and remove it from
-      // the remaining text
-      cursor.removeSelectedText();
-      cursor.movePosition(QTextCursor::Start, QTextCursor::KeepAnchor);
-      resultCursor.movePosition(QTextCursor::End);
-      resultCursor.insertHtml(cursor.selection().toHtml());
-      cursor.removeSelectedText();
-
-      if (outCursorPos && ("cursor" == variable))
-      {
-         if (outCursorPos)
-            *outCursorPos = printableCharacterCount(result.toPlainText());
-      }
-      else
-      {
-         resultCursor.movePosition(QTextCursor::End);
-         bool isHtml = false;
-         QString const eval = evaluateVariable(variable, forbiddenSubCombos, knownInputVariables, isHtml, outCancelled);
-         if (isHtml)
-            resultCursor.insertHtml(eval);
-         else 
-            resultCursor.insertText(eval);
-         if (outCancelled)
-            return QString();
-      }
+      cache.isValid = true;
+      cache.text = result;
+      cache.cursorPos = cursorPos;
    }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \return The keywords of the combos referenced by the snippet, without duplicates
+//**********************************************************************************************************************
+QStringList Combo::referencedKeywords() const
+{
+   return this->snippetTemplate()->referencedKeywords();
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if the snippet contains variables whose value can change between evaluations
+//**********************************************************************************************************************
+bool Combo::hasVolatileVariables() const
+{
+   return this->snippetTemplate()->hasVolatileVariables();
+}
+
+
+//**********************************************************************************************************************
+/// The cached evaluated snippet must be discarded when the snippet of the combo, or of any combo it references,
+/// directly or not, is modified.
+//**********************************************************************************************************************
+void Combo::invalidateEvaluatedSnippet() const
+{
+   cachedSnippet_ = CachedSnippet();
+   cachedSubSnippet_ = CachedSnippet();
 }
@@ -11,6 +11,8 @@
 #define BEEFTEXT_COMBO_H
 
 
+#include "SnippetTemplate.h"
+#include "EvaluationContext.h"
 #include "Group/GroupList.h"
 #include <memory>
 #include <vector>
@@ -54,12 +56,15 @@ public: // member functions
    QDateTime lastUseDateTime() const; ///< Retrieve the last use date/time of the combo.
    SpGroup group() const; ///< Get the combo group the combo belongs to
    void setGroup(SpGroup const& group); ///< Set the group this combo belongs to
-   QString evaluatedSnippet(bool& outCancelled, const QSet<QString>& forbiddenSubCombos, 
-      QMap<QString, QString>& knownInputVariables, qint32* outCursorPos) const; ///< Retrieve the the snippet after having evaluated it
+   QString evaluatedSnippet(bool& outCancelled, EvaluationContext& context, 
+      qint32* outCursorPos) const; ///< Retrieve the the snippet after having evaluated it
+   QStringList referencedKeywords() const; ///< Return the keywords of the combos referenced by the snippet
+   bool hasVolatileVariables() const; ///< Check whether the snippet contains variables whose value can change between evaluations
+   void invalidateEvaluatedSnippet() const; ///< Discard the cached evaluated snippet
    void setEnabled(bool enabled); ///< Set the combo as enabled or not
    bool isEnabled() const; ///< Check whether the combo is enabled
    bool matchesForInput(QString const& input) const; ///< Check if the combo is a match for the given input
-   bool performSubstitution(); ///< Perform the combo substitution
+   bool performSubstitution(qint32 typedLength); ///< Perform the combo substitution
    bool insertSnippet(); ///< Insert the snippet.
    QJsonObject toJsonObject(bool includeGroup) const; ///< Serialize the combo in a JSon object
    void changeUuid(); ///< Get a new Uuid for the combo
@@ -71,8 +76,17 @@ public: // static functions
       GroupList const& groups = GroupList()); ///< create a Combo from a JSON object
    static SpCombo duplicate(Combo const& combo); ///< Duplicate
 
+private: // data types
+   struct CachedSnippet
+   {
+      bool isValid { false }; ///< Is the cached snippet valid
+      QString text; ///< The evaluated snippet
+      qint32 cursorPos { -1 }; ///< The position of the cursor in the evaluated snippet, or -1 if there is no cursor
+   }; ///< A cached evaluated snippet
+
 private: // member functions
    void touch(); ///< set the modification date/time to now
+   SpSnippetTemplate snippetTemplate() const; ///< Return the compiled snippet, compiling it if necessary
 
 private: // data member
    QUuid uuid_; ///< The UUID of the combo
@@ -80,6 +94,9 @@ private: // data member
    QString keyword_; ///< The keyword
    QString snippet_; ///< The snippet
    bool useHtml_ { false }; ///< Does the combo use HTML?
+   mutable SpSnippetTemplate snippetTemplate_ { nullptr }; ///< The compiled snippet, or null if it has not been compiled since the snippet was last modified
+   mutable CachedSnippet cachedSnippet_; ///< The cached evaluated snippet, used for substitutions
+   mutable CachedSnippet cachedSubSnippet_; ///< The cached evaluated snippet, used when the combo is referenced by another combo
    bool useLooseMatching_ { false }; ///< Should the combo use loose matching
    SpGroup group_ { nullptr }; ///< The combo group this combo belongs to (may be null)
    QDateTime creationDateTime_; ///< The date/time of creation of the combo
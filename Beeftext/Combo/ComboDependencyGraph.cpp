@@ -0,0 +1,280 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the graph of the references between combos
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "ComboDependencyGraph.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void ComboDependencyGraph::clear()
+{
+   for (QHash<Combo const*, Node>::const_iterator it = nodes_.constBegin(); it != nodes_.constEnd(); ++it)
+      it.key()->invalidateEvaluatedSnippet();
+   nodes_.clear();
+   combosByKeyword_.clear();
+   dependents_.clear();
+   nextRank_ = 0;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] combo The combo
+//**********************************************************************************************************************
+void ComboDependencyGraph::insert(SpCombo const& combo)
+{
+   this->insertNode(combo, nextRank_++);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] combo The combo
+//**********************************************************************************************************************
+void ComboDependencyGraph::remove(SpCombo const& combo)
+{
+   quint64 rank = 0;
+   this->removeNode(combo, rank);
+}
+
+
+//**********************************************************************************************************************
+/// The combo keeps its rank, so references to its keyword still resolve to the same combo.
+///
+/// \param[in] combo The combo
+//**********************************************************************************************************************
+void ComboDependencyGraph::update(SpCombo const& combo)
+{
+   quint64 rank = 0;
+   if (this->removeNode(combo, rank))
+      this->insertNode(combo, rank);
+}
+
+
+//**********************************************************************************************************************
+/// The new combo takes the rank of the combo it replaces.
+///
+/// \param[in] oldCombo The combo to replace
+/// \param[in] newCombo The new combo
+//**********************************************************************************************************************
+void ComboDependencyGraph::replace(SpCombo const& oldCombo, SpCombo const& newCombo)
+{
+   quint64 rank = 0;
+   this->insertNode(newCombo, this->removeNode(oldCombo, rank) ? rank : nextRank_++);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyword The keyword
+/// \return The combo that a reference to the keyword resolves to
+/// \return A null pointer if no combo has this keyword
+//**********************************************************************************************************************
+SpCombo ComboDependencyGraph::comboByKeyword(QString const& keyword) const
+{
+   QHash<QString, VecSpCombo>::const_iterator const it = combosByKeyword_.constFind(keyword);
+   return (combosByKeyword_.constEnd() == it) ? SpCombo() : it->front();
+}
+
+
+//**********************************************************************************************************************
+/// The references are followed breadth first, so the reported chain is one of the shortest.
+///
+/// \param[in] keyword The keyword of the combo
+/// \param[in] references The keywords of the combos referenced by the snippet of the combo
+/// \param[in] combo If not null, a combo of the graph that is ignored, usually the combo being edited, whose node may
+/// no longer reflect its keyword and snippet
+/// \return The chain of keywords leading from the combo back to itself, starting and ending with the keyword of the
+/// combo
+/// \return An empty list if the references of the combo do not lead back to it
+//**********************************************************************************************************************
+QStringList ComboDependencyGraph::findCycle(QString const& keyword, QStringList const& references,
+   Combo const* combo) const
+{
+   QHash<QString, QString> parents; // for each keyword reached, the keyword it was reached from
+   QStringList queue;
+   for (QString const& reference: references)
+      if (!parents.contains(reference))
+      {
+         parents.insert(reference, keyword);
+         queue.append(reference);
+      }
+
+   for (qint32 i = 0; i < queue.size(); ++i)
+   {
+      QString const current = queue[i];
+      if (current == keyword)
+      {
+         QStringList result;
+         QString k = current;
+         do
+         {
+            result.prepend(k);
+            k = parents.value(k);
+         } while (k != keyword);
+         result.prepend(keyword);
+         return result;
+      }
+      QHash<QString, VecSpCombo>::const_iterator const it = combosByKeyword_.constFind(current);
+      if (combosByKeyword_.constEnd() == it)
+         continue;
+      VecSpCombo::const_iterator const target = std::find_if(it->begin(), it->end(), [combo](SpCombo const& c)
+         -> bool { return c.get() != combo; });
+      if (it->end() == target)
+         continue;
+      QHash<Combo const*, Node>::const_iterator const node = nodes_.constFind(target->get());
+      Q_ASSERT(nodes_.constEnd() != node);
+      for (QString const& reference: node->references)
+         if (!parents.contains(reference))
+         {
+            parents.insert(reference, current);
+            queue.append(reference);
+         }
+   }
+   return QStringList();
+}
+
+
+//**********************************************************************************************************************
+/// The evaluation of a combo always produces the same result if neither its snippet nor the snippets of the combos it
+/// references, directly or not, contain volatile variables. A combo whose references lead to a cycle is not
+/// considered static, as the result of its evaluation then depends on the combos that are being expanded.
+///
+/// \param[in] combo The combo
+/// \return true if and only if the combo is in the graph and its evaluation always produces the same result
+//**********************************************************************************************************************
+bool ComboDependencyGraph::hasStaticExpansion(Combo const* combo) const
+{
+   QHash<Combo const*, Node>::const_iterator const root = nodes_.constFind(combo);
+   if ((nodes_.constEnd() == root) || root->isVolatile)
+      return false;
+   QHash<Combo const*, bool> visited; // for each visited combo, is it on the current path
+   // the nodes on the current path, with the index of the next reference to follow
+   std::vector<std::pair<QHash<Combo const*, Node>::const_iterator, qint32>> path;
+   visited.insert(combo, true);
+   path.emplace_back(root, 0);
+   while (!path.empty())
+   {
+      QHash<Combo const*, Node>::const_iterator const node = path.back().first;
+      qint32 const index = path.back().second++;
+      if (index >= node->references.size())
+      {
+         visited[node.key()] = false;
+         path.pop_back();
+         continue;
+      }
+      SpCombo const target = this->comboByKeyword(node->references[index]);
+      if (!target)
+         continue; // the variable evaluates to itself
+      QHash<Combo const*, bool>::const_iterator const visitedIt = visited.constFind(target.get());
+      if (visited.constEnd() != visitedIt)
+      {
+         if (visitedIt.value())
+            return false; // the combo is on the current path, this is a cycle
+         continue;
+      }
+      QHash<Combo const*, Node>::const_iterator const targetNode = nodes_.constFind(target.get());
+      Q_ASSERT(nodes_.constEnd() != targetNode);
+      if (targetNode->isVolatile)
+         return false;
+      visited.insert(target.get(), true);
+      path.emplace_back(targetNode, 0);
+   }
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] combo The combo
+/// \param[in] rank The rank of the combo in the combo list
+//**********************************************************************************************************************
+void ComboDependencyGraph::insertNode(SpCombo const& combo, quint64 rank)
+{
+   if ((!combo) || nodes_.contains(combo.get()))
+      return;
+   Node node;
+   node.keyword = combo->keyword();
+   node.references = combo->referencedKeywords();
+   node.isVolatile = combo->hasVolatileVariables();
+   node.rank = rank;
+   VecSpCombo& combos = combosByKeyword_[node.keyword];
+   combos.insert(std::lower_bound(combos.begin(), combos.end(), rank, [&](SpCombo const& c, quint64 r) -> bool
+      { return nodes_.value(c.get()).rank < r; }), combo);
+   for (QString const& reference: node.references)
+      dependents_[reference].insert(combo.get());
+   nodes_.insert(combo.get(), node);
+   combo->invalidateEvaluatedSnippet();
+   this->invalidateDependents(node.keyword); // references to the keyword may now resolve to this combo
+}
+
+
+//**********************************************************************************************************************
+/// The combo is found using the keyword it was inserted with, so the function can be called after the keyword of the
+/// combo has been modified.
+///
+/// \param[in] combo The combo
+/// \param[out] outRank If the function returns true, the rank of the combo
+/// \return true if and only if the combo was in the graph
+//**********************************************************************************************************************
+bool ComboDependencyGraph::removeNode(SpCombo const& combo, quint64& outRank)
+{
+   if (!combo)
+      return false;
+   QHash<Combo const*, Node>::iterator const it = nodes_.find(combo.get());
+   if (nodes_.end() == it)
+      return false;
+   outRank = it->rank;
+   QHash<QString, VecSpCombo>::iterator const keywordIt = combosByKeyword_.find(it->keyword);
+   Q_ASSERT(combosByKeyword_.end() != keywordIt);
+   VecSpCombo& combos = keywordIt.value();
+   combos.erase(std::remove(combos.begin(), combos.end(), combo), combos.end());
+   if (combos.empty())
+      combosByKeyword_.erase(keywordIt);
+   for (QString const& reference: it->references)
+   {
+      QHash<QString, QSet<Combo const*>>::iterator const dependentsIt = dependents_.find(reference);
+      Q_ASSERT(dependents_.end() != dependentsIt);
+      dependentsIt->remove(combo.get());
+      if (dependentsIt->isEmpty())
+         dependents_.erase(dependentsIt);
+   }
+   QString const keyword = it->keyword;
+   nodes_.erase(it);
+   combo->invalidateEvaluatedSnippet();
+   this->invalidateDependents(keyword); // references to the keyword may now resolve to another combo
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyword The keyword
+//**********************************************************************************************************************
+void ComboDependencyGraph::invalidateDependents(QString const& keyword) const
+{
+   QSet<QString> visited { keyword };
+   QStringList queue { keyword };
+   for (qint32 i = 0; i < queue.size(); ++i)
+   {
+      QHash<QString, QSet<Combo const*>>::const_iterator const it = dependents_.constFind(queue[i]);
+      if (dependents_.constEnd() == it)
+         continue;
+      for (Combo const* dependent: *it)
+      {
+         dependent->invalidateEvaluatedSnippet();
+         QString const& dependentKeyword = nodes_.constFind(dependent)->keyword;
+         if (!visited.contains(dependentKeyword))
+         {
+            visited.insert(dependentKeyword);
+            queue.append(dependentKeyword);
+         }
+      }
+   }
+}
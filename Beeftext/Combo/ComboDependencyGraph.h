@@ -0,0 +1,70 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the graph of the references between combos
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_COMBO_DEPENDENCY_GRAPH_H
+#define BEEFTEXT_COMBO_DEPENDENCY_GRAPH_H
+
+
+#include "Combo.h"
+
+
+//**********************************************************************************************************************
+/// \brief The graph of the references between the combos of a list
+///
+/// Each combo of the list is a node, and each #{combo:}, #{upper:}, #{lower:} or #{trim:} variable in its snippet is
+/// an edge to the combo it references. Combos are indexed by keyword, so that resolving a reference does not require
+/// walking the combo list. When several combos share a keyword, a reference resolves to the one that comes first in
+/// the combo list: each node keeps the rank of its combo in the list, which is preserved when the combo is updated or
+/// replaced. The graph must be notified of every change to the keyword or snippet of a combo.
+///
+/// The graph also keeps the cached evaluated snippets of the combos up to date: when a combo is inserted or removed,
+/// the cache of every combo that references its keyword, directly or not, is invalidated.
+//**********************************************************************************************************************
+class ComboDependencyGraph
+{
+public: // member functions
+   ComboDependencyGraph() = default; ///< Default constructor
+   ComboDependencyGraph(ComboDependencyGraph const&) = default; ///< Default copy constructor
+   ComboDependencyGraph(ComboDependencyGraph&&) = default; ///< Default move constructor
+   ~ComboDependencyGraph() = default; ///< Default destructor
+   ComboDependencyGraph& operator=(ComboDependencyGraph const&) = default; ///< Default assignment operator
+   ComboDependencyGraph& operator=(ComboDependencyGraph&&) = default; ///< Default move assignment operator
+   void clear(); ///< Remove all the combos from the graph
+   void insert(SpCombo const& combo); ///< Insert a combo in the graph, after all the other combos
+   void remove(SpCombo const& combo); ///< Remove a combo from the graph
+   void update(SpCombo const& combo); ///< Update the node of a combo whose keyword or snippet may have changed
+   void replace(SpCombo const& oldCombo, SpCombo const& newCombo); ///< Replace a combo of the graph by another one
+   SpCombo comboByKeyword(QString const& keyword) const; ///< Return the combo a reference to a keyword resolves to
+   QStringList findCycle(QString const& keyword, QStringList const& references,
+      Combo const* combo = nullptr) const; ///< Find a chain of references leading from a combo back to itself
+   bool hasStaticExpansion(Combo const* combo) const; ///< Check whether evaluating a combo always produces the same result
+
+private: // data types
+   struct Node
+   {
+      QString keyword; ///< The keyword the combo was inserted with
+      QStringList references; ///< The keywords of the combos referenced by the combo
+      bool isVolatile { false }; ///< Does the snippet of the combo contain volatile variables
+      quint64 rank { 0 }; ///< The rank of the combo in the combo list
+   }; ///< A node of the graph
+
+private: // member functions
+   void insertNode(SpCombo const& combo, quint64 rank); ///< Insert the node of a combo with a given rank
+   bool removeNode(SpCombo const& combo, quint64& outRank); ///< Remove the node of a combo
+   void invalidateDependents(QString const& keyword) const; ///< Invalidate the cache of the combos referencing a keyword
+
+private: // data members
+   QHash<Combo const*, Node> nodes_; ///< The nodes of the graph, indexed by combo
+   QHash<QString, VecSpCombo> combosByKeyword_; ///< The combos in the graph, indexed by keyword, sorted by rank
+   quint64 nextRank_ { 0 }; ///< The rank given to the next inserted combo
+   QHash<QString, QSet<Combo const*>> dependents_; ///< The combos referencing each keyword
+};
+
+
+#endif // #ifndef BEEFTEXT_COMBO_DEPENDENCY_GRAPH_H
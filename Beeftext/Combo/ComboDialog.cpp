@@ -111,9 +111,21 @@ bool ComboDialog::checkAndReportInvalidCombo()
       return false;
    }
 
-   // we check that the keyword is not already in use
-   QString const newKeyword = ui_.editKeyword->text();
+   // we check that the snippet does not reference itself, directly or through other combos
+   QString const newKeyword = ui_.editKeyword->text().trimmed();
    ComboList const& comboList = ComboManager::instance().comboListRef();
+   bool const useHtml = this->useHtmlComboValue();
+   QStringList const cycle = comboList.dependencyGraph().findCycle(newKeyword, 
+      SnippetTemplate(useHtml ? ui_.comboEditor->html() : ui_.comboEditor->plainText(), useHtml).referencedKeywords(),
+      combo_.get());
+   if (!cycle.isEmpty())
+   {
+      QMessageBox::critical(this, tr("Error"), tr("The snippet references itself through the following chain of "
+         "combos, which would cause an endless recursion:\n\n%1").arg(cycle.join(" -> ")));
+      return false;
+   }
+
+   // we check that the keyword is not already in use
    if (comboList.end() != std::find_if(comboList.begin(), comboList.end(), [&](SpCombo const& existing) -> bool
       { return (existing != combo_) && (existing->keyword() == newKeyword);}))
       return 0 == QMessageBox::information(this, tr("Duplicate keyword"), tr("This keyword is already in use. \n\n"
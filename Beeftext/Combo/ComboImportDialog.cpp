@@ -203,7 +203,7 @@ void ComboImportDialog::performFinalImport(qint32& outFailureCount)
          continue;
       }
       combo->setGroup(group);
-      *it = combo;
+      comboList.replace(qint32(it - comboList.begin()), combo);
    }
 }
 
@@ -41,6 +41,10 @@ void swap(ComboList& first, ComboList& second) noexcept
 {
    first.combos_.swap(second.combos_);
    swap(first.groups_, second.groups_);
+   std::swap(first.keywordIndex_, second.keywordIndex_);
+   first.keywordIds_.swap(second.keywordIds_);
+   first.indexedCombos_.swap(second.indexedCombos_);
+   std::swap(first.dependencyGraph_, second.dependencyGraph_);
 }
 
 
@@ -59,7 +63,11 @@ ComboList::ComboList(QObject* parent)
 ComboList::ComboList(ComboList const& ref)
    : QAbstractTableModel(ref.parent()),
      combos_(ref.combos_),
-     groups_(ref.groups_)
+     groups_(ref.groups_),
+     keywordIndex_(ref.keywordIndex_),
+     keywordIds_(ref.keywordIds_),
+     indexedCombos_(ref.indexedCombos_),
+     dependencyGraph_(ref.dependencyGraph_)
 {
 }
 
@@ -70,7 +78,11 @@ ComboList::ComboList(ComboList const& ref)
 ComboList::ComboList(ComboList&& ref) noexcept
    : QAbstractTableModel(ref.parent()),
      combos_(std::move(ref.combos_)),
-     groups_(std::move(ref.groups_))
+     groups_(std::move(ref.groups_)),
+     keywordIndex_(std::move(ref.keywordIndex_)),
+     keywordIds_(std::move(ref.keywordIds_)),
+     indexedCombos_(std::move(ref.indexedCombos_)),
+     dependencyGraph_(std::move(ref.dependencyGraph_))
 {
 }
 
@@ -84,6 +96,10 @@ ComboList& ComboList::operator=(ComboList const& ref)
    {
       combos_ = ref.combos_;
       groups_ = ref.groups_;
+      keywordIndex_ = ref.keywordIndex_;
+      keywordIds_ = ref.keywordIds_;
+      indexedCombos_ = ref.indexedCombos_;
+      dependencyGraph_ = ref.dependencyGraph_;
    }
    return *this;
 }
@@ -98,6 +114,10 @@ ComboList& ComboList::operator=(ComboList&& ref) noexcept
    {
       combos_ = std::move(ref.combos_);
       groups_ = std::move(ref.groups_);
+      keywordIndex_ = std::move(ref.keywordIndex_);
+      keywordIds_ = std::move(ref.keywordIds_);
+      indexedCombos_ = std::move(ref.indexedCombos_);
+      dependencyGraph_ = std::move(ref.dependencyGraph_);
    }
    return *this;
 }
@@ -147,6 +167,8 @@ void ComboList::clear()
    this->beginResetModel();
    combos_.clear();
    groups_.clear();
+   this->clearKeywordIndex();
+   dependencyGraph_.clear();
    this->endResetModel();
 }
 
@@ -193,6 +215,8 @@ bool ComboList::append(SpCombo const& combo)
    }
    this->beginInsertRows(QModelIndex(), combos_.size(), combos_.size());
    combos_.push_back(combo);
+   this->addToKeywordIndex(combo);
+   dependencyGraph_.insert(combo);
    this->endInsertRows();
    return true;
 }
@@ -208,6 +232,8 @@ void ComboList::push_back(SpCombo const& combo)
 {
    this->beginInsertRows(QModelIndex(), combos_.size(), combos_.size());
    combos_.push_back(combo);
+   this->addToKeywordIndex(combo);
+   dependencyGraph_.insert(combo);
    this->endInsertRows();
 }
 
@@ -218,11 +244,28 @@ void ComboList::push_back(SpCombo const& combo)
 void ComboList::erase(qint32 index)
 {
    this->beginRemoveRows(QModelIndex(), index, index);
+   this->removeFromKeywordIndex(combos_[index]);
+   dependencyGraph_.remove(combos_[index]);
    combos_.erase(combos_.begin() + index);
    this->endRemoveRows();
 }
 
 
+//**********************************************************************************************************************
+/// \param[in] index The index of the combo to replace
+/// \param[in] combo The new combo
+//**********************************************************************************************************************
+void ComboList::replace(qint32 index, SpCombo const& combo)
+{
+   Q_ASSERT((index >= 0) && (index < qint32(combos_.size())));
+   this->removeFromKeywordIndex(combos_[index]);
+   dependencyGraph_.replace(combos_[index], combo);
+   combos_[index] = combo;
+   this->addToKeywordIndex(combo);
+   emit dataChanged(this->index(index, 0), this->index(index, this->columnCount(QModelIndex()) - 1));
+}
+
+
 //**********************************************************************************************************************
 /// \param[in] group The group
 //**********************************************************************************************************************
@@ -581,11 +624,21 @@ bool ComboList::exportCheatSheet(QString const& path, QString* outErrorMessage)
 
 
 //**********************************************************************************************************************
-// 
+/// The keyword index is only updated if the keyword, matching mode or enabled state of the combo changed, as every
+/// update of the index changes its revision, and forces the matches found in the meantime to be looked up again.
+///
+/// \param[in] index The index of the combo in the list
 //**********************************************************************************************************************
 void ComboList::markComboAsEdited(qint32 index)
 {
    Q_ASSERT((index >= 0) && (index < qint32(combos_.size())));
+   SpCombo const& combo = combos_[index];
+   if (!this->isUpToDateInKeywordIndex(combo))
+   {
+      this->removeFromKeywordIndex(combo);
+      this->addToKeywordIndex(combo);
+   }
+   dependencyGraph_.update(combo); // the keyword or snippet may have changed
    emit dataChanged(this->index(0, 0), this->index(0, this->rowCount(QModelIndex()) - 1),
       QVector<int>() << Qt::DisplayRole);
 }
@@ -623,6 +676,130 @@ bool ComboList::containsHtmlCombo() const
 }
 
 
+//**********************************************************************************************************************
+/// Matching combos are looked up in the keyword index, so the cost of the function does not depend on the number of
+/// combos in the list.
+///
+/// \param[in] input The input
+/// \param[out] outResult The enabled combos matching the input
+//**********************************************************************************************************************
+void ComboList::findMatchingCombos(QString const& input, VecSpCombo& outResult) const
+{
+   this->findMatchingCombos(input.constData(), input.size(), false, outResult);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] input The input characters
+/// \param[in] length The number of characters in the input
+/// \param[in] inputIsTruncated If true, the input is only the end of the text to match, and strict matches are not
+/// reported
+/// \param[out] outResult The enabled combos matching the input
+//**********************************************************************************************************************
+void ComboList::findMatchingCombos(QChar const* input, qint32 length, bool inputIsTruncated,
+   VecSpCombo& outResult) const
+{
+   outResult.clear();
+   QVector<qint32> ids;
+   keywordIndex_.findMatches(input, length, inputIsTruncated, ids);
+   for (qint32 const id: ids)
+      outResult.push_back(indexedCombos_[id]);
+}
+
+
+//**********************************************************************************************************************
+/// \return The index of the keywords of the enabled combos
+//**********************************************************************************************************************
+KeywordIndex const& ComboList::keywordIndex() const
+{
+   return keywordIndex_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] id The keyword ID
+/// \return The combo with the given keyword ID
+/// \return A null pointer if no combo has the given keyword ID
+//**********************************************************************************************************************
+SpCombo ComboList::comboByKeywordId(qint32 id) const
+{
+   return ((id >= 0) && (id < qint32(indexedCombos_.size()))) ? indexedCombos_[id] : SpCombo();
+}
+
+
+//**********************************************************************************************************************
+/// \return The graph of the references between the combos of the list
+//**********************************************************************************************************************
+ComboDependencyGraph const& ComboList::dependencyGraph() const
+{
+   return dependencyGraph_;
+}
+
+
+//**********************************************************************************************************************
+/// Disabled combos and combos with an empty keyword are not indexed.
+///
+/// \param[in] combo The combo
+//**********************************************************************************************************************
+void ComboList::addToKeywordIndex(SpCombo const& combo)
+{
+   if ((!combo) || (!combo->isEnabled()) || keywordIds_.contains(combo.get()))
+      return;
+   qint32 const id = keywordIndex_.insert(combo->keyword(), combo->useLooseMatching());
+   if (id < 0)
+      return;
+   keywordIds_.insert(combo.get(), id);
+   if (qint32(indexedCombos_.size()) < keywordIndex_.idCapacity())
+      indexedCombos_.resize(keywordIndex_.idCapacity());
+   indexedCombos_[id] = combo;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] combo The combo
+//**********************************************************************************************************************
+void ComboList::removeFromKeywordIndex(SpCombo const& combo)
+{
+   if (!combo)
+      return;
+   QHash<Combo const*, qint32>::iterator const it = keywordIds_.find(combo.get());
+   if (it == keywordIds_.end())
+      return;
+   qint32 const id = it.value();
+   keywordIndex_.remove(id);
+   indexedCombos_[id].reset();
+   keywordIds_.erase(it);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void ComboList::clearKeywordIndex()
+{
+   keywordIndex_.clear();
+   keywordIds_.clear();
+   indexedCombos_.clear();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] combo The combo
+/// \return true if and only if the keyword index contains the combo with its current keyword and matching mode, or
+/// does not contain it and the combo must not be indexed
+//**********************************************************************************************************************
+bool ComboList::isUpToDateInKeywordIndex(SpCombo const& combo) const
+{
+   if (!combo)
+      return true;
+   QHash<Combo const*, qint32>::const_iterator const it = keywordIds_.constFind(combo.get());
+   if (keywordIds_.constEnd() == it)
+      return (!combo->isEnabled()) || combo->keyword().isEmpty();
+   return combo->isEnabled() && (keywordIndex_.keyword(it.value()) == combo->keyword()) &&
+      (keywordIndex_.isLooseMatching(it.value()) == combo->useLooseMatching());
+}
+
+
 //**********************************************************************************************************************
 /// \return The number of rows in the table model
 //**********************************************************************************************************************
@@ -12,6 +12,8 @@
 
 
 #include "Combo.h"
+#include "KeywordIndex.h"
+#include "ComboDependencyGraph.h"
 #include "Group/GroupList.h"
 
 
@@ -65,6 +67,7 @@ public: // member functions
    // ReSharper disable once CppInconsistentNaming
    void push_back(SpCombo const& combo); ///< Append a combo at the end of the list
    void erase(qint32 index); ///< Erase a combo from the list
+   void replace(qint32 index, SpCombo const& combo); ///< Replace the combo at a given position in the list
    void eraseCombosOfGroup(SpGroup const& group); ///< Erase all the combos of a given group
    const_iterator findByKeyword(QString const& keyword) const; ///< Find a combo by its keyword
    iterator findByKeyword(QString const& keyword); ///< Find a combo by its keyword
@@ -90,6 +93,11 @@ public: // member functions
    void markComboAsEdited(qint32 index); ///< Mark a combo as edited
    void ensureCorrectGrouping(bool *outWasInvalid = nullptr); ///< make sure every combo is affected to a group (and that there is at least one group
    bool containsHtmlCombo() const; ///< Check whether the combo list contain at least one HTML combo.
+   void findMatchingCombos(QString const& input, VecSpCombo& outResult) const; ///< Retrieve the enabled combos matching an input
+   void findMatchingCombos(QChar const* input, qint32 length, bool inputIsTruncated, VecSpCombo& outResult) const; ///< Retrieve the enabled combos matching an input
+   KeywordIndex const& keywordIndex() const; ///< Return the index of the keywords of the enabled combos
+   SpCombo comboByKeywordId(qint32 id) const; ///< Return the combo with a given keyword ID
+   ComboDependencyGraph const& dependencyGraph() const; ///< Return the graph of the references between the combos
    
    /// \name Table model member functions
    ///\{
@@ -104,9 +112,19 @@ public: // member functions
    //bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent); ///< process the dropping of MIME data
                                                                                                                     ///\}
 
+private: // member functions
+   void addToKeywordIndex(SpCombo const& combo); ///< Add a combo to the keyword index
+   void removeFromKeywordIndex(SpCombo const& combo); ///< Remove a combo from the keyword index
+   void clearKeywordIndex(); ///< Clear the keyword index
+   bool isUpToDateInKeywordIndex(SpCombo const& combo) const; ///< Check whether the keyword index reflects the current state of a combo
+
 private: // data members
    VecSpCombo combos_; ///< The list of combos
    GroupList groups_; ///< The list of groups
+   KeywordIndex keywordIndex_; ///< The index of the keywords of the enabled combos
+   QHash<Combo const*, qint32> keywordIds_; ///< The keyword ID of each indexed combo
+   VecSpCombo indexedCombos_; ///< The indexed combos, by keyword ID
+   ComboDependencyGraph dependencyGraph_; ///< The graph of the references between the combos
 };
 
 
@@ -16,12 +16,17 @@
 #include "BeeftextGlobals.h"
 #include "Backup/BackupManager.h"
 #include "EmojiManager.h"
+#include "LatencyMonitor.h"
+#include "ForegroundContextService.h"
 
 
 using namespace xmilib;
 
 
 bool isBeeftextTheForegroundApplication(); ///< Check whether Beeftext is the foreground application
+qint32 groupPriority(GroupList const& groups, SpGroup const& group); ///< Return the priority of a group
+bool isPreferredMatch(Combo const& candidate, Combo const& best, EMatchResolutionPolicy policy, 
+   GroupList const& groups); ///< Check whether a matching combo is preferred to another one
 
 
 //**********************************************************************************************************************
@@ -29,9 +34,63 @@ bool isBeeftextTheForegroundApplication(); ///< Check whether Beeftext is the fo
 //**********************************************************************************************************************
 bool isBeeftextTheForegroundApplication()
 {
-   DWORD processId = 0;
-   GetWindowThreadProcessId(GetForegroundWindow(), &processId);
-   return QCoreApplication::applicationPid() == processId;
+   return ForegroundContextService::instance().context().isBeeftext;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] groups The group list
+/// \param[in] group The group
+/// \return The priority of the group, which is its index in the group list. Lower values have higher priority, and
+/// combos that do not belong to a group come last
+//**********************************************************************************************************************
+qint32 groupPriority(GroupList const& groups, SpGroup const& group)
+{
+   if (!group)
+      return groups.size();
+   for (qint32 i = 0; i < groups.size(); ++i)
+      if (groups[i] == group)
+         return i;
+   return groups.size();
+}
+
+
+//**********************************************************************************************************************
+/// Ties are broken by keyword length, and if the keywords have the same length, the candidate is not preferred, so
+/// that the first combo reported by the matcher wins.
+///
+/// \param[in] candidate The candidate combo
+/// \param[in] best The best combo found so far
+/// \param[in] policy The match resolution policy. Must not be RandomResolution
+/// \param[in] groups The group list
+/// \return true if and only if the candidate is preferred to the best combo found so far
+//**********************************************************************************************************************
+bool isPreferredMatch(Combo const& candidate, Combo const& best, EMatchResolutionPolicy policy, 
+   GroupList const& groups)
+{
+   switch (policy)
+   {
+   case MostRecentlyUsedResolution:
+   {
+      QDateTime const candidateDateTime = candidate.lastUseDateTime();
+      QDateTime const bestDateTime = best.lastUseDateTime();
+      if (candidateDateTime != bestDateTime)
+         return candidateDateTime.isValid() && ((!bestDateTime.isValid()) || (candidateDateTime > bestDateTime));
+      break;
+   }
+   case GroupPriorityResolution:
+   {
+      qint32 const candidatePriority = groupPriority(groups, candidate.group());
+      qint32 const bestPriority = groupPriority(groups, best.group());
+      if (candidatePriority != bestPriority)
+         return candidatePriority < bestPriority;
+      break;
+   }
+   case LongestKeywordResolution:
+   default:
+      break;
+   }
+   return candidate.keyword().size() > best.keyword().size();
 }
 
 
@@ -67,17 +126,25 @@ ComboList const& ComboManager::comboListRef() const
 // 
 //**********************************************************************************************************************
 ComboManager::ComboManager()
+   : matchingWorker_(std::make_unique<MatchingWorker>(InputManager::instance().keystrokeQueue()))
 {
-   // We used queued connections to minimize the time spent in the keyboard hook
-   InputManager& inputManager = InputManager::instance();
-   connect(&inputManager, &InputManager::comboBreakerTyped, this, &ComboManager::onComboBreakerTyped,
+   // keystrokes are processed on the matching thread, so that matching is not delayed when the GUI thread is busy.
+   // Only the confirmed matches are sent back to the GUI thread, which performs the substitutions
+   connect(matchingWorker_.get(), &MatchingWorker::comboMatched, this, &ComboManager::onComboMatched,
       Qt::QueuedConnection);
-   connect(&inputManager, &InputManager::characterTyped, this, &ComboManager::onCharacterTyped,
+   connect(matchingWorker_.get(), &MatchingWorker::emojiShortcodeTyped, this, &ComboManager::onEmojiShortcodeTyped,
       Qt::QueuedConnection);
-   connect(&inputManager, &InputManager::backspaceTyped, this, &ComboManager::onBackspaceTyped,
-      Qt::QueuedConnection);
-   connect(&inputManager, &InputManager::substitutionShortcutTriggered, this,
-      &ComboManager::onSubstitutionTriggerShortcut, Qt::QueuedConnection);
+   matchingWorker_->moveToThread(&matchingThread_);
+   connect(&matchingThread_, &QThread::started, matchingWorker_.get(), &MatchingWorker::run);
+   connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &ComboManager::stopMatchingThread);
+   connect(&PreferencesManager::instance(), &PreferencesManager::substitutionPreferencesChanged, this,
+      &ComboManager::updateMatchingSettings);
+   connect(&comboList_, &ComboList::rowsInserted, this, &ComboManager::scheduleKeywordSnapshotUpdate);
+   connect(&comboList_, &ComboList::rowsRemoved, this, &ComboManager::scheduleKeywordSnapshotUpdate);
+   connect(&comboList_, &ComboList::dataChanged, this, &ComboManager::scheduleKeywordSnapshotUpdate);
+   connect(&comboList_, &ComboList::modelReset, this, &ComboManager::scheduleKeywordSnapshotUpdate);
+   this->updateMatchingSettings(); // also publishes the keyword snapshot
+   matchingThread_.start();
    QString errMsg;
 
    if (!QFileInfo(QDir(PreferencesManager::instance().comboListFolderPath())
@@ -92,6 +159,15 @@ ComboManager::ComboManager()
 }
 
 
+//**********************************************************************************************************************
+// 
+//**********************************************************************************************************************
+ComboManager::~ComboManager()
+{
+   this->stopMatchingThread();
+}
+
+
 //**********************************************************************************************************************
 /// \return A reference to the combo group attached to the combo list
 //**********************************************************************************************************************
@@ -135,6 +211,7 @@ bool ComboManager::loadComboListFromFile(QString* outErrorMsg)
             "The combo list file was successfully saved after fixing the the grouping of combos.");
    }
    loadLastUseDateTimes(comboList_);
+   this->updateKeywordSnapshot();
    emit comboListWasLoaded();
    return true;
 }
@@ -169,6 +246,7 @@ bool ComboManager::restoreBackup(QString const& backupFilePath)
    if (!comboList_.load(backupFilePath, &inOlderFormat, &outErrorMsg))
       return false;
    comboList_.ensureCorrectGrouping();
+   this->updateKeywordSnapshot();
    emit backupWasRestored();
    return this->saveComboListToFile();
 }
@@ -200,116 +278,230 @@ void ComboManager::playSound() const
 
 
 //**********************************************************************************************************************
-//
+/// \return The strategy used to find the combos matching the typed text
 //**********************************************************************************************************************
-void ComboManager::checkAndPerformSubstitution()
+KeywordMatcher::EMatchingMode ComboManager::matchingMode() const
 {
-   if (!this->checkAndPerformComboSubstitution())
-      this->checkAndPerformEmojiSubstitution();
+   return matchingSettings_.matchingMode;
 }
 
 
 //**********************************************************************************************************************
-/// \return true if a substitution was available and it was performed or cancelled because Beeftext is the active 
-/// application.
+/// \param[in] mode The strategy used to find the combos matching the typed text
 //**********************************************************************************************************************
-bool ComboManager::checkAndPerformComboSubstitution()
+void ComboManager::setMatchingMode(KeywordMatcher::EMatchingMode mode)
 {
-   VecSpCombo result;
-   for (SpCombo const& combo: comboList_)
-      if (combo && combo->isEnabled() && combo->matchesForInput(currentText_))
-         result.push_back(combo);
-
-   if (result.empty())
-      return false;
-
-   SpCombo const combo = result[result.size() > 1 ? rng_.get() % result.size() : 0];
-   if ((!isBeeftextTheForegroundApplication()) &&
-      (combo->performSubstitution() && PreferencesManager::instance().playSoundOnCombo()) && sound_)
-      sound_->play(); // in Beeftext windows, substitution is disabled
-   this->onComboBreakerTyped();
-   return true;
+   matchingSettings_.matchingMode = mode;
+   matchingWorker_->setSettings(matchingSettings_);
 }
 
 
 //**********************************************************************************************************************
-/// \return true if a substitution was available and it was performed or cancelled because Beeftext is the active 
-/// application.
+/// The typed text buffer of the matching thread is always large enough to hold the longest combo keyword. It must
+/// also be able to hold the longest emoji shortcode with its delimiters, so the function must be called again after
+/// the emojis are loaded. If the folding flags change, the keywords are folded again in a new snapshot, published
+/// with the settings.
 //**********************************************************************************************************************
-bool ComboManager::checkAndPerformEmojiSubstitution()
+void ComboManager::updateMatchingSettings()
 {
-   QString currentText = currentText_;
    PreferencesManager& prefs = PreferencesManager::instance();
-   if (!prefs.emojiShortcodesEnabled())
-      return false;
-   QString const leftDelimiter = prefs.emojiLeftDelimiter();
-   QString const rightDelimiter = prefs.emojiRightDelimiter();
+   keywordFolder_.setFlags((prefs.caseInsensitiveMatching() ? KeywordFolder::CaseFolding : 0) |
+      (prefs.normalizationInsensitiveMatching() ? KeywordFolder::NormalizationFolding : 0));
+   matchingSettings_.foldingFlags = keywordFolder_.flags();
+   matchingSettings_.automaticSubstitution = prefs.useAutomaticSubstitution();
+   matchingSettings_.emojiShortcodesEnabled = prefs.emojiShortcodesEnabled();
+   matchingSettings_.emojiLeftDelimiter = prefs.emojiLeftDelimiter();
+   matchingSettings_.emojiRightDelimiter = prefs.emojiRightDelimiter();
+   matchingSettings_.emojiMaxKeywordLength = EmojiManager::instance().maxKeywordLength();
+   matchingWorker_->setSettings(matchingSettings_);
+   this->updateKeywordSnapshot();
+}
 
-   // first we validate the right delimiter, if any
-   if (!currentText.endsWith(rightDelimiter))
-      return false;
-   currentText = currentText.chopped(rightDelimiter.size());
 
-   // we try to locate the left delimiter
-   qint32 const index = currentText.lastIndexOf(leftDelimiter);
-   if (-1 == index) // not found
-      return false;
+//**********************************************************************************************************************
+/// The keyword index of the combo list is updated incrementally as combos are added, edited, enabled or disabled,
+/// and its revision changes every time. A new snapshot is built from it and published to the matching thread.
+//**********************************************************************************************************************
+void ComboManager::updateKeywordSnapshot()
+{
+   KeywordIndex const& index = comboList_.keywordIndex();
+   if ((publishedRevision_ == index.revision()) && (publishedFoldingFlags_ == keywordFolder_.flags()))
+      return;
+   KeywordSnapshot snapshot;
+   snapshot.build(index, keywordFolder_);
+   publishedRevision_ = index.revision();
+   publishedFoldingFlags_ = keywordFolder_.flags();
+   matchingWorker_->setKeywordSnapshot(std::move(snapshot));
+}
 
-   // finally we isolate the keyword and perform the substitution, if any
-   QString const keyword = currentText.right(currentText.size() - (index + leftDelimiter.size()));
-   EmojiManager& emojisManager = EmojiManager::instance();
-   QString const emoji = emojisManager.emoji(keyword);
-   if (emoji.isEmpty())
-      return false;
-   bool result = false;
-   if ((!isBeeftextTheForegroundApplication()) &&
-      !EmojiManager::instance().isExcludedApplication(getActiveExecutableFileName()))
+
+//**********************************************************************************************************************
+/// The combo list can emit many change notifications in a row, for instance when it is loaded, so the update of the
+/// keyword snapshot is deferred until control returns to the event loop.
+//**********************************************************************************************************************
+void ComboManager::scheduleKeywordSnapshotUpdate()
+{
+   if (keywordSnapshotUpdateIsScheduled_)
+      return;
+   keywordSnapshotUpdateIsScheduled_ = true;
+   QTimer::singleShot(0, this, [this]()
    {
-      performTextSubstitution(keyword.size() + rightDelimiter.size() + leftDelimiter.size(), emoji, false, -1);
-      if (PreferencesManager::instance().playSoundOnCombo() && sound_)
-         sound_->play();
-      result = true;
-   }
-   this->onComboBreakerTyped();
-   return result;
+      keywordSnapshotUpdateIsScheduled_ = false;
+      this->updateKeywordSnapshot();
+   });
 }
 
 
 //**********************************************************************************************************************
-// 
+/// The typed text is owned by the matching thread. It is reset by sending a combo breaker through the keystroke
+/// queue, so that the reset is processed in order with the keystrokes.
 //**********************************************************************************************************************
-void ComboManager::onComboBreakerTyped()
+void ComboManager::resetTypedText()
 {
-   currentText_ = QString();
+   KeystrokeEvent event;
+   event.type = KeystrokeEvent::ComboBreaker;
+   InputManager::instance().keystrokeQueue().push(event);
 }
 
 
 //**********************************************************************************************************************
-/// \param[in] c The character that was typed
+//
 //**********************************************************************************************************************
-void ComboManager::onCharacterTyped(QChar c)
+void ComboManager::stopMatchingThread()
 {
-   currentText_.append(c);
-   if (!PreferencesManager::instance().useAutomaticSubstitution())
+   if (!matchingThread_.isRunning())
       return;
-   this->checkAndPerformSubstitution();
+   matchingWorker_->stop();
+   matchingThread_.quit();
+   matchingThread_.wait();
 }
 
 
 //**********************************************************************************************************************
-// 
+/// The matching thread has already reset the typed text. If the keyword index changed since the match was found, the
+/// IDs may be outdated, and the matching keywords are looked up again in the current index.
+///
+/// \param[in] keywordIds The IDs of the matching keywords in the keyword index of the combo list
+/// \param[in] keywords The matching keywords
+/// \param[in] typedLengths For each matching keyword, the number of UTF-16 characters the user typed for it
+/// \param[in] revision The revision of the keyword index the IDs refer to
 //**********************************************************************************************************************
-void ComboManager::onBackspaceTyped()
+void ComboManager::onComboMatched(QVector<qint32> const& keywordIds, QStringList const& keywords,
+   QVector<qint32> const& typedLengths, quint64 revision)
 {
-   currentText_.chop(1);
+   LatencyTimer const timer(ComboMatchedStage);
+   QVector<qint32> ids = keywordIds;
+   QVector<qint32> lengths = typedLengths;
+   if (revision != comboList_.keywordIndex().revision())
+   {
+      this->updateKeywordSnapshot();
+      this->findCurrentKeywordIds(keywords, typedLengths, ids, lengths);
+   }
+   qint32 index = -1;
+   SpCombo const combo = this->resolveMatch(ids, index);
+   if ((!combo) || isBeeftextTheForegroundApplication()) // in Beeftext windows, substitution is disabled
+      return;
+   if (!combo->performSubstitution(lengths.value(index, combo->keyword().size())))
+      return;
+   LatencyMonitor& monitor = LatencyMonitor::instance();
+   monitor.record(KeyStrokeToSubstitutionStage, LatencyMonitor::timestampNs() - monitor.lastKeyStrokeTimestampNs());
+   if (PreferencesManager::instance().playSoundOnCombo() && sound_)
+      sound_->play();
 }
 
 
 //**********************************************************************************************************************
-// 
+/// The combos are looked up directly from their keyword IDs in a single pass, without building a list of candidates.
+/// With the random policy, the combo is picked using reservoir sampling, so every matching combo has the same
+/// probability of being picked.
+///
+/// \param[in] keywordIds The IDs of the matching keywords in the keyword index of the combo list
+/// \param[out] outIndex The index in keywordIds of the ID of the returned combo, or -1 if the function returns a null
+/// pointer
+/// \return The combo to substitute
+/// \return A null pointer if none of the IDs refer to a combo
 //**********************************************************************************************************************
-void ComboManager::onSubstitutionTriggerShortcut()
+SpCombo ComboManager::resolveMatch(QVector<qint32> const& keywordIds, qint32& outIndex)
 {
-   if (!PreferencesManager::instance().useAutomaticSubstitution())
-      this->checkAndPerformSubstitution();
+   EMatchResolutionPolicy const policy = PreferencesManager::instance().matchResolutionPolicy();
+   GroupList const& groups = comboList_.groupListRef();
+   SpCombo result;
+   outIndex = -1;
+   quint32 count = 0;
+   for (qint32 i = 0; i < keywordIds.size(); ++i)
+   {
+      SpCombo combo = comboList_.comboByKeywordId(keywordIds[i]);
+      if (!combo)
+         continue;
+      ++count;
+      bool picked = false;
+      if (!result)
+         picked = true;
+      else if (RandomResolution == policy)
+         picked = (0 == rng_.get() % count);
+      else
+         picked = isPreferredMatch(*combo, *result, policy, groups);
+      if (picked)
+      {
+         result = std::move(combo);
+         outIndex = i;
+      }
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// A keyword is found again if an enabled combo still has exactly this keyword, even if it is not the combo that
+/// matched.
+///
+/// \param[in] keywords The matching keywords
+/// \param[in] typedLengths For each matching keyword, the number of UTF-16 characters the user typed for it
+/// \param[out] outIds The IDs of the keywords in the current keyword index of the combo list
+/// \param[out] outTypedLengths For each ID in outIds, the number of UTF-16 characters the user typed for the keyword
+//**********************************************************************************************************************
+void ComboManager::findCurrentKeywordIds(QStringList const& keywords, QVector<qint32> const& typedLengths,
+   QVector<qint32>& outIds, QVector<qint32>& outTypedLengths) const
+{
+   outIds.clear();
+   outTypedLengths.clear();
+   KeywordIndex const& index = comboList_.keywordIndex();
+   QVector<qint32> ids;
+   for (qint32 i = 0; i < keywords.size(); ++i)
+   {
+      ids.clear();
+      index.findMatches(keywords[i], ids); // the keyword, and the loose matching keywords it ends with
+      for (qint32 const id: ids)
+         if ((index.keyword(id) == keywords[i]) && (!outIds.contains(id)))
+         {
+            outIds.push_back(id);
+            outTypedLengths.push_back(typedLengths.value(i, keywords[i].size()));
+         }
+   }
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] shortcode The emoji shortcode, without its delimiters
+//**********************************************************************************************************************
+void ComboManager::onEmojiShortcodeTyped(QString const& shortcode)
+{
+   LatencyTimer const timer(EmojiShortcodeStage);
+   PreferencesManager& prefs = PreferencesManager::instance();
+   if (!prefs.emojiShortcodesEnabled())
+      return;
+   QString const emoji = EmojiManager::instance().emoji(shortcode);
+   if (emoji.isEmpty())
+      return;
+   if ((!isBeeftextTheForegroundApplication()) &&
+      !EmojiManager::instance().isExcludedApplication(getActiveExecutableFileName()))
+   {
+      performTextSubstitution(shortcode.size() + prefs.emojiRightDelimiter().size() + 
+         prefs.emojiLeftDelimiter().size(), emoji, false, -1);
+      LatencyMonitor& monitor = LatencyMonitor::instance();
+      monitor.record(KeyStrokeToSubstitutionStage, LatencyMonitor::timestampNs() - monitor.lastKeyStrokeTimestampNs());
+      if (prefs.playSoundOnCombo() && sound_)
+         sound_->play();
+   }
+   this->resetTypedText();
 }
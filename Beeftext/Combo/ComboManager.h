@@ -12,6 +12,7 @@
 
 
 #include "ComboList.h"
+#include "MatchingWorker.h"
 #include "Group/GroupList.h"
 #include <XMiLib/RandomNumberGenerator.h>
 #include <memory>
@@ -29,7 +30,7 @@ public: // static member functions
 public: // member functions
    ComboManager(ComboManager const&) = delete; ///< Disabled copy constructor
 	ComboManager(ComboManager const&&) = delete; ///< Disabled move constructor
-	~ComboManager() = default; ///< Default destructor
+	~ComboManager(); ///< Destructor
 	ComboManager& operator=(ComboManager const&) = delete; ///< Disabled assignment operator
 	ComboManager& operator=(ComboManager const&&) = delete; ///< Disabled move assignment operator
    ComboList& comboListRef(); ///< Return a mutable reference to the combo list
@@ -41,6 +42,9 @@ public: // member functions
    bool restoreBackup(QString const& backupFilePath); /// Restore the combo list from a backup file
    void loadSoundFromPreferences(); ///< Load the combo sound to be played from the preferences
    void playSound() const; ///< Play the combo substitution sound.
+   KeywordMatcher::EMatchingMode matchingMode() const; ///< Return the strategy used to find the combos matching the typed text
+   void setMatchingMode(KeywordMatcher::EMatchingMode mode); ///< Set the strategy used to find the combos matching the typed text
+   void updateMatchingSettings(); ///< Publish the preferences used for matching to the matching thread
 signals:
    void comboListWasLoaded() const; ///< Signal emitted when the combo list has been loaded
    void comboListWasSaved() const;  ///< Signal emitted when the combo list has been saved
@@ -48,19 +52,28 @@ signals:
 
 private: // member functions
    ComboManager(); ///< Default constructor
-   void checkAndPerformSubstitution(); ///< Check if a combo or emoji substitution is possible and if so performs it
-   bool checkAndPerformComboSubstitution(); ///< check if a combo substitution is possible and if so performs it
-   bool checkAndPerformEmojiSubstitution(); ///< check if an emoji substitution is possible and if so performs it
+   void updateKeywordSnapshot(); ///< Publish a new keyword snapshot to the matching thread if the combo list changed
+   void resetTypedText(); ///< Reset the text typed by the user
+   SpCombo resolveMatch(QVector<qint32> const& keywordIds, qint32& outIndex); ///< Pick the combo to substitute among the matching combos
+   void findCurrentKeywordIds(QStringList const& keywords, QVector<qint32> const& typedLengths,
+      QVector<qint32>& outIds, QVector<qint32>& outTypedLengths) const; ///< Look up matching keywords in the current keyword index
 
 private slots:
-   void onComboBreakerTyped(); ///< Slot for the "Combo Breaker Typed" signal
-   void onCharacterTyped(QChar c); ///< Slot for the "Character Typed" signal
-   void onBackspaceTyped(); ///< Slot for the 'Backspace typed" signal
-   void onSubstitutionTriggerShortcut(); ///< Slot for the triggering of the substitution shortcut
+   void scheduleKeywordSnapshotUpdate(); ///< Schedule an update of the keyword snapshot
+   void stopMatchingThread(); ///< Stop the matching thread
+   void onComboMatched(QVector<qint32> const& keywordIds, QStringList const& keywords,
+      QVector<qint32> const& typedLengths, quint64 revision); ///< Slot for the "Combo matched" signal
+   void onEmojiShortcodeTyped(QString const& shortcode); ///< Slot for the "Emoji shortcode typed" signal
 
 private: // data member
-   QString currentText_; ///< The current string
    ComboList comboList_; ///< The list of combos
+   QThread matchingThread_; ///< The thread on which keystrokes are matched
+   std::unique_ptr<MatchingWorker> matchingWorker_; ///< The worker running on the matching thread
+   MatchingWorker::Settings matchingSettings_; ///< The settings published to the matching thread
+   KeywordFolder keywordFolder_; ///< The folder used to fold the keywords of the published snapshots
+   quint64 publishedRevision_ { 0 }; ///< The revision of the keyword index of the last published snapshot
+   qint32 publishedFoldingFlags_ { 0 }; ///< The folding flags of the last published snapshot
+   bool keywordSnapshotUpdateIsScheduled_ { false }; ///< Is an update of the keyword snapshot scheduled
    std::unique_ptr<QSound> sound_; ///< The sound to play when a combo is executed
    xmilib::RandomNumberGenerator rng_; ///< The RNG used to pick combos when multiple occurences are found
 };
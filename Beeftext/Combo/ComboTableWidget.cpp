@@ -357,10 +357,16 @@ void ComboTableWidget::changeMatchingModeOfSelectedCombos(bool const looseMatchi
 {
    try
    {
-      QList<SpCombo> const combos = this->getSelectedCombos();
-      for (SpCombo const& combo: combos)
-         if (combo)
-            combo->setUseLooseMatching(looseMatching);
+      ComboList& comboList = ComboManager::instance().comboListRef();
+      QList<qint32> const indexes = this->getSelectedComboIndexes();
+      for (qint32 const index: indexes)
+      {
+         SpCombo const& combo = comboList[index];
+         if (!combo)
+            continue;
+         combo->setUseLooseMatching(looseMatching);
+         comboList.markComboAsEdited(index);
+      }
       this->updateGui();
       QString errorMessage;
       if (!ComboManager::instance().saveComboListToFile(&errorMessage))
@@ -587,8 +593,8 @@ void ComboTableWidget::onActionCopySnippet() const
    if (!combo)
       return;
    bool cancelled = false;
-   QMap<QString, QString> knownInputVariables;
-   QString const text = combo->evaluatedSnippet(cancelled, QSet<QString>(), knownInputVariables, nullptr);
+   EvaluationContext context;
+   QString const text = combo->evaluatedSnippet(cancelled, context, nullptr);
    if (!cancelled)
       QGuiApplication::clipboard()->setText(text);
 }
@@ -8,7 +8,6 @@
 #include "ComboVariable.h"
 #include "ComboManager.h"
 #include "VariableInputDialog.h"
-#include "Clipboard/ClipboardManager.h"
 
 
 namespace {
@@ -22,24 +21,6 @@ enum class ECaseChange
 }; ///< Enumeration for case change
 
 
-QString const kCustomDateTimeVariable = "dateTime:"; ///< The dateTime variable.
-QString const kInputVariable = "input:"; ///< The input variable.
-QString const kEnvVarVariable = "envVar:"; ///< The envVar variable.
-
-
-//**********************************************************************************************************************
-/// \brief Resolve the escaped characters ( \\} and \\\\ in a variable parameter.
-/// \param[in] paramStr The variable parameter.
-/// \return The parameter where the escaped characters have been resolved.
-//**********************************************************************************************************************
-QString resolveEscapingInVariableParameter(QString paramStr)
-{
-   paramStr.replace(R"(\\)", R"(\)");
-   paramStr.replace(R"(\})", R"(})");
-   return paramStr;
-}
-
-
 //**********************************************************************************************************************
 /// \brief Converts a character to a Discord emoji. 
 ///
@@ -65,11 +46,12 @@ QString qcharToDiscordEmoji(QChar const& c)
 //**********************************************************************************************************************
 /// \brief Create a Discord emoji representation of the content of the clipboard
 ///
+/// \param[in,out] context The context of the evaluation.
 /// \return A string containing the sequence of Discord emojis
 //**********************************************************************************************************************
-QString discordEmojisFromClipboard()
+QString discordEmojisFromClipboard(EvaluationContext& context)
 {
-   QString str = ClipboardManager::text();
+   QString const& str = context.clipboardText();
    QString result;
    for (QChar const& c : str)
       result += qcharToDiscordEmoji(c);
@@ -106,13 +88,14 @@ QStringList splitTimeShiftString(QString const& shiftStr)
 
 
 //**********************************************************************************************************************
-/// \brief Returns the current date shifted according to the instructions in the shift string.
+/// \brief Returns a date shifted according to the instructions in the shift string.
+/// \param[in] dateTime The date/time to shift.
 /// \param[in] shiftStr The string describing the timeshift (as defined in the dateTime: variable documentation.
-/// \return The current date shifted according to the instructions in the shift string.
+/// \return The date shifted according to the instructions in the shift string.
 //**********************************************************************************************************************
-QDateTime shiftedDateTime(QString const& shiftStr)
+QDateTime shiftedDateTime(QDateTime const& dateTime, QString const& shiftStr)
 {
-   QDateTime result = QDateTime::currentDateTime();
+   QDateTime result = dateTime;
 
    QStringList const shifts = splitTimeShiftString(shiftStr);
    for (QString const& shift: shifts)
@@ -147,55 +130,52 @@ QDateTime shiftedDateTime(QString const& shiftStr)
 //**********************************************************************************************************************
 /// \brief Evaluate a #[dateTime:} variable
 /// \param[in] variable The variable.
+/// \param[in,out] context The context of the evaluation.
 /// \return the result of the evaluation.
 //**********************************************************************************************************************
-QString evaluateDateTimeVariable(QString const& variable)
+QString evaluateDateTimeVariable(QString const& variable, EvaluationContext& context)
 {
-   QString const formatString = resolveEscapingInVariableParameter(variable.right(variable.size()
-      - kCustomDateTimeVariable.size()));
-
    QRegularExpression const regExp(R"(^dateTime(:(([+-]\d+[yMwdhmsz])+))?:(.*)$)");
    QRegularExpressionMatch const match = regExp.match(variable);
    if (!match.hasMatch())
       return QString();
-   QDateTime const dateTime = match.captured(1).isEmpty() ? QDateTime::currentDateTime() :
-      shiftedDateTime(match.captured(2));
+   QDateTime const dateTime = match.captured(1).isEmpty() ? context.currentDateTime() :
+      shiftedDateTime(context.currentDateTime(), match.captured(2));
    QString const formatStr = match.captured(4);
-   return formatStr.isEmpty() ? QLocale::system().toString(dateTime) : QLocale::system().toString(dateTime, formatStr);
+   QLocale const& locale = context.locale();
+   return formatStr.isEmpty() ? locale.toString(dateTime) : locale.toString(dateTime, formatStr);
 }
 
 
 //**********************************************************************************************************************
 /// \brief Evaluate a #{combo:} variable.
 ///
-/// \param[in] variable The variable, without the enclosing #{}.
+/// The referenced combo is looked up in the dependency graph of the combo list, and its expansion is kept in the
+/// context, so a combo referenced several times in a substitution is only evaluated once. A reference to a combo that
+/// is already being expanded is left as is, to avoid endless recursion.
+///
+/// \param[in] variable The variable.
 /// \param[in] caseChange The change of case (uppercase, lowercase) to apply to the evaluated variable.
-/// \param[in] forbiddenSubCombos The text of the combos that are not allowed to be substituted using #{combo:}, to 
-/// avoid endless recursion.
-/// \param[in,out] knownInputVariables The list of know input variables.
+/// \param[in,out] context The context of the evaluation.
+/// \param[out] outIsHtml Is the evaluated variable in HTML format?
 /// \param[out] outCancelled Was the input variable cancelled by the user.
 /// \return The result of evaluating the variable.
 //**********************************************************************************************************************
-QString evaluateComboVariable(QString const& variable, ECaseChange caseChange, QSet<QString> forbiddenSubCombos, 
-   QMap<QString, QString>& knownInputVariables, bool& outIsHtml, bool& outCancelled)
+QString evaluateComboVariable(SnippetTemplate::Node const& variable, ECaseChange caseChange, 
+   EvaluationContext& context, bool& outIsHtml, bool& outCancelled)
 {
    outIsHtml = false;
-   QString fallbackResult = QString("#{%1}").arg(variable);
-   qint32 const varNameLength = variable.indexOf(':');
-   if (varNameLength < 0)
-      return QString();
-   QString const comboName = resolveEscapingInVariableParameter(variable.right(variable.size() - varNameLength - 1));
-   if (forbiddenSubCombos.contains(comboName))
-      return fallbackResult;
-   ComboList const& combos = ComboManager::instance().comboListRef();
-   ComboList::const_iterator const it = std::find_if(combos.begin(), combos.end(),
-      [&comboName](SpCombo const& combo) -> bool { return combo->keyword() == comboName; });
-
-   if (combos.end() == it)
-      return fallbackResult;
-   QString str = (*it)->evaluatedSnippet(outCancelled, forbiddenSubCombos << comboName, knownInputVariables, 
-      nullptr); // forbiddenSubcombos is intended at avoiding endless recursion
-   outIsHtml = (*it)->useHtml();
+   QString const& keyword = variable.parameter;
+   QString str;
+   if (!context.findExpansion(keyword, str, outIsHtml))
+   {
+      SpCombo const combo = ComboManager::instance().comboListRef().dependencyGraph().comboByKeyword(keyword);
+      if ((!combo) || (!context.beginExpansion(keyword)))
+         return QString("#{%1}").arg(variable.text);
+      str = combo->evaluatedSnippet(outCancelled, context, nullptr);
+      outIsHtml = combo->useHtml();
+      context.endExpansion(keyword, str, outIsHtml, outCancelled);
+   }
    switch (caseChange)
    {
    case ECaseChange::ToUpper: return str.toUpper();
@@ -208,20 +188,21 @@ QString evaluateComboVariable(QString const& variable, ECaseChange caseChange, Q
 //**********************************************************************************************************************
 /// \brief Evaluate an #{input:} variable.
 ///
-/// \param[in] variable The variable, without the enclosing #{}.
-/// \param[in,out] knownInputVariables The list of know input variables.
+/// \param[in] variable The variable.
+/// \param[in,out] context The context of the evaluation.
 /// \param[out] outCancelled Was the input variable cancelled by the user.
 /// \return The result of evaluating the variable.
 //**********************************************************************************************************************
-QString evaluateInputVariable(QString const& variable, QMap<QString, QString>& knownInputVariables, bool& outCancelled)
+QString evaluateInputVariable(SnippetTemplate::Node const& variable, EvaluationContext& context, bool& outCancelled)
 {
    // check if we already add the user input for the given description
-   QString const description = variable.right(variable.size() - kInputVariable.size());
+   QMap<QString, QString>& knownInputVariables = context.knownInputVariables();
+   QString const& description = variable.parameter;
    if (knownInputVariables.contains(description))
       return knownInputVariables[description];
 
    QString result;
-   if (!VariableInputDialog::run(resolveEscapingInVariableParameter(description), result))
+   if (!VariableInputDialog::run(SnippetTemplate::resolveEscaping(description), result))
    {
       outCancelled = true;
       return QString();
@@ -232,19 +213,6 @@ QString evaluateInputVariable(QString const& variable, QMap<QString, QString>& k
 }
 
 
-//**********************************************************************************************************************
-/// \brief Evaluate an #{envvar:} variable.
-///
-/// \param[in] variable The variable, without the enclosing #{}.
-/// \return The result of evaluating the variable.
-//**********************************************************************************************************************
-QString evaluateEnvVarVariable(QString const& variable)
-{
-   return QProcessEnvironment::systemEnvironment().value(variable.right(variable.size() -
-      kEnvVarVariable.size()));
-}
-
-
 //**********************************************************************************************************************
 //  \brief Trim the specified plain or rich text, i.e. erase all non printable characters at the beginning and end
 //  of the text.
@@ -289,68 +257,68 @@ QString trimText(QString const& text, bool isHtml)
 
 
 //**********************************************************************************************************************
-/// \param[in] variable The variable, without the enclosing #{}.
-/// \param[in] forbiddenSubCombos The text of the combos that are not allowed to be substituted using #{combo:}, to 
-/// avoid endless recursion.
-/// \param[in,out] knownInputVariables The list of know input variables.
+/// \param[in] variable The variable.
+/// \param[in,out] context The context of the evaluation.
 /// \param[out] outIsHtml Is the evaluated variable in HTML format?
 /// \param[out] outCancelled Was the input variable cancelled by the user.
 /// \return The result of evaluating the variable.
 //**********************************************************************************************************************
-QString evaluateVariable(QString const& variable, QSet<QString> const& forbiddenSubCombos, 
-   QMap<QString, QString>& knownInputVariables, bool& outIsHtml, bool& outCancelled)
+QString evaluateVariable(SnippetTemplate::Node const& variable, EvaluationContext& context, bool& outIsHtml, 
+   bool& outCancelled)
 {
    outIsHtml = false;
    outCancelled = false;
-   QLocale const systemLocale = QLocale::system();
-   if (variable == "clipboard")
+   switch (variable.variableType)
    {
-      QString html = ClipboardManager::html();
+   case SnippetTemplate::ClipboardVariable:
+   {
+      QString const& html = context.clipboardHtml();
       if (html.isEmpty())
-         return ClipboardManager::text();
+         return context.clipboardText();
       outIsHtml = true;
       return html;
    }
-   
-   if (variable == "discordemoji") //secret variable that create text in Discord emoji from the clipboard text
-      return discordEmojisFromClipboard();
 
-   if (variable == "date")
-      return systemLocale.toString(QDate::currentDate());
+   // secret variable that create text in Discord emoji from the clipboard text
+   case SnippetTemplate::DiscordEmojiVariable:
+      return discordEmojisFromClipboard(context);
+
+   case SnippetTemplate::DateVariable:
+      return context.locale().toString(context.currentDateTime().date());
 
-   if (variable == "time")
-      return systemLocale.toString(QTime::currentTime());
+   case SnippetTemplate::TimeVariable:
+      return context.locale().toString(context.currentDateTime().time());
 
-   if (variable == "dateTime")
-      return systemLocale.toString(QDateTime::currentDateTime());
+   case SnippetTemplate::DateTimeVariable:
+      return context.locale().toString(context.currentDateTime());
 
-   if (variable.startsWith(kCustomDateTimeVariable))
-      return evaluateDateTimeVariable(variable);
+   case SnippetTemplate::CustomDateTimeVariable:
+      return evaluateDateTimeVariable(variable.text, context);
 
-   if (variable.startsWith("combo:"))
-      return evaluateComboVariable(variable, ECaseChange::NoChange, forbiddenSubCombos, knownInputVariables, 
-         outIsHtml, outCancelled);
+   case SnippetTemplate::ComboVariable:
+      return evaluateComboVariable(variable, ECaseChange::NoChange, context, outIsHtml, outCancelled);
 
-   if (variable.startsWith("upper:"))
-      return evaluateComboVariable(variable, ECaseChange::ToUpper, forbiddenSubCombos, knownInputVariables, 
-         outIsHtml, outCancelled);
+   case SnippetTemplate::UpperComboVariable:
+      return evaluateComboVariable(variable, ECaseChange::ToUpper, context, outIsHtml, outCancelled);
 
-   if (variable.startsWith("lower:"))
-      return evaluateComboVariable(variable, ECaseChange::ToLower, forbiddenSubCombos, knownInputVariables, 
-         outIsHtml, outCancelled);
+   case SnippetTemplate::LowerComboVariable:
+      return evaluateComboVariable(variable, ECaseChange::ToLower, context, outIsHtml, outCancelled);
 
-   if (variable.startsWith("trim:"))
+   case SnippetTemplate::TrimComboVariable:
    {
-      QString const var = evaluateComboVariable(variable, ECaseChange::NoChange, forbiddenSubCombos, 
-         knownInputVariables, outIsHtml, outCancelled);
+      QString const var = evaluateComboVariable(variable, ECaseChange::NoChange, context, outIsHtml, outCancelled);
       return trimText(var, outIsHtml);
    }
 
-   if (variable.startsWith(kInputVariable))
-      return evaluateInputVariable(variable, knownInputVariables, outCancelled);
+   case SnippetTemplate::InputVariable:
+      return evaluateInputVariable(variable, context, outCancelled);
 
-   if (variable.startsWith(kEnvVarVariable))
-      return evaluateEnvVarVariable(variable);
+   case SnippetTemplate::EnvVarVariable:
+      return context.environment().value(variable.parameter);
 
-   return QString("#{%1}").arg(variable); // we could not recognize the variable, so we put it back in the result
+   case SnippetTemplate::UnknownVariable:
+   default:
+      // we could not recognize the variable, so we put it back in the result
+      return QString("#{%1}").arg(variable.text);
+   }
 }
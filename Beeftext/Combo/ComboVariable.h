@@ -8,8 +8,12 @@
 #define BEEFTEXT_COMBO_VARIABLE_H
 
 
-QString evaluateVariable(QString const& variable, QSet<QString> const& forbiddenSubCombos, 
-   QMap<QString, QString>& knownInputVariables, bool& outIsHtml, bool& outCancelled); ///< Compute the value of a variable.
+#include "SnippetTemplate.h"
+#include "EvaluationContext.h"
+
+
+QString evaluateVariable(SnippetTemplate::Node const& variable, EvaluationContext& context, bool& outIsHtml, 
+   bool& outCancelled); ///< Compute the value of a variable.
 
 
 #endif // #ifndef BEEFTEXT_COMBO_VARIABLE_H
@@ -0,0 +1,137 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the context of the evaluation of a snippet
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "EvaluationContext.h"
+#include "Clipboard/ClipboardManager.h"
+
+
+//**********************************************************************************************************************
+/// \return A mutable reference to the values of the input variables, indexed by description
+//**********************************************************************************************************************
+QMap<QString, QString>& EvaluationContext::knownInputVariables()
+{
+   return knownInputVariables_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The system locale
+//**********************************************************************************************************************
+QLocale const& EvaluationContext::locale()
+{
+   if (!locale_)
+      locale_ = std::make_unique<QLocale>(QLocale::system());
+   return *locale_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The date/time of the first call to the function for this context
+//**********************************************************************************************************************
+QDateTime const& EvaluationContext::currentDateTime()
+{
+   if (currentDateTime_.isNull())
+      currentDateTime_ = QDateTime::currentDateTime();
+   return currentDateTime_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The text content of the clipboard
+//**********************************************************************************************************************
+QString const& EvaluationContext::clipboardText()
+{
+   if (!clipboardTextIsCaptured_)
+   {
+      clipboardText_ = ClipboardManager::text();
+      clipboardTextIsCaptured_ = true;
+   }
+   return clipboardText_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The HTML content of the clipboard
+//**********************************************************************************************************************
+QString const& EvaluationContext::clipboardHtml()
+{
+   if (!clipboardHtmlIsCaptured_)
+   {
+      clipboardHtml_ = ClipboardManager::html();
+      clipboardHtmlIsCaptured_ = true;
+   }
+   return clipboardHtml_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The environment of the process
+//**********************************************************************************************************************
+QProcessEnvironment const& EvaluationContext::environment()
+{
+   if (!environment_)
+      environment_ = std::make_unique<QProcessEnvironment>(QProcessEnvironment::systemEnvironment());
+   return *environment_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyword The keyword of the combo
+/// \param[out] outText If the function returns true, the evaluated snippet of the combo
+/// \param[out] outIsHtml If the function returns true, is the evaluated snippet in HTML format
+/// \return true if and only if the combo has already been expanded in this context
+//**********************************************************************************************************************
+bool EvaluationContext::findExpansion(QString const& keyword, QString& outText, bool& outIsHtml) const
+{
+   QHash<QString, Expansion>::const_iterator const it = expansions_.constFind(keyword);
+   if (expansions_.constEnd() == it)
+      return false;
+   outText = it->text;
+   outIsHtml = it->isHtml;
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyword The keyword of the combo
+/// \return true if the combo can be expanded
+/// \return false if the combo is already being expanded, in which case expanding it would cause an endless recursion
+//**********************************************************************************************************************
+bool EvaluationContext::beginExpansion(QString const& keyword)
+{
+   if (expandingKeywords_.contains(keyword))
+   {
+      ++recursionCount_;
+      return false;
+   }
+   expandingKeywords_.insert(keyword);
+   recursionCounts_.push_back(recursionCount_);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// The expansion is only kept if no recursive reference was met while evaluating it, as its value would then depend
+/// on the combos that were being expanded.
+///
+/// \param[in] keyword The keyword of the combo
+/// \param[in] text The evaluated snippet of the combo
+/// \param[in] isHtml Is the evaluated snippet in HTML format
+/// \param[in] cancelled Was the evaluation cancelled by the user
+//**********************************************************************************************************************
+void EvaluationContext::endExpansion(QString const& keyword, QString const& text, bool isHtml, bool cancelled)
+{
+   Q_ASSERT(expandingKeywords_.contains(keyword) && (!recursionCounts_.empty()));
+   expandingKeywords_.remove(keyword);
+   bool const wasRecursive = (recursionCounts_.back() != recursionCount_);
+   recursionCounts_.pop_back();
+   if ((!cancelled) && (!wasRecursive))
+      expansions_.insert(keyword, { text, isHtml });
+}
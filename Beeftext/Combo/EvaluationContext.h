@@ -0,0 +1,72 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the context of the evaluation of a snippet
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_EVALUATION_CONTEXT_H
+#define BEEFTEXT_EVALUATION_CONTEXT_H
+
+
+#include <memory>
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief The state shared by all the variables evaluated during a substitution
+///
+/// A context is created for each substitution and passed down to the combos referenced by the snippet. It holds the
+/// values entered for the #{input:} variables, the keywords of the combos being expanded, used to stop endless
+/// recursion, and the expansions of the referenced combos, so that a combo referenced several times is only evaluated
+/// once.
+///
+/// The system locale, the content of the clipboard, the environment and the current date/time are captured the first
+/// time they are requested, and reused for the rest of the substitution. They are only retrieved once, and all the
+/// variables of a snippet, including the #{date} and #{time} variables, agree with each other.
+//**********************************************************************************************************************
+class EvaluationContext
+{
+public: // member functions
+   EvaluationContext() = default; ///< Default constructor
+   EvaluationContext(EvaluationContext const&) = delete; ///< Disabled copy constructor
+   EvaluationContext(EvaluationContext&&) = delete; ///< Disabled move constructor
+   ~EvaluationContext() = default; ///< Default destructor
+   EvaluationContext& operator=(EvaluationContext const&) = delete; ///< Disabled assignment operator
+   EvaluationContext& operator=(EvaluationContext&&) = delete; ///< Disabled move assignment operator
+   QMap<QString, QString>& knownInputVariables(); ///< Return a mutable reference to the values of the input variables
+   QLocale const& locale(); ///< Return the system locale
+   QDateTime const& currentDateTime(); ///< Return the current date/time
+   QString const& clipboardText(); ///< Return the text content of the clipboard
+   QString const& clipboardHtml(); ///< Return the HTML content of the clipboard
+   QProcessEnvironment const& environment(); ///< Return the environment of the process
+   bool findExpansion(QString const& keyword, QString& outText, bool& outIsHtml) const; ///< Retrieve the expansion of a combo
+   bool beginExpansion(QString const& keyword); ///< Mark the beginning of the expansion of a combo
+   void endExpansion(QString const& keyword, QString const& text, bool isHtml, bool cancelled); ///< Mark the end of the expansion of a combo
+
+private: // data types
+   struct Expansion
+   {
+      QString text; ///< The evaluated snippet
+      bool isHtml { false }; ///< Is the evaluated snippet in HTML format
+   }; ///< The expansion of a combo
+
+private: // data members
+   QMap<QString, QString> knownInputVariables_; ///< The values of the input variables, indexed by description
+   QHash<QString, Expansion> expansions_; ///< The expansions of the combos, indexed by keyword
+   QSet<QString> expandingKeywords_; ///< The keywords of the combos being expanded
+   std::vector<qint32> recursionCounts_; ///< For each combo being expanded, the recursion count when the expansion began
+   qint32 recursionCount_ { 0 }; ///< The number of references that were not expanded because they were recursive
+   std::unique_ptr<QLocale> locale_; ///< The system locale, or null if it has not been requested yet
+   QDateTime currentDateTime_; ///< The current date/time, or a null date/time if it has not been requested yet
+   QString clipboardText_; ///< The text content of the clipboard
+   bool clipboardTextIsCaptured_ { false }; ///< Has the text content of the clipboard been retrieved
+   QString clipboardHtml_; ///< The HTML content of the clipboard
+   bool clipboardHtmlIsCaptured_ { false }; ///< Has the HTML content of the clipboard been retrieved
+   std::unique_ptr<QProcessEnvironment> environment_; ///< The environment, or null if it has not been requested yet
+};
+
+
+#endif // #ifndef BEEFTEXT_EVALUATION_CONTEXT_H
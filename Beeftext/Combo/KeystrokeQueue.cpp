@@ -0,0 +1,165 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the keystroke queue between the input manager and the matching thread
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeystrokeQueue.h"
+
+
+//**********************************************************************************************************************
+/// \param[in] capacity The minimum capacity of the queue. The actual capacity is the next power of 2
+//**********************************************************************************************************************
+KeystrokeQueue::KeystrokeQueue(qint32 capacity)
+{
+   quint32 size = 2;
+   while (size < quint32(qMax(capacity, 2)))
+      size *= 2;
+   events_.resize(size);
+   mask_ = size - 1;
+}
+
+
+//**********************************************************************************************************************
+/// \return The capacity of the queue
+//**********************************************************************************************************************
+qint32 KeystrokeQueue::capacity() const
+{
+   return qint32(events_.size());
+}
+
+
+//**********************************************************************************************************************
+/// This function must only be called by the producer thread.
+///
+/// \param[in] event The event
+/// \return true if the event was pushed
+/// \return false if the queue is full, in which case the event is dropped
+//**********************************************************************************************************************
+bool KeystrokeQueue::push(KeystrokeEvent const& event)
+{
+   return this->push(&event, 1);
+}
+
+
+//**********************************************************************************************************************
+/// The events are published at once, so the consumer sees either all of them or none. This function must only be
+/// called by the producer thread.
+///
+/// \param[in] events The events
+/// \param[in] count The number of events
+/// \return true if the events were pushed
+/// \return false if the queue does not have room for all the events, in which case they are all dropped
+//**********************************************************************************************************************
+bool KeystrokeQueue::push(KeystrokeEvent const* events, qint32 count)
+{
+   if (count <= 0)
+      return true;
+   quint32 const tail = tail_.load(std::memory_order_relaxed);
+   if (quint32(events_.size()) - (tail - head_.load(std::memory_order_acquire)) < quint32(count))
+   {
+      overflow_.store(true, std::memory_order_seq_cst);
+      this->notifyConsumer();
+      return false;
+   }
+   for (qint32 i = 0; i < count; ++i)
+      events_[(tail + quint32(i)) & mask_] = events[i];
+   tail_.store(tail + quint32(count), std::memory_order_seq_cst);
+   this->notifyConsumer();
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// This function must only be called by the consumer thread.
+///
+/// \param[out] outEvent The event
+/// \return true if an event was popped
+/// \return false if the queue is empty
+//**********************************************************************************************************************
+bool KeystrokeQueue::pop(KeystrokeEvent& outEvent)
+{
+   quint32 const head = head_.load(std::memory_order_relaxed);
+   if (head == tail_.load(std::memory_order_acquire))
+      return false;
+   outEvent = events_[head & mask_];
+   head_.store(head + 1, std::memory_order_release);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// The events are released to the producer at once. This function must only be called by the consumer thread.
+///
+/// \param[out] outEvents The buffer receiving the events. Its size must be at least maxCount
+/// \param[in] maxCount The maximum number of events to pop
+/// \return The number of events popped
+//**********************************************************************************************************************
+qint32 KeystrokeQueue::pop(KeystrokeEvent* outEvents, qint32 maxCount)
+{
+   quint32 const head = head_.load(std::memory_order_relaxed);
+   qint32 const count = qint32(qMin(tail_.load(std::memory_order_acquire) - head, quint32(qMax(maxCount, 0))));
+   for (qint32 i = 0; i < count; ++i)
+      outEvents[i] = events_[(head + quint32(i)) & mask_];
+   head_.store(head + quint32(count), std::memory_order_release);
+   return count;
+}
+
+
+//**********************************************************************************************************************
+/// This function must only be called by the consumer thread.
+///
+/// \return true if and only if events were dropped since the last call to the function
+//**********************************************************************************************************************
+bool KeystrokeQueue::takeOverflow()
+{
+   return overflow_.exchange(false, std::memory_order_acq_rel);
+}
+
+
+//**********************************************************************************************************************
+/// The function returns immediately if events are available, so the consumer must pop all available events before
+/// waiting again. It may also return spuriously when no event is available. This function must only be called by the
+/// consumer thread.
+//**********************************************************************************************************************
+void KeystrokeQueue::waitForEvents()
+{
+   // the flag is raised before checking for events, and the producer checks the flag after publishing events, so
+   // either we see the events, or the producer sees the flag and wakes us up. The operations are sequentially
+   // consistent, as this ordering requires.
+   consumerWaiting_.store(true, std::memory_order_seq_cst);
+   if ((head_.load(std::memory_order_relaxed) != tail_.load(std::memory_order_seq_cst)) ||
+      overflow_.load(std::memory_order_seq_cst))
+   {
+      // if the producer lowered the flag in the meantime, it has released a wake-up that will make the next wait
+      // return spuriously, which is harmless
+      consumerWaiting_.store(false, std::memory_order_relaxed);
+      return;
+   }
+   wakeUps_.acquire();
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void KeystrokeQueue::wakeConsumer()
+{
+   consumerWaiting_.store(false, std::memory_order_seq_cst);
+   wakeUps_.release();
+}
+
+
+//**********************************************************************************************************************
+/// The semaphore is only released when the consumer is waiting, so the producer does not pay for a wake-up per
+/// event while the consumer is draining the queue.
+//**********************************************************************************************************************
+void KeystrokeQueue::notifyConsumer()
+{
+   if (consumerWaiting_.load(std::memory_order_seq_cst) && consumerWaiting_.exchange(false, std::memory_order_seq_cst))
+      wakeUps_.release();
+}
@@ -0,0 +1,76 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the keystroke queue between the input manager and the matching thread
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEYSTROKE_QUEUE_H
+#define BEEFTEXT_KEYSTROKE_QUEUE_H
+
+
+#include <atomic>
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief A keystroke event, as processed by the matching thread
+//**********************************************************************************************************************
+struct KeystrokeEvent
+{
+   enum EType {
+      Character = 0, ///< A character was typed
+      Backspace = 1, ///< The backspace key was typed
+      ComboBreaker = 2, ///< A combo breaker was typed, or the typed text must be reset
+      SubstitutionTrigger = 3, ///< The manual substitution shortcut was triggered
+   }; ///< The type of keystroke event
+
+   EType type; ///< The type of the event
+   QChar c; ///< The character, for events of type Character
+};
+
+
+//**********************************************************************************************************************
+/// \brief A lock-free single producer, single consumer ring buffer of keystroke events
+///
+/// The producer is the thread running the input hooks, which is the GUI thread, and the consumer is the matching
+/// thread. Pushing events never blocks nor allocates. If the ring is full, the events are dropped and the consumer
+/// is told about it, so that it can discard the typed text that is no longer reliable. The consumer can block until
+/// events are available. The producer only wakes the consumer up if it is blocked, so a burst of events pushed while
+/// the consumer is busy costs a single wake-up, and the consumer pops the whole burst in one pass.
+//**********************************************************************************************************************
+class KeystrokeQueue
+{
+public: // member functions
+   explicit KeystrokeQueue(qint32 capacity = 4096); ///< Default constructor
+   KeystrokeQueue(KeystrokeQueue const&) = delete; ///< Disabled copy constructor
+   KeystrokeQueue(KeystrokeQueue&&) = delete; ///< Disabled move constructor
+   ~KeystrokeQueue() = default; ///< Default destructor
+   KeystrokeQueue& operator=(KeystrokeQueue const&) = delete; ///< Disabled assignment operator
+   KeystrokeQueue& operator=(KeystrokeQueue&&) = delete; ///< Disabled move assignment operator
+   qint32 capacity() const; ///< Return the capacity of the queue
+   bool push(KeystrokeEvent const& event); ///< Push an event in the queue (producer side)
+   bool push(KeystrokeEvent const* events, qint32 count); ///< Push several events in the queue at once (producer side)
+   bool pop(KeystrokeEvent& outEvent); ///< Pop an event from the queue (consumer side)
+   qint32 pop(KeystrokeEvent* outEvents, qint32 maxCount); ///< Pop all available events, up to a maximum count (consumer side)
+   bool takeOverflow(); ///< Check and clear the flag indicating events were dropped (consumer side)
+   void waitForEvents(); ///< Block until events are available, or the consumer is woken up (consumer side)
+   void wakeConsumer(); ///< Wake the consumer up, even if no event is available
+
+private: // member functions
+   void notifyConsumer(); ///< Wake the consumer up if it is blocked (producer side)
+
+private: // data members
+   std::vector<KeystrokeEvent> events_; ///< The storage for the ring
+   quint32 mask_ { 0 }; ///< The mask used to compute the index of an event in the ring
+   alignas(64) std::atomic<quint32> head_ { 0 }; ///< The number of events popped so far, written by the consumer
+   alignas(64) std::atomic<quint32> tail_ { 0 }; ///< The number of events pushed so far, written by the producer
+   std::atomic<bool> overflow_ { false }; ///< Were events dropped because the ring was full
+   std::atomic<bool> consumerWaiting_ { false }; ///< Is the consumer blocked, or about to block, waiting for events
+   QSemaphore wakeUps_; ///< The semaphore the consumer waits on
+};
+
+
+#endif // #ifndef BEEFTEXT_KEYSTROKE_QUEUE_H
@@ -0,0 +1,153 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the Aho-Corasick automaton used for streaming combo matching
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeywordAutomaton.h"
+#include <algorithm>
+
+
+qint32 const KeywordAutomaton::rootState = 0;
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+KeywordAutomaton::KeywordAutomaton()
+   : states_(1)
+{
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] snapshot The keyword snapshot. The IDs reported by the automaton are the keyword IDs of its entries
+//**********************************************************************************************************************
+void KeywordAutomaton::build(KeywordSnapshot const& snapshot)
+{
+   states_.assign(1, State());
+
+   // build the trie of keywords (the goto function)
+   for (qint32 entry = 0; entry < snapshot.size(); ++entry)
+   {
+      if (!snapshot.isLooseMatching(entry))
+         continue;
+      QChar const* const keyword = snapshot.keywordData(entry);
+      qint32 state = rootState;
+      for (qint32 i = 0; i < snapshot.keywordLength(entry); ++i)
+         state = this->getOrCreateChild(state, keyword[i]);
+      states_[state].ids.push_back(snapshot.keywordId(entry));
+   }
+
+   // compute the failure and output links with a breadth-first traversal of the trie
+   std::vector<qint32> queue;
+   queue.reserve(states_.size());
+   for (Edge const& edge: states_[rootState].edges)
+      queue.push_back(edge.state);
+   for (size_t i = 0; i < queue.size(); ++i)
+   {
+      qint32 const s = queue[i];
+      qint32 const failure = states_[s].failure;
+      states_[s].output = states_[failure].ids.empty() ? states_[failure].output : failure;
+      for (Edge const& edge: states_[s].edges)
+      {
+         qint32 f = failure;
+         qint32 target = this->child(f, edge.c);
+         while ((target < 0) && (f != rootState))
+         {
+            f = states_[f].failure;
+            target = this->child(f, edge.c);
+         }
+         states_[edge.state].failure = ((target < 0) || (target == edge.state)) ? rootState : target;
+         queue.push_back(edge.state);
+      }
+   }
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of states in the automaton
+//**********************************************************************************************************************
+qint32 KeywordAutomaton::stateCount() const
+{
+   return qint32(states_.size());
+}
+
+
+//**********************************************************************************************************************
+/// The cost of the function is amortized constant: failure links may be followed, but never more times than the
+/// number of characters previously read without reaching the root state.
+///
+/// \param[in] state The current state
+/// \param[in] c The character
+/// \return The new state
+//**********************************************************************************************************************
+qint32 KeywordAutomaton::next(qint32 state, QChar c) const
+{
+   while (true)
+   {
+      qint32 const target = this->child(state, c);
+      if (target >= 0)
+         return target;
+      if (rootState == state)
+         return rootState;
+      state = states_[state].failure;
+   }
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function.
+///
+/// \param[in] state The current state
+/// \param[out] outIds The IDs of the matching keywords
+//**********************************************************************************************************************
+void KeywordAutomaton::findMatches(qint32 state, QVector<qint32>& outIds) const
+{
+   if ((state < 0) || (state >= qint32(states_.size())))
+      return;
+   for (qint32 s = states_[state].ids.empty() ? states_[state].output : state; s >= 0; s = states_[s].output)
+      for (qint32 const id: states_[s].ids)
+         outIds.push_back(id);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] state The state
+/// \param[in] c The character
+/// \return The target state
+/// \return -1 if the state has no goto edge for the character
+//**********************************************************************************************************************
+qint32 KeywordAutomaton::child(qint32 state, QChar c) const
+{
+   std::vector<Edge> const& edges = states_[state].edges;
+   std::vector<Edge>::const_iterator const it = std::lower_bound(edges.begin(), edges.end(), c,
+      [](Edge const& edge, QChar ch) -> bool { return edge.c < ch; });
+   return ((it != edges.end()) && (it->c == c)) ? it->state : -1;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] state The state
+/// \param[in] c The character
+/// \return The target state
+//**********************************************************************************************************************
+qint32 KeywordAutomaton::getOrCreateChild(qint32 state, QChar c)
+{
+   qint32 const existing = this->child(state, c);
+   if (existing >= 0)
+      return existing;
+   qint32 const result = qint32(states_.size());
+   states_.emplace_back(); // note that this can invalidate references to the elements of states_
+   std::vector<Edge>& edges = states_[state].edges;
+   Edge edge;
+   edge.c = c;
+   edge.state = result;
+   edges.insert(std::lower_bound(edges.begin(), edges.end(), c,
+      [](Edge const& e, QChar ch) -> bool { return e.c < ch; }), edge);
+   return result;
+}
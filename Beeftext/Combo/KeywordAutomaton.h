@@ -0,0 +1,68 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the Aho-Corasick automaton used for streaming combo matching
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEYWORD_AUTOMATON_H
+#define BEEFTEXT_KEYWORD_AUTOMATON_H
+
+
+#include "KeywordSnapshot.h"
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief An Aho-Corasick automaton built from the loose matching keywords of a keyword snapshot
+///
+/// The automaton is fed one character at a time. The state reached after a character identifies the longest keyword
+/// prefix that is a suffix of the text typed so far, so that the state can be saved between keystrokes and matches
+/// can be retrieved without re-reading the typed text. Strict matching keywords are not part of the automaton, as
+/// they are found with a single lookup in the keyword snapshot. Like the keyword snapshot, the automaton cannot be
+/// updated incrementally and must be rebuilt when the keywords change.
+//**********************************************************************************************************************
+class KeywordAutomaton
+{
+public: // member functions
+   KeywordAutomaton(); ///< Default constructor
+   KeywordAutomaton(KeywordAutomaton const&) = default; ///< Default copy constructor
+   KeywordAutomaton(KeywordAutomaton&&) = default; ///< Default move constructor
+   ~KeywordAutomaton() = default; ///< Default destructor
+   KeywordAutomaton& operator=(KeywordAutomaton const&) = default; ///< Default assignment operator
+   KeywordAutomaton& operator=(KeywordAutomaton&&) = default; ///< Default move assignment operator
+   void build(KeywordSnapshot const& snapshot); ///< Build the automaton from a keyword snapshot
+   qint32 stateCount() const; ///< Return the number of states in the automaton
+   qint32 next(qint32 state, QChar c) const; ///< Return the state reached from a state after reading a character
+   void findMatches(qint32 state, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the keywords matching in a given state
+
+public: // static data members
+   static qint32 const rootState; ///< The initial state of the automaton
+
+private: // data types
+   struct Edge
+   {
+      QChar c; ///< The character labelling the edge
+      qint32 state { 0 }; ///< The target state
+   }; ///< A goto edge of the automaton
+
+   struct State
+   {
+      std::vector<Edge> edges; ///< The goto edges, sorted by character
+      qint32 failure { 0 }; ///< The failure link
+      qint32 output { -1 }; ///< The closest state on the failure chain that ends a keyword, or -1 if none
+      std::vector<qint32> ids; ///< The IDs of the keywords ending on this state
+   }; ///< A state of the automaton
+
+private: // member functions
+   qint32 child(qint32 state, QChar c) const; ///< Return the goto target of a state for a character
+   qint32 getOrCreateChild(qint32 state, QChar c); ///< Return or create the goto target of a state for a character
+
+private: // data members
+   std::vector<State> states_; ///< The states of the automaton
+};
+
+
+#endif // #ifndef BEEFTEXT_KEYWORD_AUTOMATON_H
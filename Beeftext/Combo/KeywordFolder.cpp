@@ -0,0 +1,121 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the keyword folder used for case and normalization insensitive matching
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeywordFolder.h"
+
+
+//**********************************************************************************************************************
+/// \param[in] flags The folding flags
+//**********************************************************************************************************************
+KeywordFolder::KeywordFolder(qint32 flags)
+{
+   this->setFlags(flags);
+}
+
+
+//**********************************************************************************************************************
+/// \return The folding flags
+//**********************************************************************************************************************
+qint32 KeywordFolder::flags() const
+{
+   return flags_;
+}
+
+
+//**********************************************************************************************************************
+/// The folding table is rebuilt only if the flags change. Building it takes a few milliseconds, so the function
+/// should not be called per keystroke.
+///
+/// \param[in] flags The folding flags
+//**********************************************************************************************************************
+void KeywordFolder::setFlags(qint32 flags)
+{
+   flags &= CaseFolding | NormalizationFolding;
+   if (flags == flags_)
+      return;
+   flags_ = flags;
+   table_.clear();
+   if (!flags_)
+      return;
+   table_.resize(0x10000);
+   for (quint32 u = 0; u < 0x10000; ++u)
+   {
+      QChar c = QChar(ushort(u));
+      if (c.isSurrogate())
+      {
+         table_[u] = ushort(u);
+         continue;
+      }
+      if ((flags_ & NormalizationFolding) && (QChar::Canonical == c.decompositionTag()))
+      {
+         QString const normalized = QString(c).normalized(QString::NormalizationForm_C);
+         if (1 == normalized.size()) // singleton decompositions, e.g. U+212B ANGSTROM SIGN -> U+00C5
+            c = normalized[0];
+      }
+      if (flags_ & CaseFolding)
+         c = c.toCaseFolded();
+      table_[u] = c.unicode();
+   }
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if any folding is performed
+//**********************************************************************************************************************
+bool KeywordFolder::isEnabled() const
+{
+   return 0 != flags_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] c The character
+/// \return The folded character
+//**********************************************************************************************************************
+QChar KeywordFolder::foldCharacter(QChar c) const
+{
+   return table_.empty() ? c : QChar(table_[c.unicode()]);
+}
+
+
+//**********************************************************************************************************************
+/// Only combining marks are composed, so the function does not allocate for the vast majority of keystrokes.
+///
+/// \param[in] base The preceding character in the typed text, already folded
+/// \param[in] mark The typed character, already folded
+/// \param[out] outComposed The folded composed character
+/// \return true if and only if the two characters compose to a single character
+//**********************************************************************************************************************
+bool KeywordFolder::composeCharacters(QChar base, QChar mark, QChar& outComposed) const
+{
+   if ((!(flags_ & NormalizationFolding)) || (!mark.isMark()) || base.isSurrogate())
+      return false;
+   QChar const chars[2] = { base, mark };
+   QString const composed = QString(chars, 2).normalized(QString::NormalizationForm_C);
+   if (1 != composed.size())
+      return false;
+   outComposed = this->foldCharacter(composed[0]);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyword The keyword
+/// \return The folded keyword
+//**********************************************************************************************************************
+QString KeywordFolder::foldKeyword(QString const& keyword) const
+{
+   if (!flags_)
+      return keyword;
+   QString result = (flags_ & NormalizationFolding) ? keyword.normalized(QString::NormalizationForm_C) : keyword;
+   for (QChar& c: result)
+      c = this->foldCharacter(c);
+   return result;
+}
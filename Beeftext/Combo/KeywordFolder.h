@@ -0,0 +1,54 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the keyword folder used for case and normalization insensitive matching
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEYWORD_FOLDER_H
+#define BEEFTEXT_KEYWORD_FOLDER_H
+
+
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief A class that folds keywords and typed characters to a canonical form for insensitive matching
+///
+/// Keywords are folded once, when the keyword snapshot is built. Typed characters are folded one at a time, as they
+/// enter the typed text buffer, using a table of all UTF-16 code units that is computed when the flags change. Case
+/// folding uses the simple (one to one) Unicode case folding. Normalization folding converts keywords to NFC, maps
+/// typed characters with a singleton canonical decomposition to their NFC form, and composes a typed combining mark
+/// with the preceding character when possible, so that text typed in NFC or NFD matches keywords in either form.
+//**********************************************************************************************************************
+class KeywordFolder
+{
+public: // data types
+   enum EFlag {
+      CaseFolding = 1 << 0, ///< Matching is case insensitive
+      NormalizationFolding = 1 << 1, ///< Matching is insensitive to the Unicode normalization form (NFC or NFD)
+   }; ///< The folding flags
+
+public: // member functions
+   explicit KeywordFolder(qint32 flags = 0); ///< Default constructor
+   KeywordFolder(KeywordFolder const&) = default; ///< Default copy constructor
+   KeywordFolder(KeywordFolder&&) = default; ///< Default move constructor
+   ~KeywordFolder() = default; ///< Default destructor
+   KeywordFolder& operator=(KeywordFolder const&) = default; ///< Default assignment operator
+   KeywordFolder& operator=(KeywordFolder&&) = default; ///< Default move assignment operator
+   qint32 flags() const; ///< Return the folding flags
+   void setFlags(qint32 flags); ///< Set the folding flags
+   bool isEnabled() const; ///< Check whether any folding is performed
+   QChar foldCharacter(QChar c) const; ///< Fold a typed character
+   bool composeCharacters(QChar base, QChar mark, QChar& outComposed) const; ///< Compose a typed combining mark with the preceding character
+   QString foldKeyword(QString const& keyword) const; ///< Fold a keyword
+
+private: // data members
+   qint32 flags_ { 0 }; ///< The folding flags
+   std::vector<ushort> table_; ///< The folded form of every UTF-16 code unit. Empty if no folding is performed
+};
+
+
+#endif // #ifndef BEEFTEXT_KEYWORD_FOLDER_H
@@ -0,0 +1,489 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of keyword index class used for combo matching
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeywordIndex.h"
+#include <algorithm>
+
+
+namespace {
+
+
+qint32 const kEmptySlot = -1; ///< The value of an empty slot in the hash table of strict matching keywords
+qint32 const kDeletedSlot = -2; ///< The value of a slot whose keyword was removed from the hash table
+qint32 const kMinSlotCount = 16; ///< The minimum number of slots in the hash table. Must be a power of 2
+qint32 const kCodeUnitCount = 0x10000; ///< The number of distinct UTF-16 code units
+qint32 const kLastCharWordCount = kCodeUnitCount / 64; ///< The number of 64-bit words in the last character bitmap
+
+
+} // anonymous namespace
+
+
+std::atomic<quint64> KeywordIndex::revisionCounter_ { 0 };
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+KeywordIndex::KeywordIndex()
+   : nodes_(1),
+     revision_(newRevision()),
+     lastCharBits_(kLastCharWordCount, 0)
+{
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void KeywordIndex::clear()
+{
+   nodes_.assign(1, Node());
+   freeNodes_.clear();
+   entries_.clear();
+   freeIds_.clear();
+   size_ = 0;
+   lengthCounts_.clear();
+   maxKeywordLength_ = 0;
+   lastCharCounts_.clear();
+   lastCharBits_.assign(kLastCharWordCount, 0);
+   strictSlots_.clear();
+   strictSlotsInUse_ = 0;
+   strictCount_ = 0;
+   revision_ = newRevision();
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of keywords in the index
+//**********************************************************************************************************************
+qint32 KeywordIndex::size() const
+{
+   return size_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The upper bound (exclusive) of the IDs allocated by the index. This value can be used to size tables
+/// indexed by keyword ID
+//**********************************************************************************************************************
+qint32 KeywordIndex::idCapacity() const
+{
+   return qint32(entries_.size());
+}
+
+
+//**********************************************************************************************************************
+/// \return The length of the longest keyword in the index
+/// \return 0 if the index is empty
+//**********************************************************************************************************************
+qint32 KeywordIndex::maxKeywordLength() const
+{
+   return maxKeywordLength_;
+}
+
+
+//**********************************************************************************************************************
+/// The revision number changes every time the index is modified, and is never reused by another index, except by its
+/// copies, which have the same content. It can be used to detect that structures derived from the index are outdated.
+///
+/// \return The revision number of the index
+//**********************************************************************************************************************
+quint64 KeywordIndex::revision() const
+{
+   return revision_;
+}
+
+
+//**********************************************************************************************************************
+/// Most typed characters cannot end a keyword, so this single bit test lets the caller skip matching entirely for
+/// them.
+///
+/// \param[in] c The character
+/// \return true if and only if at least one keyword in the index ends with c
+//**********************************************************************************************************************
+bool KeywordIndex::canEndKeyword(QChar c) const
+{
+   ushort const u = c.unicode();
+   return 0 != (lastCharBits_[u >> 6] & (quint64(1) << (u & 63)));
+}
+
+
+//**********************************************************************************************************************
+/// \return The bitmap of the UTF-16 code units that end at least one keyword, as 1024 64-bit words. Bit b of word w
+/// is set if and only if a keyword ends with code unit 64 * w + b
+//**********************************************************************************************************************
+std::vector<quint64> const& KeywordIndex::lastCharacterBitmap() const
+{
+   return lastCharBits_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyword The keyword. Empty keywords are rejected
+/// \param[in] looseMatching Does the keyword use loose matching
+/// \return The ID of the keyword in the index
+/// \return -1 if the keyword is empty
+//**********************************************************************************************************************
+qint32 KeywordIndex::insert(QString const& keyword, bool looseMatching)
+{
+   if (keyword.isEmpty())
+      return -1;
+   qint32 const id = this->allocateId();
+   Entry& entry = entries_[id];
+   entry.keyword = keyword;
+   entry.looseMatching = looseMatching;
+   entry.used = true;
+   if (looseMatching)
+   {
+      qint32 node = 0;
+      for (qint32 i = keyword.size() - 1; i >= 0; --i)
+         node = this->getOrCreateChild(node, keyword[i]);
+      nodes_[node].looseIds.push_back(id);
+   }
+   else
+      this->insertStrict(id);
+   ++size_;
+   if (qint32(lengthCounts_.size()) <= keyword.size())
+      lengthCounts_.resize(keyword.size() + 1, 0);
+   ++lengthCounts_[keyword.size()];
+   maxKeywordLength_ = qMax(maxKeywordLength_, keyword.size());
+   if (lastCharCounts_.empty())
+      lastCharCounts_.resize(kCodeUnitCount, 0);
+   ushort const last = keyword[keyword.size() - 1].unicode();
+   if (1 == ++lastCharCounts_[last])
+      lastCharBits_[last >> 6] |= quint64(1) << (last & 63);
+   revision_ = newRevision();
+   return id;
+}
+
+
+//**********************************************************************************************************************
+/// Nodes that become useless after the removal are pruned from the trie and recycled.
+///
+/// \param[in] id The ID of the keyword to remove
+//**********************************************************************************************************************
+void KeywordIndex::remove(qint32 id)
+{
+   if ((id < 0) || (id >= qint32(entries_.size())) || (!entries_[id].used))
+      return;
+   Entry& entry = entries_[id];
+   QString const& keyword = entry.keyword;
+   --lengthCounts_[keyword.size()];
+   while ((maxKeywordLength_ > 0) && (0 == lengthCounts_[maxKeywordLength_]))
+      --maxKeywordLength_;
+   ushort const last = keyword[keyword.size() - 1].unicode();
+   if (0 == --lastCharCounts_[last])
+      lastCharBits_[last >> 6] &= ~(quint64(1) << (last & 63));
+   --size_;
+   revision_ = newRevision();
+   if (!entry.looseMatching)
+   {
+      this->removeStrict(id);
+      entry = Entry();
+      freeIds_.push_back(id);
+      return;
+   }
+
+   // we record the path from the root to the terminal node so that we can prune it afterwards
+   std::vector<qint32> path;
+   path.reserve(keyword.size() + 1);
+   path.push_back(0);
+   for (qint32 i = keyword.size() - 1; i >= 0; --i)
+   {
+      qint32 const node = this->child(path.back(), keyword[i]);
+      Q_ASSERT(node >= 0);
+      if (node < 0)
+         return;
+      path.push_back(node);
+   }
+
+   std::vector<qint32>& ids = nodes_[path.back()].looseIds;
+   ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+
+   for (qint32 i = qint32(path.size()) - 1; i > 0; --i)
+   {
+      Node& node = nodes_[path[i]];
+      if ((!node.edges.empty()) || (!node.looseIds.empty()))
+         break;
+      std::vector<Edge>& parentEdges = nodes_[path[i - 1]].edges;
+      parentEdges.erase(std::remove_if(parentEdges.begin(), parentEdges.end(),
+         [&](Edge const& edge) -> bool { return edge.node == path[i]; }), parentEdges.end());
+      freeNodes_.push_back(path[i]);
+   }
+
+   entry = Entry();
+   freeIds_.push_back(id);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] id The ID
+/// \return true if and only if the ID is currently used by a keyword in the index
+//**********************************************************************************************************************
+bool KeywordIndex::contains(qint32 id) const
+{
+   return (id >= 0) && (id < qint32(entries_.size())) && entries_[id].used;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] id The ID
+/// \return The keyword with the given ID
+/// \return A null string if the ID is not used
+//**********************************************************************************************************************
+QString KeywordIndex::keyword(qint32 id) const
+{
+   return this->contains(id) ? entries_[id].keyword : QString();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] id The ID
+/// \return true if and only if the keyword with the given ID uses loose matching
+//**********************************************************************************************************************
+bool KeywordIndex::isLooseMatching(qint32 id) const
+{
+   return this->contains(id) && entries_[id].looseMatching;
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function.
+///
+/// \param[in] input The input
+/// \param[out] outIds The IDs of the keywords matching the input
+//**********************************************************************************************************************
+void KeywordIndex::findMatches(QString const& input, QVector<qint32>& outIds) const
+{
+   this->findMatches(input.constData(), input.size(), false, outIds);
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function.
+///
+/// \param[in] input The input characters
+/// \param[in] length The number of characters in the input
+/// \param[in] inputIsTruncated If true, the input is only the end of the text to match, and strict matches are not
+/// reported
+/// \param[out] outIds The IDs of the keywords matching the input
+//**********************************************************************************************************************
+void KeywordIndex::findMatches(QChar const* input, qint32 length, bool inputIsTruncated,
+   QVector<qint32>& outIds) const
+{
+   this->findLooseMatches(input, length, outIds);
+   if (!inputIsTruncated)
+      this->findStrictMatches(input, length, outIds);
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function.
+///
+/// \param[in] input The input characters
+/// \param[in] length The number of characters in the input
+/// \param[out] outIds The IDs of the loose matching keywords that end the input
+//**********************************************************************************************************************
+void KeywordIndex::findLooseMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const
+{
+   qint32 node = 0;
+   for (qint32 i = length - 1; i >= 0; --i)
+   {
+      node = this->child(node, input[i]);
+      if (node < 0)
+         return;
+      for (qint32 const id: nodes_[node].looseIds)
+         outIds.push_back(id);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function. The cost of the function does not 
+/// depend on the number of keywords in the index.
+///
+/// \param[in] input The input characters
+/// \param[in] length The number of characters in the input
+/// \param[out] outIds The IDs of the strict matching keywords that are equal to the input
+//**********************************************************************************************************************
+void KeywordIndex::findStrictMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const
+{
+   if ((0 == strictCount_) || (length <= 0) || (length > maxKeywordLength_))
+      return;
+   quint32 const mask = quint32(strictSlots_.size()) - 1;
+   for (quint32 slot = hashKeyword(input, length) & mask; kEmptySlot != strictSlots_[slot]; slot = (slot + 1) & mask)
+   {
+      qint32 const id = strictSlots_[slot];
+      if (kDeletedSlot == id)
+         continue;
+      QString const& keyword = entries_[id].keyword;
+      if ((keyword.size() == length) && std::equal(input, input + length, keyword.constData()))
+         outIds.push_back(id);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The hash function is FNV-1a, applied to the UTF-16 code units of the keyword.
+///
+/// \param[in] keyword The keyword characters
+/// \param[in] length The number of characters in the keyword
+/// \return The hash of the keyword
+//**********************************************************************************************************************
+quint32 KeywordIndex::hashKeyword(QChar const* keyword, qint32 length)
+{
+   quint32 result = 2166136261u;
+   for (qint32 i = 0; i < length; ++i)
+   {
+      result ^= keyword[i].unicode();
+      result *= 16777619u;
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \return A new revision number
+//**********************************************************************************************************************
+quint64 KeywordIndex::newRevision()
+{
+   return ++revisionCounter_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] id The ID of the keyword, whose entry must already be filled
+//**********************************************************************************************************************
+void KeywordIndex::insertStrict(qint32 id)
+{
+   if (2 * (strictSlotsInUse_ + 1) > qint32(strictSlots_.size())) // we keep the load factor below 1/2
+      this->rehashStrict();
+   QString const& keyword = entries_[id].keyword;
+   quint32 const mask = quint32(strictSlots_.size()) - 1;
+   quint32 slot = hashKeyword(keyword.constData(), keyword.size()) & mask;
+   while ((kEmptySlot != strictSlots_[slot]) && (kDeletedSlot != strictSlots_[slot]))
+      slot = (slot + 1) & mask;
+   if (kEmptySlot == strictSlots_[slot])
+      ++strictSlotsInUse_;
+   strictSlots_[slot] = id;
+   ++strictCount_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] id The ID of the keyword, whose entry must still be filled
+//**********************************************************************************************************************
+void KeywordIndex::removeStrict(qint32 id)
+{
+   if (strictSlots_.empty())
+      return;
+   QString const& keyword = entries_[id].keyword;
+   quint32 const mask = quint32(strictSlots_.size()) - 1;
+   for (quint32 slot = hashKeyword(keyword.constData(), keyword.size()) & mask; kEmptySlot != strictSlots_[slot];
+      slot = (slot + 1) & mask)
+   {
+      if (id != strictSlots_[slot])
+         continue;
+      strictSlots_[slot] = kDeletedSlot; // the slot cannot be emptied without breaking the probe sequences
+      --strictCount_;
+      return;
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The new table is sized for the current number of keywords, and deleted slots are discarded.
+//**********************************************************************************************************************
+void KeywordIndex::rehashStrict()
+{
+   qint32 slotCount = kMinSlotCount;
+   while (slotCount < 4 * (strictCount_ + 1))
+      slotCount *= 2;
+   std::vector<qint32> oldSlots(size_t(slotCount), kEmptySlot);
+   oldSlots.swap(strictSlots_);
+   strictSlotsInUse_ = 0;
+   strictCount_ = 0;
+   for (qint32 const id: oldSlots)
+      if (id >= 0)
+         this->insertStrict(id);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] node The index of the node
+/// \param[in] c The character
+/// \return The index of the child node
+/// \return -1 if the node has no child for the given character
+//**********************************************************************************************************************
+qint32 KeywordIndex::child(qint32 node, QChar c) const
+{
+   std::vector<Edge> const& edges = nodes_[node].edges;
+   std::vector<Edge>::const_iterator const it = std::lower_bound(edges.begin(), edges.end(), c,
+      [](Edge const& edge, QChar ch) -> bool { return edge.c < ch; });
+   return ((it != edges.end()) && (it->c == c)) ? it->node : -1;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] node The index of the node
+/// \param[in] c The character
+/// \return The index of the child node
+//**********************************************************************************************************************
+qint32 KeywordIndex::getOrCreateChild(qint32 node, QChar c)
+{
+   {
+      std::vector<Edge> const& edges = nodes_[node].edges;
+      std::vector<Edge>::const_iterator const it = std::lower_bound(edges.begin(), edges.end(), c,
+         [](Edge const& edge, QChar ch) -> bool { return edge.c < ch; });
+      if ((it != edges.end()) && (it->c == c))
+         return it->node;
+   }
+   qint32 const result = this->allocateNode(); // note that allocating a node can invalidate references to nodes_
+   std::vector<Edge>& edges = nodes_[node].edges;
+   Edge edge;
+   edge.c = c;
+   edge.node = result;
+   edges.insert(std::lower_bound(edges.begin(), edges.end(), c,
+      [](Edge const& e, QChar ch) -> bool { return e.c < ch; }), edge);
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \return The index of the newly allocated node
+//**********************************************************************************************************************
+qint32 KeywordIndex::allocateNode()
+{
+   if (freeNodes_.empty())
+   {
+      nodes_.emplace_back();
+      return qint32(nodes_.size()) - 1;
+   }
+   qint32 const result = freeNodes_.back();
+   freeNodes_.pop_back();
+   nodes_[result] = Node();
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \return The newly allocated ID
+//**********************************************************************************************************************
+qint32 KeywordIndex::allocateId()
+{
+   if (freeIds_.empty())
+   {
+      entries_.emplace_back();
+      return qint32(entries_.size()) - 1;
+   }
+   qint32 const result = freeIds_.back();
+   freeIds_.pop_back();
+   return result;
+}
@@ -0,0 +1,108 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of keyword index class used for combo matching
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEYWORD_INDEX_H
+#define BEEFTEXT_KEYWORD_INDEX_H
+
+
+#include <vector>
+#include <atomic>
+
+
+//**********************************************************************************************************************
+/// \brief An index used to find all the keywords matching the end of an input string
+///
+/// Loose matching keywords (the input ends with the keyword) are stored in a trie of reversed keywords, so that a 
+/// single walk starting at the end of the input returns every loose match. Strict matching keywords (the input is 
+/// equal to the keyword) are stored in an open addressing hash table, so that they are found with a single lookup.
+/// Each inserted keyword is identified by a small integer ID that is allocated by the index and recycled when the
+/// keyword is removed.
+//**********************************************************************************************************************
+class KeywordIndex
+{
+public: // static member functions
+   static quint32 hashKeyword(QChar const* keyword, qint32 length); ///< Compute the hash of a keyword
+
+public: // member functions
+   KeywordIndex(); ///< Default constructor
+   KeywordIndex(KeywordIndex const&) = default; ///< Default copy constructor
+   KeywordIndex(KeywordIndex&&) = default; ///< Default move constructor
+   ~KeywordIndex() = default; ///< Default destructor
+   KeywordIndex& operator=(KeywordIndex const&) = default; ///< Default assignment operator
+   KeywordIndex& operator=(KeywordIndex&&) = default; ///< Default move assignment operator
+   void clear(); ///< Remove all keywords from the index
+   qint32 size() const; ///< Return the number of keywords in the index
+   qint32 idCapacity() const; ///< Return the upper bound (exclusive) of the IDs currently allocated by the index
+   qint32 maxKeywordLength() const; ///< Return the length of the longest keyword in the index
+   quint64 revision() const; ///< Return the revision number of the index
+   bool canEndKeyword(QChar c) const; ///< Check whether a character is the last character of a keyword in the index
+   std::vector<quint64> const& lastCharacterBitmap() const; ///< Return the bitmap of the last characters of the keywords
+   qint32 insert(QString const& keyword, bool looseMatching); ///< Insert a keyword in the index
+   void remove(qint32 id); ///< Remove a keyword from the index
+   bool contains(qint32 id) const; ///< Check whether an ID is currently in use in the index
+   QString keyword(qint32 id) const; ///< Retrieve the keyword with a given ID
+   bool isLooseMatching(qint32 id) const; ///< Check whether the keyword with a given ID uses loose matching
+   void findMatches(QString const& input, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the keywords matching an input
+   void findMatches(QChar const* input, qint32 length, bool inputIsTruncated, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the keywords matching an input
+   void findLooseMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the loose matching keywords matching an input
+   void findStrictMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the strict matching keywords equal to an input
+
+private: // data types
+   struct Edge
+   {
+      QChar c; ///< The character labelling the edge
+      qint32 node { 0 }; ///< The index of the target node
+   }; ///< An edge in the trie
+
+   struct Node
+   {
+      std::vector<Edge> edges; ///< The outgoing edges, sorted by character
+      std::vector<qint32> looseIds; ///< The IDs of the loose matching keywords ending on this node
+   }; ///< A node in the trie
+
+   struct Entry
+   {
+      QString keyword; ///< The keyword
+      bool looseMatching { false }; ///< Does the keyword use loose matching
+      bool used { false }; ///< Is the entry currently in use
+   }; ///< An entry in the keyword table
+
+private: // static member functions
+   static quint64 newRevision(); ///< Return a new, never used, revision number
+
+private: // static data members
+   static std::atomic<quint64> revisionCounter_; ///< The last revision number given to an index
+
+private: // member functions
+   void insertStrict(qint32 id); ///< Insert a strict matching keyword in the hash table
+   void removeStrict(qint32 id); ///< Remove a strict matching keyword from the hash table
+   void rehashStrict(); ///< Resize the hash table of strict matching keywords
+   qint32 child(qint32 node, QChar c) const; ///< Retrieve the child of a node for a given character
+   qint32 getOrCreateChild(qint32 node, QChar c); ///< Retrieve or create the child of a node for a given character
+   qint32 allocateNode(); ///< Allocate a new node
+   qint32 allocateId(); ///< Allocate a new keyword ID
+
+private: // data members
+   std::vector<Node> nodes_; ///< The nodes of the trie. The node at index 0 is the root
+   std::vector<qint32> freeNodes_; ///< The indexes of the nodes that can be recycled
+   std::vector<Entry> entries_; ///< The keyword table, indexed by ID
+   std::vector<qint32> freeIds_; ///< The keyword IDs that can be recycled
+   qint32 size_ { 0 }; ///< The number of keywords in the index
+   quint64 revision_ { 0 }; ///< The revision number of the index
+   std::vector<qint32> lengthCounts_; ///< The number of keywords in the index for each keyword length
+   qint32 maxKeywordLength_ { 0 }; ///< The length of the longest keyword in the index
+   std::vector<qint32> lastCharCounts_; ///< The number of keywords ending with each UTF-16 code unit
+   std::vector<quint64> lastCharBits_; ///< The bitmap of the UTF-16 code units that end at least one keyword
+   std::vector<qint32> strictSlots_; ///< The open addressing hash table of strict matching keyword IDs
+   qint32 strictSlotsInUse_ { 0 }; ///< The number of slots of the hash table that are not empty, including deleted ones
+   qint32 strictCount_ { 0 }; ///< The number of strict matching keywords in the hash table
+};
+
+
+#endif // #ifndef BEEFTEXT_KEYWORD_INDEX_H
@@ -0,0 +1,225 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the class matching the typed text against the keywords of a keyword snapshot
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeywordMatcher.h"
+
+
+namespace {
+
+
+qint32 const kCapacityFactor = 2; ///< The ratio between the capacity of the typed text buffer and the longest keyword
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] snapshot The keyword snapshot
+//**********************************************************************************************************************
+KeywordMatcher::KeywordMatcher(KeywordSnapshot const& snapshot)
+   : snapshot_(snapshot)
+{
+}
+
+
+//**********************************************************************************************************************
+/// \return The strategy used to find the keywords matching the typed text
+//**********************************************************************************************************************
+KeywordMatcher::EMatchingMode KeywordMatcher::matchingMode() const
+{
+   return matchingMode_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] mode The strategy used to find the keywords matching the typed text
+//**********************************************************************************************************************
+void KeywordMatcher::setMatchingMode(EMatchingMode mode)
+{
+   matchingMode_ = mode;
+   automatonIsInSync_ = false; // the automaton will be resynchronized with the typed text on next use
+}
+
+
+//**********************************************************************************************************************
+/// The typed text buffer is always large enough to hold twice the longest keyword of the snapshot. A larger minimum
+/// capacity can be requested for other kinds of keywords, such as emoji shortcodes.
+///
+/// \param[in] capacity The minimum capacity of the typed text buffer
+//**********************************************************************************************************************
+void KeywordMatcher::setMinimumCapacity(qint32 capacity)
+{
+   minimumCapacity_ = capacity;
+}
+
+
+//**********************************************************************************************************************
+/// \return The typed text buffer
+//**********************************************************************************************************************
+TypedTextBuffer const& KeywordMatcher::typedText() const
+{
+   return typedText_;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void KeywordMatcher::reset()
+{
+   typedText_.clear();
+}
+
+
+//**********************************************************************************************************************
+/// In streaming mode, the automaton is rebuilt if the keyword snapshot changed since it was built, or if the saved
+/// states are not in sync with the typed text. Otherwise a single transition is performed, whose cost is amortized
+/// constant.
+///
+/// \param[in] c The character
+//**********************************************************************************************************************
+void KeywordMatcher::appendCharacter(QChar c)
+{
+   this->updateCapacity();
+   if (StreamingMatching != matchingMode_)
+      typedText_.append(c);
+   else if (this->automatonIsUpToDate())
+      typedText_.append(c, automaton_.next(this->currentAutomatonState(), c));
+   else
+   {
+      typedText_.append(c);
+      this->rebuildAutomaton(); // the typed text, including c, is replayed
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The result is the same as appending the characters one at a time, but the snapshot and the automaton are checked
+/// once for the whole run, and the automaton is advanced in a tight loop.
+///
+/// \param[in] chars The characters
+/// \param[in] count The number of characters
+/// \param[in] typedLengths If not null, for each character, the number of UTF-16 characters typed by the user to
+/// produce it. If null, each character was typed as a single UTF-16 character
+//**********************************************************************************************************************
+void KeywordMatcher::appendCharacters(QChar const* chars, qint32 count, qint32 const* typedLengths)
+{
+   if (count <= 0)
+      return;
+   this->updateCapacity();
+   if (StreamingMatching != matchingMode_)
+   {
+      for (qint32 i = 0; i < count; ++i)
+         typedText_.append(chars[i], -1, typedLengths ? typedLengths[i] : 1);
+   }
+   else if (this->automatonIsUpToDate())
+   {
+      qint32 state = this->currentAutomatonState();
+      for (qint32 i = 0; i < count; ++i)
+      {
+         state = automaton_.next(state, chars[i]);
+         typedText_.append(chars[i], state, typedLengths ? typedLengths[i] : 1);
+      }
+   }
+   else
+   {
+      for (qint32 i = 0; i < count; ++i)
+         typedText_.append(chars[i], -1, typedLengths ? typedLengths[i] : 1);
+      this->rebuildAutomaton(); // the typed text, including the run, is replayed
+   }
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void KeywordMatcher::removeLastCharacter()
+{
+   typedText_.removeLast();
+}
+
+
+//**********************************************************************************************************************
+/// When the typed text buffer is truncated, only loose matching keywords can match. Matching IDs are appended to
+/// outIds, which is not cleared by the function.
+///
+/// \param[out] outIds The IDs of the keywords matching the typed text
+//**********************************************************************************************************************
+void KeywordMatcher::findMatches(QVector<qint32>& outIds)
+{
+   if (KeywordIndexMatching == matchingMode_)
+   {
+      snapshot_.findMatches(typedText_.data(), typedText_.size(), typedText_.isTruncated(), outIds);
+      return;
+   }
+
+   if (!this->automatonIsUpToDate())
+      this->rebuildAutomaton();
+   automaton_.findMatches(this->currentAutomatonState(), outIds);
+   if (!typedText_.isTruncated())
+      snapshot_.findStrictMatches(typedText_.data(), typedText_.size(), outIds);
+}
+
+
+//**********************************************************************************************************************
+/// The function is cheap when the capacity does not change, so it is called on every keystroke, which takes care of
+/// changes in the keyword snapshot.
+///
+/// The buffer holds at least twice the longest keyword: the extra room keeps the characters that precede the last
+/// ones typed, so that any keyword can still be matched after as many backspaces as the length of the longest
+/// keyword. The characters discarded to stay within the capacity cannot be restored by a backspace, so after more
+/// backspaces, keywords can only match the characters typed afterwards.
+//**********************************************************************************************************************
+void KeywordMatcher::updateCapacity()
+{
+   typedText_.setCapacity(qMax(kCapacityFactor * snapshot_.maxKeywordLength(), minimumCapacity_));
+}
+
+
+//**********************************************************************************************************************
+/// The typed text is replayed from the root state. Because the buffer can hold the longest keyword, the states
+/// obtained are the same as if the whole text typed since the last reset had been replayed.
+//**********************************************************************************************************************
+void KeywordMatcher::rebuildAutomaton()
+{
+   automaton_.build(snapshot_);
+   automatonRevision_ = snapshot_.revision();
+   automatonFoldingFlags_ = snapshot_.foldingFlags();
+   QChar const* const data = typedText_.data();
+   qint32 state = KeywordAutomaton::rootState;
+   for (qint32 i = 0; i < typedText_.size(); ++i)
+   {
+      state = automaton_.next(state, data[i]);
+      typedText_.setMatcherState(i, state);
+   }
+   automatonIsInSync_ = true;
+}
+
+
+//**********************************************************************************************************************
+/// \return The automaton state reached after reading the typed text
+//**********************************************************************************************************************
+qint32 KeywordMatcher::currentAutomatonState() const
+{
+   return typedText_.isEmpty() ? KeywordAutomaton::rootState : typedText_.matcherState(typedText_.size() - 1);
+}
+
+
+//**********************************************************************************************************************
+/// A snapshot rebuilt with different folding flags has the same revision, so the flags are compared as well.
+///
+/// \return true if and only if the automaton was built from the current keyword snapshot and the matcher states
+/// attached to the typed text are valid
+//**********************************************************************************************************************
+bool KeywordMatcher::automatonIsUpToDate() const
+{
+   return (automatonRevision_ == snapshot_.revision()) && (automatonFoldingFlags_ == snapshot_.foldingFlags()) &&
+      automatonIsInSync_;
+}
@@ -0,0 +1,68 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the class matching the typed text against the keywords of a keyword snapshot
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEYWORD_MATCHER_H
+#define BEEFTEXT_KEYWORD_MATCHER_H
+
+
+#include "KeywordSnapshot.h"
+#include "KeywordAutomaton.h"
+#include "TypedTextBuffer.h"
+
+
+//**********************************************************************************************************************
+/// \brief A class that keeps track of the text typed by the user and finds the keywords it matches
+///
+/// The matcher only depends on Qt Core. It is driven by the combo manager, and can also be used outside of the
+/// application, for instance for benchmarking. The keyword snapshot is not owned by the matcher and must outlive it.
+//**********************************************************************************************************************
+class KeywordMatcher
+{
+public: // data types
+   enum EMatchingMode {
+      KeywordIndexMatching = 0, ///< The typed text is looked up in the keyword snapshot after each keystroke
+      StreamingMatching = 1, ///< Each keystroke advances the saved state of an Aho-Corasick automaton
+   }; ///< The strategies used to find the keywords matching the typed text
+
+public: // member functions
+   explicit KeywordMatcher(KeywordSnapshot const& snapshot); ///< Default constructor
+   KeywordMatcher(KeywordMatcher const&) = delete; ///< Disabled copy constructor
+   KeywordMatcher(KeywordMatcher&&) = delete; ///< Disabled move constructor
+   ~KeywordMatcher() = default; ///< Default destructor
+   KeywordMatcher& operator=(KeywordMatcher const&) = delete; ///< Disabled assignment operator
+   KeywordMatcher& operator=(KeywordMatcher&&) = delete; ///< Disabled move assignment operator
+   EMatchingMode matchingMode() const; ///< Return the strategy used to find the keywords matching the typed text
+   void setMatchingMode(EMatchingMode mode); ///< Set the strategy used to find the keywords matching the typed text
+   void setMinimumCapacity(qint32 capacity); ///< Set the minimum capacity of the typed text buffer
+   TypedTextBuffer const& typedText() const; ///< Return the typed text buffer
+   void reset(); ///< Reset the typed text, for instance after a combo breaker
+   void appendCharacter(QChar c); ///< Append a character to the typed text
+   void appendCharacters(QChar const* chars, qint32 count, qint32 const* typedLengths = nullptr); ///< Append a run of characters to the typed text
+   void removeLastCharacter(); ///< Remove the last character of the typed text
+   void findMatches(QVector<qint32>& outIds); ///< Retrieve the IDs of the keywords matching the typed text
+
+private: // member functions
+   void updateCapacity(); ///< Adjust the capacity of the typed text buffer
+   void rebuildAutomaton(); ///< Rebuild the automaton and replay the typed text
+   qint32 currentAutomatonState() const; ///< Return the automaton state for the typed text
+   bool automatonIsUpToDate() const; ///< Check whether the automaton was built from the current keyword snapshot and is in sync with the typed text
+
+private: // data members
+   KeywordSnapshot const& snapshot_; ///< The keyword snapshot
+   EMatchingMode matchingMode_ { StreamingMatching }; ///< The strategy used to find the keywords matching the typed text
+   TypedTextBuffer typedText_; ///< The text typed since the last reset, bounded to twice the longest keyword
+   qint32 minimumCapacity_ { 0 }; ///< The minimum capacity of the typed text buffer
+   KeywordAutomaton automaton_; ///< The automaton used in streaming matching mode
+   quint64 automatonRevision_ { 0 }; ///< The revision of the keyword snapshot the automaton was built from
+   qint32 automatonFoldingFlags_ { 0 }; ///< The folding flags of the keyword snapshot the automaton was built from
+   bool automatonIsInSync_ { false }; ///< Are the matcher states attached to the typed text valid for the automaton
+};
+
+
+#endif // #ifndef BEEFTEXT_KEYWORD_MATCHER_H
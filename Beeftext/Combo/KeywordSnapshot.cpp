@@ -0,0 +1,386 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the immutable keyword snapshot read by the combo matcher
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeywordSnapshot.h"
+#include <algorithm>
+#include <iterator>
+
+
+namespace {
+
+
+qint32 const kEmptySlot = -1; ///< The value of an empty slot in the hash table of strict matching entries
+qint32 const kMinSlotCount = 16; ///< The minimum number of slots in the hash table. Must be a power of 2
+qint32 const kLastCharWordCount = 0x10000 / 64; ///< The number of 64-bit words in the last character bitmap
+
+
+//**********************************************************************************************************************
+/// \brief A range of entries sharing the same reversed prefix, used when building the trie
+//**********************************************************************************************************************
+struct EntryRange
+{
+   qint32 begin; ///< The index of the first entry in the range
+   qint32 end; ///< The index of the entry following the last one in the range
+   qint32 depth; ///< The length of the reversed prefix shared by the entries in the range
+};
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+KeywordSnapshot::KeywordSnapshot()
+   : lastCharBits_(kLastCharWordCount, 0),
+     nodeEdgeBegins_(2, 0),
+     nodeMatchBegins_(2, 0)
+{
+}
+
+
+//**********************************************************************************************************************
+/// Entries are stored in the order of the keyword IDs. The snapshot can be rebuilt in place, in which case the
+/// memory it already owns is reused.
+///
+/// \param[in] index The keyword index
+//**********************************************************************************************************************
+void KeywordSnapshot::build(KeywordIndex const& index)
+{
+   this->build(index, KeywordFolder());
+}
+
+
+//**********************************************************************************************************************
+/// The keywords are folded once, here, so that matching only has to fold the typed characters. When folding is
+/// enabled, the length of the longest keyword and the last character bitmap are computed from the folded keywords.
+///
+/// \param[in] index The keyword index
+/// \param[in] folder The folder used to fold the keywords
+//**********************************************************************************************************************
+void KeywordSnapshot::build(KeywordIndex const& index, KeywordFolder const& folder)
+{
+   arena_.clear();
+   offsets_.clear();
+   lengths_.clear();
+   flags_.clear();
+   keywordIds_.clear();
+   originalKeywords_.clear();
+   qint32 const count = index.size();
+   offsets_.reserve(size_t(count));
+   lengths_.reserve(size_t(count));
+   flags_.reserve(size_t(count));
+   keywordIds_.reserve(size_t(count));
+   originalKeywords_.reserve(size_t(count));
+   for (qint32 id = 0; id < index.idCapacity(); ++id)
+   {
+      if (!index.contains(id))
+         continue;
+      QString const originalKeyword = index.keyword(id);
+      QString const keyword = folder.foldKeyword(originalKeyword);
+      offsets_.push_back(qint32(arena_.size()));
+      lengths_.push_back(keyword.size());
+      flags_.push_back(index.isLooseMatching(id) ? LooseMatchingFlag : 0);
+      keywordIds_.push_back(id);
+      originalKeywords_.push_back(originalKeyword);
+      arena_.insert(arena_.end(), keyword.constData(), keyword.constData() + keyword.size());
+   }
+   revision_ = index.revision();
+   foldingFlags_ = folder.flags();
+   if (folder.isEnabled())
+   {
+      maxKeywordLength_ = lengths_.empty() ? 0 : *std::max_element(lengths_.begin(), lengths_.end());
+      lastCharBits_.assign(kLastCharWordCount, 0);
+      for (qint32 entry = 0; entry < this->size(); ++entry)
+      {
+         if (0 == lengths_[entry])
+            continue;
+         ushort const u = this->keywordData(entry)[lengths_[entry] - 1].unicode();
+         lastCharBits_[u >> 6] |= quint64(1) << (u & 63);
+      }
+   }
+   else
+   {
+      maxKeywordLength_ = index.maxKeywordLength();
+      lastCharBits_ = index.lastCharacterBitmap();
+   }
+   this->buildLooseTrie();
+   this->buildStrictTable();
+}
+
+
+//**********************************************************************************************************************
+/// \return The revision of the keyword index the snapshot was built from
+/// \return 0 if the snapshot was never built
+//**********************************************************************************************************************
+quint64 KeywordSnapshot::revision() const
+{
+   return revision_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The flags of the folder used to fold the keywords in the snapshot
+/// \return 0 if the keywords were not folded
+//**********************************************************************************************************************
+qint32 KeywordSnapshot::foldingFlags() const
+{
+   return foldingFlags_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of entries in the snapshot
+//**********************************************************************************************************************
+qint32 KeywordSnapshot::size() const
+{
+   return qint32(offsets_.size());
+}
+
+
+//**********************************************************************************************************************
+/// \return The length of the longest keyword in the snapshot
+/// \return 0 if the snapshot is empty
+//**********************************************************************************************************************
+qint32 KeywordSnapshot::maxKeywordLength() const
+{
+   return maxKeywordLength_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] c The character
+/// \return true if and only if at least one keyword in the snapshot ends with c
+//**********************************************************************************************************************
+bool KeywordSnapshot::canEndKeyword(QChar c) const
+{
+   ushort const u = c.unicode();
+   return 0 != (lastCharBits_[u >> 6] & (quint64(1) << (u & 63)));
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] entry The index of the entry
+/// \return A pointer to the characters of the keyword of the entry. The characters are not null terminated
+//**********************************************************************************************************************
+QChar const* KeywordSnapshot::keywordData(qint32 entry) const
+{
+   return arena_.data() + offsets_[entry];
+}
+
+
+//**********************************************************************************************************************
+/// The keyword shares its data with the keyword index, so keeping it in the snapshot does not copy its characters.
+///
+/// \param[in] entry The index of the entry
+/// \return The keyword of the entry as it is in the keyword index, before folding
+//**********************************************************************************************************************
+QString const& KeywordSnapshot::originalKeyword(qint32 entry) const
+{
+   return originalKeywords_[entry];
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] entry The index of the entry
+/// \return The length of the keyword of the entry
+//**********************************************************************************************************************
+qint32 KeywordSnapshot::keywordLength(qint32 entry) const
+{
+   return lengths_[entry];
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] entry The index of the entry
+/// \return true if and only if the keyword of the entry uses loose matching
+//**********************************************************************************************************************
+bool KeywordSnapshot::isLooseMatching(qint32 entry) const
+{
+   return 0 != (flags_[entry] & LooseMatchingFlag);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] entry The index of the entry
+/// \return The ID in the keyword index of the keyword of the entry
+//**********************************************************************************************************************
+qint32 KeywordSnapshot::keywordId(qint32 entry) const
+{
+   return keywordIds_[entry];
+}
+
+
+//**********************************************************************************************************************
+/// As entries are stored in the order of the keyword IDs, the entry is found using a binary search.
+///
+/// \param[in] keywordId The ID of the keyword in the keyword index
+/// \return The index of the entry of the keyword
+/// \return -1 if the snapshot does not contain the keyword
+//**********************************************************************************************************************
+qint32 KeywordSnapshot::findEntry(qint32 keywordId) const
+{
+   std::vector<qint32>::const_iterator const it = std::lower_bound(keywordIds_.begin(), keywordIds_.end(), keywordId);
+   return ((keywordIds_.end() == it) || (*it != keywordId)) ? -1 : qint32(it - keywordIds_.begin());
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function.
+///
+/// \param[in] input The input characters
+/// \param[in] length The number of characters in the input
+/// \param[in] inputIsTruncated If true, the input is only the end of the text to match, and strict matches are not
+/// reported
+/// \param[out] outIds The IDs of the keywords matching the input
+//**********************************************************************************************************************
+void KeywordSnapshot::findMatches(QChar const* input, qint32 length, bool inputIsTruncated,
+   QVector<qint32>& outIds) const
+{
+   this->findLooseMatches(input, length, outIds);
+   if (!inputIsTruncated)
+      this->findStrictMatches(input, length, outIds);
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function.
+///
+/// \param[in] input The input characters
+/// \param[in] length The number of characters in the input
+/// \param[out] outIds The IDs of the loose matching keywords that end the input
+//**********************************************************************************************************************
+void KeywordSnapshot::findLooseMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const
+{
+   qint32 node = 0;
+   for (qint32 i = length - 1; i >= 0; --i)
+   {
+      node = this->child(node, input[i]);
+      if (node < 0)
+         return;
+      for (qint32 m = nodeMatchBegins_[node]; m < nodeMatchBegins_[node + 1]; ++m)
+         outIds.push_back(matchIds_[m]);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// Matching IDs are appended to outIds, which is not cleared by the function.
+///
+/// \param[in] input The input characters
+/// \param[in] length The number of characters in the input
+/// \param[out] outIds The IDs of the strict matching keywords that are equal to the input
+//**********************************************************************************************************************
+void KeywordSnapshot::findStrictMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const
+{
+   if (strictSlots_.empty() || (length <= 0) || (length > maxKeywordLength_))
+      return;
+   quint32 const mask = quint32(strictSlots_.size()) - 1;
+   for (quint32 slot = KeywordIndex::hashKeyword(input, length) & mask; kEmptySlot != strictSlots_[slot];
+      slot = (slot + 1) & mask)
+   {
+      qint32 const entry = strictSlots_[slot];
+      if ((lengths_[entry] == length) && std::equal(input, input + length, arena_.data() + offsets_[entry]))
+         outIds.push_back(keywordIds_[entry]);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The loose matching entries are sorted by reversed keyword, so that the entries sharing a reversed prefix form a
+/// contiguous range, equal keywords being kept in ID order. The trie is then built breadth-first: the children of a
+/// node are created consecutively, which lets us store the edges of all nodes in a single array, the target of edge n
+/// being node n + 1.
+//**********************************************************************************************************************
+void KeywordSnapshot::buildLooseTrie()
+{
+   std::vector<qint32> entries;
+   for (qint32 entry = 0; entry < this->size(); ++entry)
+      if (this->isLooseMatching(entry))
+         entries.push_back(entry);
+   std::stable_sort(entries.begin(), entries.end(), [&](qint32 lhs, qint32 rhs) -> bool {
+      typedef std::reverse_iterator<QChar const*> RevIt;
+      QChar const* const l = this->keywordData(lhs);
+      QChar const* const r = this->keywordData(rhs);
+      return std::lexicographical_compare(RevIt(l + lengths_[lhs]), RevIt(l), RevIt(r + lengths_[rhs]), RevIt(r));
+   });
+
+   nodeEdgeBegins_.clear();
+   edgeChars_.clear();
+   nodeMatchBegins_.clear();
+   matchIds_.clear();
+   std::vector<EntryRange> queue; // the nodes, in breadth-first order
+   queue.push_back({ 0, qint32(entries.size()), 0 });
+   for (size_t n = 0; n < queue.size(); ++n)
+   {
+      EntryRange const range = queue[n]; // copied, as queue can be reallocated
+      nodeEdgeBegins_.push_back(qint32(edgeChars_.size()));
+      nodeMatchBegins_.push_back(qint32(matchIds_.size()));
+      qint32 i = range.begin;
+      for (; (i < range.end) && (lengths_[entries[i]] == range.depth); ++i) // shorter keywords are sorted first
+         matchIds_.push_back(keywordIds_[entries[i]]);
+      while (i < range.end)
+      {
+         QChar const c = this->keywordData(entries[i])[lengths_[entries[i]] - 1 - range.depth];
+         qint32 j = i + 1;
+         while ((j < range.end) && (c == this->keywordData(entries[j])[lengths_[entries[j]] - 1 - range.depth]))
+            ++j;
+         edgeChars_.push_back(c);
+         queue.push_back({ i, j, range.depth + 1 });
+         i = j;
+      }
+   }
+   nodeEdgeBegins_.push_back(qint32(edgeChars_.size()));
+   nodeMatchBegins_.push_back(qint32(matchIds_.size()));
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void KeywordSnapshot::buildStrictTable()
+{
+   qint32 strictCount = 0;
+   for (qint32 entry = 0; entry < this->size(); ++entry)
+      if (!this->isLooseMatching(entry))
+         ++strictCount;
+   strictSlots_.clear();
+   if (0 == strictCount)
+      return;
+   qint32 slotCount = kMinSlotCount;
+   while (slotCount < 2 * strictCount) // we keep the load factor at or below 1/2
+      slotCount *= 2;
+   strictSlots_.assign(size_t(slotCount), kEmptySlot);
+   quint32 const mask = quint32(slotCount) - 1;
+   for (qint32 entry = 0; entry < this->size(); ++entry)
+   {
+      if (this->isLooseMatching(entry))
+         continue;
+      quint32 slot = KeywordIndex::hashKeyword(this->keywordData(entry), lengths_[entry]) & mask;
+      while (kEmptySlot != strictSlots_[slot])
+         slot = (slot + 1) & mask;
+      strictSlots_[slot] = entry;
+   }
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] node The index of the node
+/// \param[in] c The character
+/// \return The index of the child node
+/// \return -1 if the node has no child for the given character
+//**********************************************************************************************************************
+qint32 KeywordSnapshot::child(qint32 node, QChar c) const
+{
+   QChar const* const begin = edgeChars_.data() + nodeEdgeBegins_[node];
+   QChar const* const end = edgeChars_.data() + nodeEdgeBegins_[node + 1];
+   QChar const* const it = std::lower_bound(begin, end, c);
+   return ((it != end) && (*it == c)) ? qint32(it - edgeChars_.data()) + 1 : -1;
+}
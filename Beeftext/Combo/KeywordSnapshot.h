@@ -0,0 +1,83 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the immutable keyword snapshot read by the combo matcher
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEYWORD_SNAPSHOT_H
+#define BEEFTEXT_KEYWORD_SNAPSHOT_H
+
+
+#include "KeywordIndex.h"
+#include "KeywordFolder.h"
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief A compact, immutable copy of the content of a keyword index, laid out for fast matching
+///
+/// The keyword index is optimized for incremental updates, and its nodes and keywords are scattered in memory. The
+/// snapshot stores the same keywords as a struct of arrays: a single UTF-16 arena holding the characters of all
+/// keywords, and parallel arrays for the offsets, lengths, flags and keyword IDs of the entries. The reversed trie of
+/// loose matching keywords and the hash table of strict matching keywords are flattened in the same way. The snapshot
+/// is rebuilt from the index when the keywords change, and is the only structure read when matching typed text.
+//**********************************************************************************************************************
+class KeywordSnapshot
+{
+public: // data types
+   enum EFlag {
+      LooseMatchingFlag = 1 << 0, ///< The keyword uses loose matching
+   }; ///< The flags of an entry
+
+public: // member functions
+   KeywordSnapshot(); ///< Default constructor
+   KeywordSnapshot(KeywordSnapshot const&) = default; ///< Default copy constructor
+   KeywordSnapshot(KeywordSnapshot&&) = default; ///< Default move constructor
+   ~KeywordSnapshot() = default; ///< Default destructor
+   KeywordSnapshot& operator=(KeywordSnapshot const&) = default; ///< Default assignment operator
+   KeywordSnapshot& operator=(KeywordSnapshot&&) = default; ///< Default move assignment operator
+   void build(KeywordIndex const& index); ///< Rebuild the snapshot from a keyword index
+   void build(KeywordIndex const& index, KeywordFolder const& folder); ///< Rebuild the snapshot from a keyword index, folding the keywords
+   quint64 revision() const; ///< Return the revision of the keyword index the snapshot was built from
+   qint32 foldingFlags() const; ///< Return the flags of the folder used to fold the keywords in the snapshot
+   qint32 size() const; ///< Return the number of entries in the snapshot
+   qint32 maxKeywordLength() const; ///< Return the length of the longest keyword in the snapshot
+   bool canEndKeyword(QChar c) const; ///< Check whether a character is the last character of a keyword in the snapshot
+   QChar const* keywordData(qint32 entry) const; ///< Return the characters of the keyword of an entry
+   QString const& originalKeyword(qint32 entry) const; ///< Return the keyword of an entry as it is in the keyword index
+   qint32 keywordLength(qint32 entry) const; ///< Return the length of the keyword of an entry
+   bool isLooseMatching(qint32 entry) const; ///< Check whether the keyword of an entry uses loose matching
+   qint32 keywordId(qint32 entry) const; ///< Return the ID of the keyword of an entry in the keyword index
+   qint32 findEntry(qint32 keywordId) const; ///< Return the entry of the keyword with a given ID in the keyword index
+   void findMatches(QChar const* input, qint32 length, bool inputIsTruncated, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the keywords matching an input
+   void findLooseMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the loose matching keywords matching an input
+   void findStrictMatches(QChar const* input, qint32 length, QVector<qint32>& outIds) const; ///< Retrieve the IDs of the strict matching keywords equal to an input
+
+private: // member functions
+   void buildLooseTrie(); ///< Build the flattened reversed trie of loose matching keywords
+   void buildStrictTable(); ///< Build the flattened hash table of strict matching keywords
+   qint32 child(qint32 node, QChar c) const; ///< Retrieve the child of a trie node for a given character
+
+private: // data members
+   quint64 revision_ { 0 }; ///< The revision of the keyword index the snapshot was built from
+   qint32 foldingFlags_ { 0 }; ///< The flags of the folder used to fold the keywords in the snapshot
+   qint32 maxKeywordLength_ { 0 }; ///< The length of the longest keyword in the snapshot
+   std::vector<QChar> arena_; ///< The characters of all keywords, stored contiguously
+   std::vector<qint32> offsets_; ///< The offset in the arena of the keyword of each entry
+   std::vector<qint32> lengths_; ///< The length of the keyword of each entry
+   std::vector<quint8> flags_; ///< The flags of each entry
+   std::vector<qint32> keywordIds_; ///< The ID in the keyword index of the keyword of each entry
+   std::vector<QString> originalKeywords_; ///< The keyword of each entry as it is in the keyword index, before folding
+   std::vector<quint64> lastCharBits_; ///< The bitmap of the UTF-16 code units that end at least one keyword
+   std::vector<qint32> nodeEdgeBegins_; ///< For each trie node, the index of its first edge in edgeChars_
+   std::vector<QChar> edgeChars_; ///< The characters labelling the trie edges, sorted for each node
+   std::vector<qint32> nodeMatchBegins_; ///< For each trie node, the index of its first match in matchIds_
+   std::vector<qint32> matchIds_; ///< The IDs of the loose matching keywords ending on each trie node
+   std::vector<qint32> strictSlots_; ///< The open addressing hash table of strict matching entries
+};
+
+
+#endif // #ifndef BEEFTEXT_KEYWORD_SNAPSHOT_H
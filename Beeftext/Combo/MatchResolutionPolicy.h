@@ -0,0 +1,29 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the policies used to pick a combo when several combos match the typed text
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_MATCH_RESOLUTION_POLICY_H
+#define BEEFTEXT_MATCH_RESOLUTION_POLICY_H
+
+
+//**********************************************************************************************************************
+/// \brief The policies used to pick a combo when several combos match the typed text
+///
+/// Except for the random policy, the result is deterministic: ties are broken by picking the combo with the longest
+/// keyword, then the first combo reported by the matcher.
+//**********************************************************************************************************************
+enum EMatchResolutionPolicy {
+   RandomResolution = 0, ///< A matching combo is picked at random
+   LongestKeywordResolution = 1, ///< The combo with the longest keyword is picked
+   MostRecentlyUsedResolution = 2, ///< The most recently used combo is picked
+   GroupPriorityResolution = 3, ///< The combo whose group comes first in the group list is picked
+   MatchResolutionPolicyCount = 4, ///< The number of policies
+}; ///< The policies used to pick a combo when several combos match the typed text
+
+
+#endif // #ifndef BEEFTEXT_MATCH_RESOLUTION_POLICY_H
@@ -0,0 +1,281 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the worker matching the typed text on the matching thread
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "MatchingWorker.h"
+#include <algorithm>
+
+
+namespace {
+
+
+qint32 const kBatchSize = 256; ///< The maximum number of keystroke events popped from the queue at once
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] queue The keystroke queue. The worker is its only consumer
+/// \param[in] parent The parent object of the worker
+//**********************************************************************************************************************
+MatchingWorker::MatchingWorker(KeystrokeQueue& queue, QObject* parent)
+   : QObject(parent),
+     queue_(queue),
+     matcher_(snapshot_)
+{
+   matchIds_.reserve(64);
+   matchKeywords_.reserve(64);
+   matchTypedLengths_.reserve(64);
+   batch_.resize(kBatchSize);
+   runChars_.resize(kBatchSize);
+   runTypedLengths_.resize(kBatchSize);
+}
+
+
+//**********************************************************************************************************************
+/// The snapshot is moved, so the caller does not pay for a copy. The previous pending snapshot, if any, is
+/// discarded.
+///
+/// \param[in] snapshot The keyword snapshot
+//**********************************************************************************************************************
+void MatchingWorker::setKeywordSnapshot(KeywordSnapshot&& snapshot)
+{
+   QMutexLocker lock(&pendingMutex_);
+   pendingSnapshot_ = std::move(snapshot);
+   hasPendingSnapshot_ = true;
+   hasPendingChanges_.store(true, std::memory_order_release);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] settings The settings
+//**********************************************************************************************************************
+void MatchingWorker::setSettings(Settings const& settings)
+{
+   QMutexLocker lock(&pendingMutex_);
+   pendingSettings_ = settings;
+   hasPendingChanges_.store(true, std::memory_order_release);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void MatchingWorker::stop()
+{
+   stopRequested_.store(true, std::memory_order_release);
+   queue_.wakeConsumer();
+}
+
+
+//**********************************************************************************************************************
+/// The function only returns when the worker is stopped. The queue is drained in batches, so a burst of keystrokes
+/// is processed in a single pass, after a single wake-up.
+//**********************************************************************************************************************
+void MatchingWorker::run()
+{
+   while (!stopRequested_.load(std::memory_order_acquire))
+   {
+      queue_.waitForEvents();
+      if (hasPendingChanges_.load(std::memory_order_acquire))
+         this->applyPendingChanges();
+      if (queue_.takeOverflow())
+         matcher_.reset(); // keystrokes were lost, the typed text cannot be trusted anymore
+      qint32 count = 0;
+      while ((count = queue_.pop(batch_.data(), qint32(batch_.size()))) > 0)
+         this->processEvents(batch_.data(), count);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The snapshot is swapped rather than copied. The matcher notices the change of revision and resynchronizes itself.
+/// When the folding flags change, the typed text, which was folded with the previous flags, is discarded.
+//**********************************************************************************************************************
+void MatchingWorker::applyPendingChanges()
+{
+   {
+      QMutexLocker lock(&pendingMutex_);
+      hasPendingChanges_.store(false, std::memory_order_relaxed);
+      if (hasPendingSnapshot_)
+      {
+         std::swap(snapshot_, pendingSnapshot_);
+         pendingSnapshot_ = KeywordSnapshot(); // we release the memory of the previous snapshot
+         hasPendingSnapshot_ = false;
+      }
+      settings_ = pendingSettings_;
+   }
+   if (folder_.flags() != settings_.foldingFlags)
+   {
+      folder_.setFlags(settings_.foldingFlags); // builds the folding table, outside of the lock
+      matcher_.reset();
+   }
+   settings_.emojiLeftDelimiter = folder_.foldKeyword(settings_.emojiLeftDelimiter);
+   settings_.emojiRightDelimiter = folder_.foldKeyword(settings_.emojiRightDelimiter);
+   if (matcher_.matchingMode() != settings_.matchingMode)
+      matcher_.setMatchingMode(settings_.matchingMode);
+   matcher_.setMinimumCapacity(settings_.emojiShortcodesEnabled ? settings_.emojiMaxKeywordLength +
+      settings_.emojiLeftDelimiter.size() + settings_.emojiRightDelimiter.size() : 0);
+}
+
+
+//**********************************************************************************************************************
+/// Consecutive characters are folded and gathered in a run that ends at the first character that can trigger a
+/// substitution. The matcher advances over the whole run at once, and the typed text is only checked at the end of
+/// the run, if it is such a character. Backspaces, breakers and triggers delimit the runs. A character composed with a
+/// combining mark accounts for the UTF-16 characters typed to produce both.
+///
+/// \param[in] events The events
+/// \param[in] count The number of events
+//**********************************************************************************************************************
+void MatchingWorker::processEvents(KeystrokeEvent const* events, qint32 count)
+{
+   qint32 i = 0;
+   while (i < count)
+   {
+      if (KeystrokeEvent::Character != events[i].type)
+      {
+         this->processEvent(events[i++]);
+         continue;
+      }
+
+      qint32 runSize = 0;
+      bool isCandidate = false;
+      QChar* const run = runChars_.data();
+      qint32* const runTypedLengths = runTypedLengths_.data();
+      while ((i < count) && (KeystrokeEvent::Character == events[i].type) && (!isCandidate))
+      {
+         QChar c = folder_.foldCharacter(events[i++].c);
+         qint32 typedLength = 1;
+         if (runSize > 0)
+         {
+            // the combining mark replaces the preceding character by a composed one
+            if (folder_.composeCharacters(run[runSize - 1], c, c))
+               typedLength += runTypedLengths[--runSize];
+         }
+         else
+         {
+            TypedTextBuffer const& typedText = matcher_.typedText();
+            if ((!typedText.isEmpty()) && folder_.composeCharacters(typedText.data()[typedText.size() - 1], c, c))
+            {
+               typedLength += typedText.typedLength(1);
+               matcher_.removeLastCharacter();
+            }
+         }
+         run[runSize] = c;
+         runTypedLengths[runSize++] = typedLength;
+         isCandidate = this->canTriggerSubstitution(c);
+      }
+      matcher_.appendCharacters(run, runSize, runTypedLengths);
+      if (isCandidate)
+         this->checkForSubstitution();
+   }
+}
+
+
+//**********************************************************************************************************************
+/// A substitution can only occur if the character ends a combo keyword or the right delimiter of emoji shortcodes.
+/// For the vast majority of keystrokes, this is ruled out by a single bit test.
+///
+/// \param[in] c The folded character
+/// \return true if and only if typing the character can trigger a substitution
+//**********************************************************************************************************************
+bool MatchingWorker::canTriggerSubstitution(QChar c) const
+{
+   return settings_.automaticSubstitution && (snapshot_.canEndKeyword(c) ||
+      (settings_.emojiShortcodesEnabled && settings_.emojiRightDelimiter.endsWith(c)));
+}
+
+
+//**********************************************************************************************************************
+/// Characters are processed by processEvents().
+///
+/// \param[in] event The event
+//**********************************************************************************************************************
+void MatchingWorker::processEvent(KeystrokeEvent const& event)
+{
+   switch (event.type)
+   {
+   case KeystrokeEvent::Backspace:
+      matcher_.removeLastCharacter();
+      break;
+   case KeystrokeEvent::SubstitutionTrigger:
+      if (!settings_.automaticSubstitution)
+         this->checkForSubstitution();
+      break;
+   case KeystrokeEvent::Character:
+      this->processEvents(&event, 1);
+      break;
+   case KeystrokeEvent::ComboBreaker:
+   default:
+      matcher_.reset();
+      break;
+   }
+}
+
+
+//**********************************************************************************************************************
+/// When combos match, the typed text is reset right away, as the GUI thread always either performs the substitution
+/// or cancels it. For each match, the keyword is reported, so that the GUI thread can look it up again if the combo
+/// list changed in the meantime, along with the number of UTF-16 characters the user typed for it, as it can differ
+/// from the length of the keyword when matching ignores normalization. When an emoji shortcode is found,
+/// the GUI thread resets the typed text only if the shortcode is valid, by pushing a combo breaker in the keystroke
+/// queue.
+//**********************************************************************************************************************
+void MatchingWorker::checkForSubstitution()
+{
+   matchIds_.clear();
+   matcher_.findMatches(matchIds_);
+   if (!matchIds_.isEmpty())
+   {
+      TypedTextBuffer const& typedText = matcher_.typedText();
+      matchKeywords_.clear();
+      matchTypedLengths_.clear();
+      for (qint32 const id: matchIds_)
+      {
+         qint32 const entry = snapshot_.findEntry(id);
+         matchKeywords_.push_back(entry < 0 ? QString() : snapshot_.originalKeyword(entry));
+         matchTypedLengths_.push_back(typedText.typedLength(entry < 0 ? 0 : snapshot_.keywordLength(entry)));
+      }
+      emit comboMatched(matchIds_, matchKeywords_, matchTypedLengths_, snapshot_.revision());
+      matcher_.reset();
+      return;
+   }
+   this->checkForEmojiShortcode();
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if the typed text ends with a delimited emoji shortcode
+//**********************************************************************************************************************
+bool MatchingWorker::checkForEmojiShortcode()
+{
+   if (!settings_.emojiShortcodesEnabled)
+      return false;
+   QString const& leftDelimiter = settings_.emojiLeftDelimiter;
+   QString const& rightDelimiter = settings_.emojiRightDelimiter;
+
+   // first we validate the right delimiter, if any. We work in place in the typed text buffer to avoid copying it
+   TypedTextBuffer const& typedText = matcher_.typedText();
+   QChar const* const begin = typedText.data();
+   QChar const* end = begin + typedText.size();
+   if ((typedText.size() < rightDelimiter.size()) ||
+      (!std::equal(rightDelimiter.begin(), rightDelimiter.end(), end - rightDelimiter.size())))
+      return false;
+   end -= rightDelimiter.size();
+
+   // we try to locate the left delimiter
+   QChar const* const left = std::find_end(begin, end, leftDelimiter.begin(), leftDelimiter.end());
+   if (end == left) // not found
+      return false;
+
+   emit emojiShortcodeTyped(QString(left + leftDelimiter.size(), qint32(end - (left + leftDelimiter.size()))));
+   return true;
+}
@@ -0,0 +1,90 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the worker matching the typed text on the matching thread
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_MATCHING_WORKER_H
+#define BEEFTEXT_MATCHING_WORKER_H
+
+
+#include "KeystrokeQueue.h"
+#include "KeywordMatcher.h"
+#include <atomic>
+
+
+//**********************************************************************************************************************
+/// \brief A worker that consumes keystrokes and looks for substitutions on a dedicated thread
+///
+/// The worker runs on the matching thread and is the only owner of the typed text. Keystrokes are received through
+/// a keystroke queue filled by the input manager, so they are processed even when the GUI thread is busy. Only
+/// confirmed matches are reported to the GUI thread, which performs the substitution. The keyword snapshot and the
+/// settings are published by the GUI thread and picked up by the worker before it processes the next keystrokes.
+//**********************************************************************************************************************
+class MatchingWorker: public QObject
+{
+   Q_OBJECT
+public: // data types
+   struct Settings
+   {
+      KeywordMatcher::EMatchingMode matchingMode { KeywordMatcher::StreamingMatching }; ///< The matching mode
+      bool automaticSubstitution { true }; ///< Is automatic substitution enabled
+      bool emojiShortcodesEnabled { false }; ///< Are emoji shortcodes enabled
+      QString emojiLeftDelimiter; ///< The left delimiter of emoji shortcodes
+      QString emojiRightDelimiter; ///< The right delimiter of emoji shortcodes
+      qint32 emojiMaxKeywordLength { 0 }; ///< The length of the longest emoji shortcode, without its delimiters
+      qint32 foldingFlags { 0 }; ///< The flags of the folder applied to typed characters. Must match the snapshot
+   }; ///< The settings used by the worker
+
+public: // member functions
+   explicit MatchingWorker(KeystrokeQueue& queue, QObject* parent = nullptr); ///< Default constructor
+   MatchingWorker(MatchingWorker const&) = delete; ///< Disabled copy constructor
+   MatchingWorker(MatchingWorker&&) = delete; ///< Disabled move constructor
+   ~MatchingWorker() = default; ///< Default destructor
+   MatchingWorker& operator=(MatchingWorker const&) = delete; ///< Disabled assignment operator
+   MatchingWorker& operator=(MatchingWorker&&) = delete; ///< Disabled move assignment operator
+   void setKeywordSnapshot(KeywordSnapshot&& snapshot); ///< Publish a new keyword snapshot (thread-safe)
+   void setSettings(Settings const& settings); ///< Publish new settings (thread-safe)
+   void stop(); ///< Request the worker to stop (thread-safe)
+
+public slots:
+   void run(); ///< Run the worker until it is stopped
+
+signals:
+   void comboMatched(QVector<qint32> const& keywordIds, QStringList const& keywords,
+      QVector<qint32> const& typedLengths, quint64 revision); ///< Signal emitted when combo keywords match the typed text
+   void emojiShortcodeTyped(QString const& shortcode); ///< Signal emitted when a delimited emoji shortcode was typed
+
+private: // member functions
+   void applyPendingChanges(); ///< Apply the snapshot and settings published by the GUI thread
+   void processEvents(KeystrokeEvent const* events, qint32 count); ///< Process a batch of keystroke events
+   void processEvent(KeystrokeEvent const& event); ///< Process a keystroke event
+   bool canTriggerSubstitution(QChar c) const; ///< Check whether typing a character can trigger a substitution
+   void checkForSubstitution(); ///< Check whether the typed text triggers a substitution
+   bool checkForEmojiShortcode(); ///< Check whether the typed text ends with a delimited emoji shortcode
+
+private: // data members
+   KeystrokeQueue& queue_; ///< The keystroke queue
+   std::atomic<bool> stopRequested_ { false }; ///< Was the worker requested to stop
+   std::atomic<bool> hasPendingChanges_ { false }; ///< Did the GUI thread publish a snapshot or settings
+   QMutex pendingMutex_; ///< The mutex protecting the pending snapshot and settings
+   KeywordSnapshot pendingSnapshot_; ///< The last snapshot published by the GUI thread
+   bool hasPendingSnapshot_ { false }; ///< Was a snapshot published since the last time changes were applied
+   Settings pendingSettings_; ///< The last settings published by the GUI thread
+   KeywordSnapshot snapshot_; ///< The keyword snapshot used by the worker
+   Settings settings_; ///< The settings used by the worker. The emoji delimiters are folded
+   KeywordFolder folder_; ///< The folder applied to typed characters
+   KeywordMatcher matcher_; ///< The matcher keeping track of the typed text. Must be declared after snapshot_
+   QVector<qint32> matchIds_; ///< The buffer receiving the IDs of the matching keywords
+   QStringList matchKeywords_; ///< The buffer receiving the keyword of each match
+   QVector<qint32> matchTypedLengths_; ///< The buffer receiving the number of UTF-16 characters typed for each match
+   std::vector<KeystrokeEvent> batch_; ///< The buffer receiving the events popped from the queue
+   std::vector<QChar> runChars_; ///< The buffer receiving the folded characters of a run. At least as large as batch_
+   std::vector<qint32> runTypedLengths_; ///< The number of UTF-16 characters typed for each character of a run
+};
+
+
+#endif // #ifndef BEEFTEXT_MATCHING_WORKER_H
@@ -0,0 +1,643 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the compiled form of combo snippets
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "SnippetTemplate.h"
+#include <algorithm>
+#include <utility>
+
+
+namespace {
+
+
+QString const kCursorVariable = "cursor"; ///< The cursor variable
+QString const kCustomDateTimeVariable = "dateTime:"; ///< The dateTime: variable
+QString const kComboVariable = "combo:"; ///< The combo: variable
+QString const kUpperVariable = "upper:"; ///< The upper: variable
+QString const kLowerVariable = "lower:"; ///< The lower: variable
+QString const kTrimVariable = "trim:"; ///< The trim: variable
+QString const kInputVariable = "input:"; ///< The input: variable
+QString const kEnvVarVariable = "envVar:"; ///< The envVar: variable
+qint32 const kEstimatedVariableLength = 32; ///< The estimated length of the value of a variable, used to preallocate the result
+ushort const kFirstMarkerCandidate = 0xe000; ///< The first character considered as a marker in HTML templates, the start of the private use area
+ushort const kLastMarkerCandidate = 0xf8ff; ///< The last character considered as a marker in HTML templates, the end of the private use area
+
+
+//**********************************************************************************************************************
+/// \param[in] c The character
+/// \return true if and only if the character ends a line
+//**********************************************************************************************************************
+bool isLineBreak(QChar c)
+{
+   return ('\n' == c) || ('\r' == c) || (QChar::ParagraphSeparator == c.unicode());
+}
+
+
+//**********************************************************************************************************************
+/// Line breaks (CR, LF, CRLF, line and paragraph separators) are converted to LF, and non-breaking spaces to regular
+/// spaces, as they are when a text is inserted in a text document and retrieved as plain text. Characters are copied
+/// by runs, between the characters that need to be converted.
+///
+/// \param[in] text The text
+/// \param[in,out] output The string the text is appended to
+//**********************************************************************************************************************
+void appendPlainText(QString const& text, QString& output)
+{
+   QChar const* const chars = text.constData();
+   qint32 const length = text.size();
+   qint32 runStart = 0;
+   for (qint32 i = 0; i < length; ++i)
+   {
+      QChar replacement;
+      switch (chars[i].unicode())
+      {
+      case '\r':
+      case QChar::ParagraphSeparator:
+      case QChar::LineSeparator:
+      case 0xfdd0: // QTextBeginningOfFrame
+      case 0xfdd1: // QTextEndOfFrame
+         replacement = QChar('\n');
+         break;
+      case QChar::Nbsp:
+         replacement = QChar(' ');
+         break;
+      default:
+         continue;
+      }
+      output.append(chars + runStart, i - runStart);
+      output.append(replacement);
+      if (('\r' == chars[i]) && (i + 1 < length) && ('\n' == chars[i + 1]))
+         ++i; // the LF of a CRLF sequence is dropped
+      runStart = i + 1;
+   }
+   output.append(chars + runStart, length - runStart);
+}
+
+
+//**********************************************************************************************************************
+/// The special HTML characters are escaped, and line breaks are converted to HTML line breaks. Characters are copied by
+/// runs, between the characters that need to be converted.
+///
+/// \param[in] text The text
+/// \param[in,out] output The string the escaped text is appended to
+//**********************************************************************************************************************
+void appendHtmlEscapedText(QString const& text, QString& output)
+{
+   QChar const* const chars = text.constData();
+   qint32 const length = text.size();
+   qint32 runStart = 0;
+   for (qint32 i = 0; i < length; ++i)
+   {
+      QLatin1String replacement("");
+      switch (chars[i].unicode())
+      {
+      case '<': replacement = QLatin1String("&lt;"); break;
+      case '>': replacement = QLatin1String("&gt;"); break;
+      case '&': replacement = QLatin1String("&amp;"); break;
+      case '"': replacement = QLatin1String("&quot;"); break;
+      case '\r':
+      case '\n':
+      case QChar::ParagraphSeparator:
+      case QChar::LineSeparator:
+         replacement = QLatin1String("<br />");
+         break;
+      default:
+         continue;
+      }
+      output.append(chars + runStart, i - runStart);
+      output.append(replacement);
+      if (('\r' == chars[i]) && (i + 1 < length) && ('\n' == chars[i + 1]))
+         ++i; // a CRLF sequence is a single line break
+      runStart = i + 1;
+   }
+   output.append(chars + runStart, length - runStart);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] text The text
+/// \return The first character of the private use area that does not appear in the text
+//**********************************************************************************************************************
+QChar markerCharacter(QString const& text)
+{
+   for (ushort c = kFirstMarkerCandidate; c < kLastMarkerCandidate; ++c)
+      if (!text.contains(QChar(c)))
+         return QChar(c);
+   return QChar(kLastMarkerCandidate);
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] parameter The variable parameter
+/// \return The parameter where the escaped characters \\} and \\\\ have been resolved
+//**********************************************************************************************************************
+QString SnippetTemplate::resolveEscaping(QString parameter)
+{
+   parameter.replace(R"(\\)", R"(\)");
+   parameter.replace(R"(\})", R"(})");
+   return parameter;
+}
+
+
+//**********************************************************************************************************************
+/// The search is equivalent to the regular expression #\{(.*?)(?<!\\)\} applied to each line of the text, but runs in
+/// linear time.
+///
+/// \param[in] text The text
+/// \param[in] from The position the search starts at
+/// \param[out] outStart The position of the #{ opening the variable
+/// \param[out] outEnd The position following the } closing the variable
+/// \return true if and only if a variable was found
+//**********************************************************************************************************************
+bool SnippetTemplate::findVariable(QString const& text, qint32 from, qint32& outStart, qint32& outEnd)
+{
+   QChar const* const chars = text.constData();
+   qint32 const length = text.size();
+   qint32 i = qMax(0, from);
+   while (i + 1 < length)
+   {
+      if (('#' != chars[i]) || ('{' != chars[i + 1]))
+      {
+         ++i;
+         continue;
+      }
+      qint32 j = i + 2;
+      for (; (j < length) && (!isLineBreak(chars[j])); ++j)
+      {
+         if (('}' == chars[j]) && ('\\' != chars[j - 1]))
+         {
+            outStart = i;
+            outEnd = j + 1;
+            return true;
+         }
+      }
+      i = j; // no variable can start before the end of the line
+   }
+   return false;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] variableType The type of variable
+/// \return true if and only if the variable is replaced by the snippet of another combo
+//**********************************************************************************************************************
+bool SnippetTemplate::isComboReference(EVariableType variableType)
+{
+   return (ComboVariable == variableType) || (UpperComboVariable == variableType) ||
+      (LowerComboVariable == variableType) || (TrimComboVariable == variableType);
+}
+
+
+//**********************************************************************************************************************
+/// The clipboard, date and time, input and environment variables are volatile.
+///
+/// \param[in] variableType The type of variable
+/// \return true if and only if the value of the variable can change between two evaluations
+//**********************************************************************************************************************
+bool SnippetTemplate::isVolatile(EVariableType variableType)
+{
+   switch (variableType)
+   {
+   case ClipboardVariable:
+   case DiscordEmojiVariable:
+   case DateVariable:
+   case TimeVariable:
+   case DateTimeVariable:
+   case CustomDateTimeVariable:
+   case InputVariable:
+   case EnvVarVariable:
+      return true;
+   default:
+      return false;
+   }
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] variable The variable, without the enclosing #{}
+/// \return The node of the variable
+//**********************************************************************************************************************
+SnippetTemplate::Node SnippetTemplate::variableNode(QString const& variable)
+{
+   Node node;
+   node.type = VariableNode;
+   node.text = variable;
+   if (kCursorVariable == variable)
+   {
+      node.type = CursorNode;
+      return node;
+   }
+   if ("clipboard" == variable)
+      node.variableType = ClipboardVariable;
+   else if ("discordemoji" == variable)
+      node.variableType = DiscordEmojiVariable;
+   else if ("date" == variable)
+      node.variableType = DateVariable;
+   else if ("time" == variable)
+      node.variableType = TimeVariable;
+   else if ("dateTime" == variable)
+      node.variableType = DateTimeVariable;
+   else if (variable.startsWith(kCustomDateTimeVariable))
+   {
+      node.variableType = CustomDateTimeVariable;
+      node.parameter = variable.mid(kCustomDateTimeVariable.size());
+   }
+   else if (variable.startsWith(kComboVariable))
+   {
+      node.variableType = ComboVariable;
+      node.parameter = resolveEscaping(variable.mid(kComboVariable.size()));
+   }
+   else if (variable.startsWith(kUpperVariable))
+   {
+      node.variableType = UpperComboVariable;
+      node.parameter = resolveEscaping(variable.mid(kUpperVariable.size()));
+   }
+   else if (variable.startsWith(kLowerVariable))
+   {
+      node.variableType = LowerComboVariable;
+      node.parameter = resolveEscaping(variable.mid(kLowerVariable.size()));
+   }
+   else if (variable.startsWith(kTrimVariable))
+   {
+      node.variableType = TrimComboVariable;
+      node.parameter = resolveEscaping(variable.mid(kTrimVariable.size()));
+   }
+   else if (variable.startsWith(kInputVariable))
+   {
+      node.variableType = InputVariable;
+      node.parameter = variable.mid(kInputVariable.size());
+   }
+   else if (variable.startsWith(kEnvVarVariable))
+   {
+      node.variableType = EnvVarVariable;
+      node.parameter = variable.mid(kEnvVarVariable.size());
+   }
+   return node;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] snippet The snippet
+/// \param[in] isHtml Is the snippet in HTML format
+//**********************************************************************************************************************
+SnippetTemplate::SnippetTemplate(QString const& snippet, bool isHtml)
+   : isHtml_(isHtml)
+{
+   if (isHtml)
+      this->compileHtml(snippet);
+   else
+      this->compilePlainText(snippet);
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if the template was compiled from a HTML snippet
+//**********************************************************************************************************************
+bool SnippetTemplate::isHtml() const
+{
+   return isHtml_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The nodes of the template
+//**********************************************************************************************************************
+std::vector<SnippetTemplate::Node> const& SnippetTemplate::nodes() const
+{
+   return nodes_;
+}
+
+
+//**********************************************************************************************************************
+/// A combo is referenced by the #{combo:}, #{upper:}, #{lower:} and #{trim:} variables.
+///
+/// \return The keywords of the combos referenced by the template, without duplicates, in order of first reference
+//**********************************************************************************************************************
+QStringList SnippetTemplate::referencedKeywords() const
+{
+   QStringList result;
+   for (Node const& node: nodes_)
+   {
+      if ((VariableNode != node.type) || (!isComboReference(node.variableType)) || result.contains(node.parameter))
+         continue;
+      result.append(node.parameter);
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// The variables referencing combos are not volatile, even if the referenced combos are.
+///
+/// \return true if and only if the template contains at least one volatile variable
+//**********************************************************************************************************************
+bool SnippetTemplate::hasVolatileVariables() const
+{
+   return nodes_.end() != std::find_if(nodes_.begin(), nodes_.end(), [](Node const& node) -> bool
+      { return (VariableNode == node.type) && isVolatile(node.variableType); });
+}
+
+
+//**********************************************************************************************************************
+/// The nodes are appended to the result in order. A cursor marker is only recorded if outCursorOffset is not null,
+/// otherwise it is evaluated as a variable. If several cursor markers are present, the last one is recorded.
+///
+/// \param[in] evaluator The function computing the value of the variables
+/// \param[out] outCancelled Was the evaluation of a variable cancelled, for instance by the user dismissing an input
+/// dialog
+/// \param[out] outCursorOffset If not null, and if the template contains a cursor marker, this variable receives the
+/// position of the cursor in the result
+/// \return The result of the evaluation, or a null string if the evaluation was cancelled
+//**********************************************************************************************************************
+QString SnippetTemplate::evaluatePlainText(VariableEvaluator const& evaluator, bool& outCancelled,
+   qint32* outCursorOffset) const
+{
+   Q_ASSERT(!isHtml_);
+   outCancelled = false;
+   QString result;
+   result.reserve(literalLength_ + kEstimatedVariableLength * variableCount_);
+   for (Node const& node: nodes_)
+   {
+      if (LiteralNode == node.type)
+      {
+         result.append(node.text);
+         continue;
+      }
+
+      if (outCursorOffset && (CursorNode == node.type))
+      {
+         *outCursorOffset = result.size();
+         continue;
+      }
+
+      bool isHtml = false;
+      QString const value = evaluator(node, isHtml, outCancelled);
+      if (outCancelled)
+         return QString();
+      // a rich text value, from the clipboard or a HTML combo, is reduced to its plain text
+      appendPlainText(isHtml ? QTextDocumentFragment::fromHtml(value).toPlainText() : value, result);
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// The variables are evaluated first. If none of the values is in HTML format, the escaped values are inserted
+/// between the HTML fragments of the template. Otherwise, the fragments are joined by the marker character and loaded
+/// in a text document, where each marker is replaced by the value of the corresponding variable. A cursor marker is
+/// only recorded if outCursorOffset is not null, otherwise it is evaluated as a variable.
+///
+/// \param[in] evaluator The function computing the value of the variables
+/// \param[out] outCancelled Was the evaluation of a variable cancelled, for instance by the user dismissing an input
+/// dialog
+/// \param[out] outCursorOffset If not null, and if the template contains a cursor marker, this variable receives the
+/// position of the cursor in the plain text of the result
+/// \param[out] outPlainText If not null, this variable receives the plain text of the result
+/// \return The result of the evaluation in HTML format, or a null string if the evaluation was cancelled
+//**********************************************************************************************************************
+QString SnippetTemplate::evaluateHtml(VariableEvaluator const& evaluator, bool& outCancelled, qint32* outCursorOffset,
+   QString* outPlainText) const
+{
+   Q_ASSERT(isHtml_);
+   if (usesDocument_)
+      return this->evaluateHtmlInDocument(evaluator, outCancelled, outCursorOffset, outPlainText);
+   outCancelled = false;
+   bool const needsPlainText = outCursorOffset || outPlainText;
+   QString plainText;
+   std::vector<std::pair<QString, bool>> values; // the values of the variables, and whether they are in HTML format
+   values.reserve(size_t(variableCount_));
+   bool hasHtmlValue = false;
+   for (Node const& node: nodes_)
+   {
+      if (LiteralNode == node.type)
+      {
+         if (needsPlainText)
+            plainText.append(node.plainText);
+         continue;
+      }
+
+      QString value;
+      bool isHtml = false;
+      if (outCursorOffset && (CursorNode == node.type))
+         *outCursorOffset = plainText.size();
+      else
+      {
+         value = evaluator(node, isHtml, outCancelled);
+         if (outCancelled)
+            return QString();
+      }
+      if (needsPlainText)
+         appendPlainText(isHtml ? QTextDocumentFragment::fromHtml(value).toPlainText() : value, plainText);
+      hasHtmlValue = hasHtmlValue || isHtml;
+      values.emplace_back(value, isHtml);
+   }
+   if (outPlainText)
+      *outPlainText = plainText;
+
+   QString result;
+   result.reserve(literalLength_ + kEstimatedVariableLength * variableCount_);
+   size_t valueIndex = 0;
+   for (Node const& node: nodes_)
+   {
+      if (LiteralNode == node.type)
+      {
+         result.append(node.text);
+         continue;
+      }
+      if (hasHtmlValue)
+         result.append(marker_);
+      else
+         appendHtmlEscapedText(values[valueIndex].first, result);
+      ++valueIndex;
+   }
+   if (!hasHtmlValue)
+      return result;
+
+   QTextDocument document;
+   document.setHtml(result);
+   QTextCursor cursor(&document);
+   for (std::pair<QString, bool> const& value: values)
+   {
+      cursor = document.find(QString(marker_), cursor); // the search starts after the previously inserted value
+      if (cursor.isNull())
+         break;
+      if (value.second)
+         cursor.insertHtml(value.first);
+      else
+         cursor.insertText(value.first);
+   }
+   return document.toHtml();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] snippet The snippet
+//**********************************************************************************************************************
+void SnippetTemplate::compilePlainText(QString const& snippet)
+{
+   qint32 pos = 0, start = 0, end = 0;
+   while (true)
+   {
+      bool const found = findVariable(snippet, pos, start, end);
+      if (!found)
+         start = snippet.size();
+      if (start > pos)
+      {
+         Node literal;
+         appendPlainText(snippet.mid(pos, start - pos), literal.text);
+         literalLength_ += literal.text.size();
+         nodes_.push_back(literal);
+      }
+      if (!found)
+         return;
+      nodes_.push_back(variableNode(snippet.mid(start + 2, end - start - 3)));
+      ++variableCount_;
+      pos = end;
+   }
+}
+
+
+//**********************************************************************************************************************
+/// Variables are searched in the text of each block of the document, so they are found the way they were with
+/// QTextDocument::find(). Each variable is then replaced by the marker character, with the format of the first
+/// character of the variable, and the document is serialized once.
+///
+/// \param[in] snippet The snippet
+//**********************************************************************************************************************
+void SnippetTemplate::compileHtml(QString const& snippet)
+{
+   QTextDocument document;
+   document.setHtml(snippet);
+   std::vector<Node> variables;
+   std::vector<std::pair<qint32, qint32>> ranges;
+   for (QTextBlock block = document.begin(); block.isValid(); block = block.next())
+   {
+      QString const text = block.text();
+      qint32 pos = 0, start = 0, end = 0;
+      while (findVariable(text, pos, start, end))
+      {
+         variables.push_back(variableNode(text.mid(start + 2, end - start - 3)));
+         ranges.emplace_back(block.position() + start, block.position() + end);
+         pos = end;
+      }
+   }
+
+   marker_ = markerCharacter(document.toPlainText() + document.toHtml());
+   // the variables are replaced backward, so that the positions of the remaining variables remain valid
+   for (std::vector<std::pair<qint32, qint32>>::const_reverse_iterator it = ranges.crbegin(); it != ranges.crend();
+      ++it)
+   {
+      QTextCursor cursor(&document);
+      cursor.setPosition(it->first + 1);
+      QTextCharFormat const format = cursor.charFormat();
+      cursor.setPosition(it->first);
+      cursor.setPosition(it->second, QTextCursor::KeepAnchor);
+      cursor.insertText(QString(marker_), format);
+   }
+
+   QStringList const htmlFragments = document.toHtml().split(marker_);
+   QStringList const plainFragments = document.toPlainText().split(marker_);
+   variableCount_ = qint32(variables.size());
+   if ((htmlFragments.size() != variableCount_ + 1) || (plainFragments.size() != htmlFragments.size()))
+   {
+      // the fragments do not match the variables, which will be replaced in a document at evaluation time
+      usesDocument_ = true;
+      html_ = snippet;
+      ranges_ = ranges;
+      nodes_ = variables;
+      return;
+   }
+   for (qint32 i = 0; i < htmlFragments.size(); ++i)
+   {
+      Node literal;
+      literal.text = htmlFragments[i];
+      literal.plainText = plainFragments.value(i);
+      literalLength_ += literal.text.size();
+      nodes_.push_back(literal);
+      if (i < qint32(variables.size()))
+         nodes_.push_back(variables[size_t(i)]);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// This is the evaluation path of the templates whose HTML serialization could not be split into fragments. The
+/// variables are evaluated in order, then replaced backward in a document loaded from the snippet, each value taking
+/// the format of its variable. A recorded cursor marker is replaced by the marker character, whose position in the
+/// plain text of the document gives the cursor offset, before being removed.
+///
+/// \param[in] evaluator The function computing the value of the variables
+/// \param[out] outCancelled Was the evaluation of a variable cancelled
+/// \param[out] outCursorOffset If not null, and if the template contains a cursor marker, this variable receives the
+/// position of the cursor in the plain text of the result
+/// \param[out] outPlainText If not null, this variable receives the plain text of the result
+/// \return The result of the evaluation in HTML format, or a null string if the evaluation was cancelled
+//**********************************************************************************************************************
+QString SnippetTemplate::evaluateHtmlInDocument(VariableEvaluator const& evaluator, bool& outCancelled,
+   qint32* outCursorOffset, QString* outPlainText) const
+{
+   Q_ASSERT(usesDocument_ && (nodes_.size() == ranges_.size()));
+   outCancelled = false;
+   std::vector<std::pair<QString, bool>> values; // the values of the variables, and whether they are in HTML format
+   values.reserve(nodes_.size());
+   qint32 cursorIndex = -1;
+   for (size_t i = 0; i < nodes_.size(); ++i)
+   {
+      QString value;
+      bool isHtml = false;
+      if (outCursorOffset && (CursorNode == nodes_[i].type))
+         cursorIndex = qint32(i); // if several cursor markers are present, the last one is recorded
+      else
+      {
+         value = evaluator(nodes_[i], isHtml, outCancelled);
+         if (outCancelled)
+            return QString();
+      }
+      values.emplace_back(value, isHtml);
+   }
+
+   QTextDocument document;
+   document.setHtml(html_);
+   for (qint32 i = qint32(ranges_.size()) - 1; i >= 0; --i)
+   {
+      QTextCursor cursor(&document);
+      cursor.setPosition(ranges_[size_t(i)].first + 1);
+      QTextCharFormat const format = cursor.charFormat();
+      cursor.setPosition(ranges_[size_t(i)].first);
+      cursor.setPosition(ranges_[size_t(i)].second, QTextCursor::KeepAnchor);
+      std::pair<QString, bool> const& value = values[size_t(i)];
+      if (i == cursorIndex)
+         cursor.insertText(QString(marker_), format);
+      else if (value.second)
+         cursor.insertHtml(value.first);
+      else
+         cursor.insertText(value.first, format);
+   }
+
+   QString plainText = document.toPlainText();
+   if (cursorIndex >= 0)
+   {
+      qint32 const offset = plainText.indexOf(marker_);
+      if (offset >= 0)
+      {
+         *outCursorOffset = offset;
+         plainText.remove(offset, 1);
+         QTextCursor cursor(&document);
+         cursor.setPosition(offset);
+         cursor.setPosition(offset + 1, QTextCursor::KeepAnchor);
+         cursor.removeSelectedText();
+      }
+   }
+   if (outPlainText)
+      *outPlainText = plainText;
+   return document.toHtml();
+}
@@ -0,0 +1,120 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the compiled form of combo snippets
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_SNIPPET_TEMPLATE_H
+#define BEEFTEXT_SNIPPET_TEMPLATE_H
+
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief The compiled form of a snippet, a sequence of literal runs, cursor markers and variables
+///
+/// A snippet is parsed once when it is compiled, so evaluating it only requires walking its nodes. A variable is
+/// delimited by #{ and the first } that is not preceded by a backslash, and cannot span several lines.
+///
+/// Plain text templates are evaluated without a text document: the literal runs and the values of the variables are
+/// appended to a single preallocated string. Line breaks and non-breaking spaces are normalized the way a text document
+/// does, so the result is identical to the plain text of a document the snippet would have been evaluated into.
+///
+/// HTML snippets are parsed once, when the template is compiled. Each variable is replaced in the document by a marker
+/// character, and the HTML serialization of the document is split at the markers into a list of fragments, so that
+/// the literal runs keep their formatting, and the value of each variable takes the formatting of the variable.
+/// Evaluating the template concatenates the fragments and the escaped values of the variables into a single string.
+/// Only values that are themselves in HTML format require the result to be loaded into a text document. If the marker
+/// character also appears elsewhere in the serialization of the document, the fragments cannot be aligned with the
+/// variables, and the template falls back to replacing the variables in a text document at evaluation time.
+//**********************************************************************************************************************
+class SnippetTemplate
+{
+public: // data types
+   enum ENodeType
+   {
+      LiteralNode = 0, ///< A run of literal text
+      CursorNode = 1, ///< A #{cursor} marker
+      VariableNode = 2, ///< A variable
+   }; ///< Enumeration for the types of nodes
+
+   enum EVariableType
+   {
+      UnknownVariable = 0, ///< A variable that is not recognized, which evaluates to itself
+      ClipboardVariable = 1, ///< The #{clipboard} variable
+      DiscordEmojiVariable = 2, ///< The #{discordemoji} variable
+      DateVariable = 3, ///< The #{date} variable
+      TimeVariable = 4, ///< The #{time} variable
+      DateTimeVariable = 5, ///< The #{dateTime} variable
+      CustomDateTimeVariable = 6, ///< The #{dateTime:} variable
+      ComboVariable = 7, ///< The #{combo:} variable
+      UpperComboVariable = 8, ///< The #{upper:} variable
+      LowerComboVariable = 9, ///< The #{lower:} variable
+      TrimComboVariable = 10, ///< The #{trim:} variable
+      InputVariable = 11, ///< The #{input:} variable
+      EnvVarVariable = 12, ///< The #{envVar:} variable
+   }; ///< Enumeration for the types of variables
+
+   struct Node
+   {
+      ENodeType type { LiteralNode }; ///< The type of the node
+      QString text; ///< For variables, the variable without the enclosing #{}. For literals, the text, in HTML for HTML templates
+      QString plainText; ///< For literals of HTML templates, the plain text of the literal
+      EVariableType variableType { UnknownVariable }; ///< For variables, the type of the variable
+      QString parameter; ///< For variables, the parameter. For variables referencing a combo, the keyword of the combo, with escaped characters resolved
+   }; ///< A node of the template
+
+   typedef std::function<QString(Node const& variable, bool& outIsHtml, bool& outCancelled)> VariableEvaluator; ///< Type definition for the functions computing the value of variables
+
+public: // static member functions
+   static QString resolveEscaping(QString parameter); ///< Resolve the escaped characters in a variable parameter
+   static bool findVariable(QString const& text, qint32 from, qint32& outStart, qint32& outEnd); ///< Find the next variable in a text
+   static bool isComboReference(EVariableType variableType); ///< Check whether a type of variable references a combo
+   static bool isVolatile(EVariableType variableType); ///< Check whether the value of a type of variable can change between evaluations
+   static Node variableNode(QString const& variable); ///< Create the node of a variable
+
+public: // member functions
+   SnippetTemplate(QString const& snippet, bool isHtml); ///< Default constructor
+   SnippetTemplate(SnippetTemplate const&) = delete; ///< Disabled copy constructor
+   SnippetTemplate(SnippetTemplate&&) = delete; ///< Disabled move constructor
+   ~SnippetTemplate() = default; ///< Default destructor
+   SnippetTemplate& operator=(SnippetTemplate const&) = delete; ///< Disabled assignment operator
+   SnippetTemplate& operator=(SnippetTemplate&&) = delete; ///< Disabled move assignment operator
+   bool isHtml() const; ///< Check whether the template was compiled from a HTML snippet
+   std::vector<Node> const& nodes() const; ///< Return the nodes of the template
+   QStringList referencedKeywords() const; ///< Return the keywords of the combos referenced by the template
+   bool hasVolatileVariables() const; ///< Check whether the template contains variables whose value can change between evaluations
+   QString evaluatePlainText(VariableEvaluator const& evaluator, bool& outCancelled, 
+      qint32* outCursorOffset = nullptr) const; ///< Evaluate a plain text template
+   QString evaluateHtml(VariableEvaluator const& evaluator, bool& outCancelled, qint32* outCursorOffset = nullptr,
+      QString* outPlainText = nullptr) const; ///< Evaluate a HTML template
+
+private: // member functions
+   void compilePlainText(QString const& snippet); ///< Compile a plain text snippet
+   void compileHtml(QString const& snippet); ///< Compile a HTML snippet
+   QString evaluateHtmlInDocument(VariableEvaluator const& evaluator, bool& outCancelled, qint32* outCursorOffset,
+      QString* outPlainText) const; ///< Evaluate a HTML template by replacing its variables in a text document
+
+private: // data members
+   bool isHtml_ { false }; ///< Was the template compiled from a HTML snippet
+   std::vector<Node> nodes_; ///< The nodes
+   qint32 literalLength_ { 0 }; ///< The total length of the literal runs
+   qint32 variableCount_ { 0 }; ///< The number of variables and cursor markers
+   QChar marker_; ///< For HTML templates, the character that replaced the variables in the document
+   bool usesDocument_ { false }; ///< For HTML templates, are the variables replaced in a text document at evaluation time
+   QString html_; ///< For HTML templates evaluated in a text document, the snippet
+   std::vector<std::pair<qint32, qint32>> ranges_; ///< For HTML templates evaluated in a text document, the positions of the variables
+};
+
+
+typedef std::shared_ptr<SnippetTemplate const> SpSnippetTemplate; ///< Type definition for shared pointer to SnippetTemplate
+
+
+#endif // #ifndef BEEFTEXT_SNIPPET_TEMPLATE_H
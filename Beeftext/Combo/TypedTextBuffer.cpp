@@ -0,0 +1,200 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the fixed-capacity buffer holding the text typed by the user
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "TypedTextBuffer.h"
+#include <algorithm>
+#include <numeric>
+
+
+//**********************************************************************************************************************
+/// \param[in] capacity The capacity of the buffer
+//**********************************************************************************************************************
+TypedTextBuffer::TypedTextBuffer(qint32 capacity)
+{
+   this->setCapacity(capacity);
+}
+
+
+//**********************************************************************************************************************
+/// \return The capacity of the buffer
+//**********************************************************************************************************************
+qint32 TypedTextBuffer::capacity() const
+{
+   return capacity_;
+}
+
+
+//**********************************************************************************************************************
+/// If the buffer contains more characters than the new capacity, the oldest ones are discarded and the buffer is
+/// marked as truncated.
+///
+/// \param[in] capacity The new capacity of the buffer
+//**********************************************************************************************************************
+void TypedTextBuffer::setCapacity(qint32 capacity)
+{
+   capacity = qMax(capacity, 0);
+   if (capacity == capacity_)
+      return;
+   qint32 const kept = qMin(size_, capacity);
+   std::vector<QChar> chars(2 * size_t(capacity));
+   std::vector<qint32> matcherStates(2 * size_t(capacity), -1);
+   std::vector<qint32> typedLengths(2 * size_t(capacity), 1);
+   qint32 const first = begin_ + size_ - kept;
+   std::copy(chars_.begin() + first, chars_.begin() + first + kept, chars.begin());
+   std::copy(matcherStates_.begin() + first, matcherStates_.begin() + first + kept, matcherStates.begin());
+   std::copy(typedLengths_.begin() + first, typedLengths_.begin() + first + kept, typedLengths.begin());
+   chars_.swap(chars);
+   matcherStates_.swap(matcherStates);
+   typedLengths_.swap(typedLengths);
+   discardedCount_ += size_ - kept;
+   capacity_ = capacity;
+   begin_ = 0;
+   size_ = kept;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of characters in the buffer
+//**********************************************************************************************************************
+qint32 TypedTextBuffer::size() const
+{
+   return size_;
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if the buffer is empty
+//**********************************************************************************************************************
+bool TypedTextBuffer::isEmpty() const
+{
+   return 0 == size_;
+}
+
+
+//**********************************************************************************************************************
+/// When the buffer is truncated, the text it contains is only the end of the text typed since the buffer was last
+/// cleared. The buffer is no longer truncated once backspaces have removed all the discarded characters.
+///
+/// \return true if and only if characters typed before the content of the buffer have been discarded
+//**********************************************************************************************************************
+bool TypedTextBuffer::isTruncated() const
+{
+   return discardedCount_ > 0;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void TypedTextBuffer::clear()
+{
+   begin_ = 0;
+   size_ = 0;
+   discardedCount_ = 0;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] c The character
+/// \param[in] matcherState The state of the matcher after reading the character
+/// \param[in] typedLength The number of UTF-16 characters typed by the user to produce the character
+//**********************************************************************************************************************
+void TypedTextBuffer::append(QChar c, qint32 matcherState, qint32 typedLength)
+{
+   if (capacity_ <= 0)
+   {
+      ++discardedCount_;
+      return;
+   }
+   if (size_ == capacity_) // the buffer is full, we discard the oldest character
+   {
+      ++begin_;
+      --size_;
+      ++discardedCount_;
+   }
+   if (begin_ + size_ == qint32(chars_.size())) // the window reached the end of the storage, we move it back
+   {
+      std::copy(chars_.begin() + begin_, chars_.begin() + begin_ + size_, chars_.begin());
+      std::copy(matcherStates_.begin() + begin_, matcherStates_.begin() + begin_ + size_, matcherStates_.begin());
+      std::copy(typedLengths_.begin() + begin_, typedLengths_.begin() + begin_ + size_, typedLengths_.begin());
+      begin_ = 0;
+   }
+   chars_[begin_ + size_] = c;
+   matcherStates_[begin_ + size_] = matcherState;
+   typedLengths_[begin_ + size_] = typedLength;
+   ++size_;
+}
+
+
+//**********************************************************************************************************************
+/// The characters discarded to stay within the capacity are not restored. When the buffer is empty, the function
+/// removes one of them instead, and the buffer is no longer truncated once they have all been removed.
+//**********************************************************************************************************************
+void TypedTextBuffer::removeLast()
+{
+   if (size_ > 0)
+      --size_;
+   else if (discardedCount_ > 0)
+      --discardedCount_;
+}
+
+
+//**********************************************************************************************************************
+/// The pointer is invalidated by any non-const call on the buffer.
+///
+/// \return A pointer to the size() contiguous characters in the buffer
+//**********************************************************************************************************************
+QChar const* TypedTextBuffer::data() const
+{
+   return chars_.data() + begin_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] index The index of the character in the buffer
+/// \return The state of the matcher after reading the character
+/// \return -1 if the index is out of range
+//**********************************************************************************************************************
+qint32 TypedTextBuffer::matcherState(qint32 index) const
+{
+   return ((index >= 0) && (index < size_)) ? matcherStates_[begin_ + index] : -1;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] index The index of the character in the buffer
+/// \param[in] state The state of the matcher after reading the character
+//**********************************************************************************************************************
+void TypedTextBuffer::setMatcherState(qint32 index, qint32 state)
+{
+   if ((index >= 0) && (index < size_))
+      matcherStates_[begin_ + index] = state;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] count The number of characters at the end of the buffer. It is clamped to the size of the buffer
+/// \return The number of UTF-16 characters typed by the user to produce the last count characters of the buffer
+//**********************************************************************************************************************
+qint32 TypedTextBuffer::typedLength(qint32 count) const
+{
+   count = qBound(0, count, size_);
+   qint32 const end = begin_ + size_;
+   return std::accumulate(typedLengths_.begin() + end - count, typedLengths_.begin() + end, 0);
+}
+
+
+//**********************************************************************************************************************
+/// \return The content of the buffer as a string
+//**********************************************************************************************************************
+QString TypedTextBuffer::toString() const
+{
+   return QString(this->data(), size_);
+}
@@ -0,0 +1,65 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the fixed-capacity buffer holding the text typed by the user
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_TYPED_TEXT_BUFFER_H
+#define BEEFTEXT_TYPED_TEXT_BUFFER_H
+
+
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief A fixed-capacity buffer holding the last UTF-16 characters typed by the user
+///
+/// When the buffer is full, appending a character discards the oldest one, and the buffer is then marked as truncated.
+/// The characters are stored in a sliding window over a storage twice as large as the capacity, so that they are
+/// always contiguous in memory and can be matched without being copied. The window is moved back to the beginning
+/// of the storage when it reaches its end, which keeps the cost of appending a character constant (amortized).
+/// Nothing is allocated except when the capacity changes.
+///
+/// Each character carries the state of the matcher after this character was read, so that the matcher can resume
+/// from the previous character when the last one is removed. It also carries the number of UTF-16 characters the user
+/// typed to produce it, which differs from 1 when a combining mark was composed with the preceding character, so that
+/// the text to erase when substituting a keyword can be measured in the characters actually typed.
+//**********************************************************************************************************************
+class TypedTextBuffer
+{
+public: // member functions
+   explicit TypedTextBuffer(qint32 capacity = 0); ///< Default constructor
+   TypedTextBuffer(TypedTextBuffer const&) = default; ///< Default copy constructor
+   TypedTextBuffer(TypedTextBuffer&&) = default; ///< Default move constructor
+   ~TypedTextBuffer() = default; ///< Default destructor
+   TypedTextBuffer& operator=(TypedTextBuffer const&) = default; ///< Default assignment operator
+   TypedTextBuffer& operator=(TypedTextBuffer&&) = default; ///< Default move assignment operator
+   qint32 capacity() const; ///< Return the capacity of the buffer
+   void setCapacity(qint32 capacity); ///< Set the capacity of the buffer, keeping the most recent characters
+   qint32 size() const; ///< Return the number of characters in the buffer
+   bool isEmpty() const; ///< Check whether the buffer is empty
+   bool isTruncated() const; ///< Check whether characters typed before the content of the buffer have been discarded
+   void clear(); ///< Clear the buffer
+   void append(QChar c, qint32 matcherState = -1, qint32 typedLength = 1); ///< Append a character to the buffer
+   void removeLast(); ///< Remove the last character of the buffer
+   QChar const* data() const; ///< Return a pointer to the characters in the buffer
+   qint32 matcherState(qint32 index) const; ///< Return the matcher state attached to a character
+   void setMatcherState(qint32 index, qint32 state); ///< Set the matcher state attached to a character
+   qint32 typedLength(qint32 count) const; ///< Return the number of UTF-16 characters typed to produce the last characters of the buffer
+   QString toString() const; ///< Return the content of the buffer as a string
+
+private: // data members
+   std::vector<QChar> chars_; ///< The character storage
+   std::vector<qint32> matcherStates_; ///< The matcher state storage, parallel to the character storage
+   std::vector<qint32> typedLengths_; ///< The typed length storage, parallel to the character storage
+   qint32 capacity_ { 0 }; ///< The capacity of the buffer
+   qint32 begin_ { 0 }; ///< The position of the first character in the storage
+   qint32 size_ { 0 }; ///< The number of characters in the buffer
+   qint32 discardedCount_ { 0 }; ///< The number of characters discarded before the content of the buffer
+};
+
+
+#endif // #ifndef BEEFTEXT_TYPED_TEXT_BUFFER_H
@@ -111,6 +111,7 @@ void EmojiManager::loadEmojis()
 void EmojiManager::unloadEmojis()
 {
    emojis_.clear();
+   maxKeywordLength_ = 0;
 }
 
 
@@ -125,6 +126,16 @@ QString EmojiManager::emoji(QString const& keyword) const
 }
 
 
+//**********************************************************************************************************************
+/// \return The length of the longest emoji keyword
+/// \return 0 if no emoji is loaded
+//**********************************************************************************************************************
+qint32 EmojiManager::maxKeywordLength() const
+{
+   return maxKeywordLength_;
+}
+
+
 //**********************************************************************************************************************
 /// \param[in] appExeName 
 //**********************************************************************************************************************
@@ -213,6 +224,7 @@ bool EmojiManager::load(QString const& path)
          if (emoji.isEmpty())
             throw Exception("The emoji list file is invalid.");
          emojis_[it.key()] = emoji;
+         maxKeywordLength_ = qMax(maxKeywordLength_, it.key().size());
       }
    }
    catch (Exception const& e)
@@ -21,6 +21,7 @@ public: // static member functions
    void loadEmojis(); ///< Load the emoji list from file
    void unloadEmojis(); ///< Unload the emoji list
    QString emoji(QString const& keyword) const; ///< Retrieve the emoji associated to a keyword
+   qint32 maxKeywordLength() const; ///< Return the length of the longest emoji keyword
 
 public: // member functions
    EmojiManager(EmojiManager const&) = delete; ///< Disabled copy-constructor
@@ -37,6 +38,7 @@ private: // member functions
 
 private: // data members
    QHash<QString, QString> emojis_; ///< The list of emojis
+   qint32 maxKeywordLength_ { 0 }; ///< The length of the longest emoji keyword
    QStringList excludedApps_; ///< The list of applications where emoji should not be substituted
 };
 
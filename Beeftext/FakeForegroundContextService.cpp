@@ -0,0 +1,96 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the scriptable foreground context service that does not depend on the platform
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "FakeForegroundContextService.h"
+
+
+//**********************************************************************************************************************
+/// \return The current context
+//**********************************************************************************************************************
+ForegroundContext const& FakeForegroundContextService::context()
+{
+   ++contextQueryCount_;
+   return context_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The current keyboard layout
+//**********************************************************************************************************************
+quint64 FakeForegroundContextService::keyboardLayout()
+{
+   ++keyboardLayoutQueryCount_;
+   return keyboardLayout_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] context The context
+/// \param[in] keyboardLayout The keyboard layout of the foreground window
+//**********************************************************************************************************************
+void FakeForegroundContextService::setContext(ForegroundContext const& context, quint64 keyboardLayout)
+{
+   context_ = context;
+   keyboardLayout_ = keyboardLayout;
+   ++switchCount_;
+}
+
+
+//**********************************************************************************************************************
+/// The current context is not modified until advance() is called.
+///
+/// \param[in] script The script of contexts
+//**********************************************************************************************************************
+void FakeForegroundContextService::setScript(std::vector<Step> script)
+{
+   script_ = std::move(script);
+   nextStep_ = 0;
+}
+
+
+//**********************************************************************************************************************
+/// \return true if the context was switched
+/// \return false if the end of the script was reached, in which case the current context is not modified
+//**********************************************************************************************************************
+bool FakeForegroundContextService::advance()
+{
+   if (nextStep_ >= qint32(script_.size()))
+      return false;
+   Step const& step = script_[size_t(nextStep_++)];
+   this->setContext(step.context, step.keyboardLayout);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of context switches
+//**********************************************************************************************************************
+qint32 FakeForegroundContextService::switchCount() const
+{
+   return switchCount_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of calls to context()
+//**********************************************************************************************************************
+qint32 FakeForegroundContextService::contextQueryCount() const
+{
+   return contextQueryCount_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of calls to keyboardLayout()
+//**********************************************************************************************************************
+qint32 FakeForegroundContextService::keyboardLayoutQueryCount() const
+{
+   return keyboardLayoutQueryCount_;
+}
@@ -0,0 +1,63 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the scriptable foreground context service that does not depend on the platform
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_FAKE_FOREGROUND_CONTEXT_SERVICE_H
+#define BEEFTEXT_FAKE_FOREGROUND_CONTEXT_SERVICE_H
+
+
+#include "ForegroundContextService.h"
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief A foreground context service whose contexts are set by the caller
+///
+/// The service plays a script of foreground contexts, each switch standing for a change of foreground window, so
+/// that the code depending on the foreground application can be driven and timed headless. It also counts the
+/// queries, which allows checking that a code path does not query the context more often than expected. Until
+/// another service is installed, the application uses a service of this type with no context set, which reports that
+/// there is no foreground window.
+//**********************************************************************************************************************
+class FakeForegroundContextService: public ForegroundContextService
+{
+public: // data types
+   struct Step
+   {
+      ForegroundContext context; ///< The foreground context
+      quint64 keyboardLayout; ///< The keyboard layout of the foreground window
+   }; ///< A step of the script
+
+public: // member functions
+   FakeForegroundContextService() = default; ///< Default constructor
+   FakeForegroundContextService(FakeForegroundContextService const&) = delete; ///< Disabled copy constructor
+   FakeForegroundContextService(FakeForegroundContextService&&) = delete; ///< Disabled move constructor
+   ~FakeForegroundContextService() = default; ///< Default destructor
+   FakeForegroundContextService& operator=(FakeForegroundContextService const&) = delete; ///< Disabled assignment operator
+   FakeForegroundContextService& operator=(FakeForegroundContextService&&) = delete; ///< Disabled move assignment operator
+   ForegroundContext const& context() override; ///< Return the context of the foreground application
+   quint64 keyboardLayout() override; ///< Return the identifier of the keyboard layout of the foreground window
+   void setContext(ForegroundContext const& context, quint64 keyboardLayout = 0); ///< Set the current context
+   void setScript(std::vector<Step> script); ///< Set the script of contexts
+   bool advance(); ///< Switch to the next context of the script
+   qint32 switchCount() const; ///< Return the number of context switches
+   qint32 contextQueryCount() const; ///< Return the number of calls to context()
+   qint32 keyboardLayoutQueryCount() const; ///< Return the number of calls to keyboardLayout()
+
+private: // data members
+   ForegroundContext context_; ///< The current context
+   quint64 keyboardLayout_ { 0 }; ///< The current keyboard layout
+   std::vector<Step> script_; ///< The script of contexts
+   qint32 nextStep_ { 0 }; ///< The index of the next step of the script
+   qint32 switchCount_ { 0 }; ///< The number of context switches
+   qint32 contextQueryCount_ { 0 }; ///< The number of calls to context()
+   qint32 keyboardLayoutQueryCount_ { 0 }; ///< The number of calls to keyboardLayout()
+};
+
+
+#endif // #ifndef BEEFTEXT_FAKE_FOREGROUND_CONTEXT_SERVICE_H
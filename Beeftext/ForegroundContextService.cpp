@@ -0,0 +1,46 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the interface of the services providing the context of the foreground application
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "ForegroundContextService.h"
+#include "FakeForegroundContextService.h"
+
+
+//**********************************************************************************************************************
+/// If no service was set using setInstance(), a service reporting that there is no foreground window is returned.
+///
+/// \return The service used by the application
+//**********************************************************************************************************************
+ForegroundContextService& ForegroundContextService::instance()
+{
+   UpForegroundContextService const& service = installedInstance();
+   if (service)
+      return *service;
+   static FakeForegroundContextService emptyService;
+   return emptyService;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] service The service. If null, the application behaves as if there were no foreground window
+//**********************************************************************************************************************
+void ForegroundContextService::setInstance(UpForegroundContextService service)
+{
+   installedInstance() = std::move(service);
+}
+
+
+//**********************************************************************************************************************
+/// \return The service installed using setInstance(), which may be null
+//**********************************************************************************************************************
+UpForegroundContextService& ForegroundContextService::installedInstance()
+{
+   static UpForegroundContextService service;
+   return service;
+}
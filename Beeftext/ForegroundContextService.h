@@ -0,0 +1,61 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the interface of the services providing the context of the foreground application
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_FOREGROUND_CONTEXT_SERVICE_H
+#define BEEFTEXT_FOREGROUND_CONTEXT_SERVICE_H
+
+
+#include <memory>
+
+
+//**********************************************************************************************************************
+/// \brief The context of the application owning the foreground window
+//**********************************************************************************************************************
+struct ForegroundContext
+{
+   quint64 window { 0 }; ///< The handle of the foreground window, or 0 if there is no foreground window
+   quint32 processId { 0 }; ///< The ID of the process owning the foreground window
+   quint32 threadId { 0 }; ///< The ID of the thread owning the foreground window
+   QString executableFileName; ///< The file name of the executable of the process, e.g. "explorer.exe", or a null string if it is unknown
+   bool isBeeftext { false }; ///< Is the foreground window owned by Beeftext
+}; ///< The context of the application owning the foreground window
+
+
+class ForegroundContextService;
+typedef std::unique_ptr<ForegroundContextService> UpForegroundContextService; ///< Type definition for unique pointer to foreground context service
+
+
+//**********************************************************************************************************************
+/// \brief Interface for the services providing the context of the foreground application
+///
+/// Implementations cache the context, and only update it when the foreground window changes, so querying the
+/// context is cheap enough to be done while processing keystrokes. Services are used from the GUI thread only.
+//**********************************************************************************************************************
+class ForegroundContextService
+{
+public: // static member functions
+   static ForegroundContextService& instance(); ///< Return the service used by the application
+   static void setInstance(UpForegroundContextService service); ///< Set the service used by the application
+
+public: // member functions
+   ForegroundContextService() = default; ///< Default constructor
+   ForegroundContextService(ForegroundContextService const&) = delete; ///< Disabled copy constructor
+   ForegroundContextService(ForegroundContextService&&) = delete; ///< Disabled move constructor
+   virtual ~ForegroundContextService() = default; ///< Default destructor
+   ForegroundContextService& operator=(ForegroundContextService const&) = delete; ///< Disabled assignment operator
+   ForegroundContextService& operator=(ForegroundContextService&&) = delete; ///< Disabled move assignment operator
+   virtual ForegroundContext const& context() = 0; ///< Return the context of the foreground application
+   virtual quint64 keyboardLayout() = 0; ///< Return the identifier of the keyboard layout of the foreground window
+
+private: // static member functions
+   static UpForegroundContextService& installedInstance(); ///< Return the service installed using setInstance()
+};
+
+
+#endif // #ifndef BEEFTEXT_FOREGROUND_CONTEXT_SERVICE_H
@@ -11,21 +11,19 @@
 #define BEEFTEXT_INPUT_MANAGER_H
 
 
+#include "InputSource.h"
+#include "RecordingInputSource.h"
+#include "Combo/KeystrokeQueue.h"
+
+
 //**********************************************************************************************************************
 /// \brief An input manager capture input by keyboard and mouse and process the events 
+///
+/// The events are received from an input source, which is by default the one based on the low level hooks of Windows.
 //**********************************************************************************************************************
-class InputManager : public QObject
+class InputManager : public QObject, public InputSourceListener
 {
    Q_OBJECT
-public: // data types
-   enum { 
-      KeyboardStateSize = 256, ///< The size of the keyboard state array
-   }; 
-   struct KeyStroke {
-      quint32 virtualKey; ///< The virtual keyCode
-      quint32 scanCode; ///< The scanCode
-      quint8 keyboardState[KeyboardStateSize]; ///< The state of the keyboard at the moment the keystroke occurred
-   };
 public: // static member functions
    static InputManager& instance(); ///< Return the only allowed instance of the class
 
@@ -35,43 +33,29 @@ public: // member functions
    ~InputManager(); ///< Default destructor
    InputManager& operator=(InputManager const&) = delete; ///< Disabled assignment operator
    InputManager& operator=(InputManager&&) = delete; ///< Disabled move assignment operator
+   KeystrokeQueue& keystrokeQueue(); ///< Return the queue receiving the keystrokes processed by the matching thread
+   void setInputSource(UpInputSource source); ///< Replace the input source
+   bool startTraceRecording(QString const& path, QString* outErrorMessage = nullptr); ///< Start recording the input events to a keystroke trace file
+   qint32 stopTraceRecording(); ///< Stop recording the input events
+   bool isRecordingTrace() const; ///< Check whether the input events are being recorded
+   bool onKeyStroke(KeyStroke const& keyStroke) override; ///< The callback function called at every key event
+   void onMouseClick() override; ///< Process a mouse click event
 
 signals:
-   void comboBreakerTyped(); ///< Signal for combo breaking events
-   void characterTyped(QChar c); ///< Signal for character typed
-   void backspaceTyped(); ///< Signal for backspace typed
-   void substitutionShortcutTriggered();  ///< Signal emitted when the manual substitution shortcut is triggered
    void comboMenuShortcutTriggered(); ///< Signal emitted when the combo menu shortcut is triggered.
    void appEnableDisableShortcutTriggered(); ///< Signal emitted when the app enable/disable shortcut has been triggered.
 
 private: // member functions
    InputManager(); ///< Default constructor
-   bool onKeyboardEvent(KeyStroke const& keyStroke); ///< The callback function called at every key event
-   QString processKey(KeyStroke const& keyStroke, bool& outIsDeadKey); ///< Process a key stroke and return the generated characters 
-   static QString processKeyModern(KeyStroke const& keyStroke); ///< Process a key stroke and return the generated characters 
-   QString processKeyLegacy(KeyStroke const& keyStroke, bool& outIsDeadKey); ///< Process a key stroke and return the generated characters 
-   void onMouseClickEvent(int, WPARAM, LPARAM); ///< Process a mouse click event
-   bool isKeyboardHookEnable() const; ///< Is the keyboard hook enabled
-   void enableKeyboardHook(); ///< Enable the keyboard hook
-   void disableKeyboardHook(); ///< Disable the keyboard hook
    bool setKeyboardHookEnabled(bool enabled); ///< Enable or disable the keyboard hook
-   bool isMouseHookEnabled() const; ///< Is the mouse hook enabled
-   void enableMouseHook(); ///< Enable the mouse hook
-   void disableMouseHook(); ///< Disable the mouse hook
-   bool setMouseHookEnabled(bool enabled); ///< Enable or disable the keyboard hook
-
-private: // static member functions
-   static LRESULT CALLBACK keyboardProcedure(int nCode, WPARAM wParam, LPARAM lParam); ///< The keyboard event callback
-   static LRESULT CALLBACK mouseProcedure(int nCode, WPARAM wParam, LPARAM lParam); ///< The mouse event callback
-
+   void pushKeystrokeEvent(KeystrokeEvent::EType type, QChar c = QChar()); ///< Push an event in the keystroke queue
 
    friend void performTextSubstitution(qint32 charCount, QString const& newText, bool isHtml, qint32 cursorPos);
 
 private: // data members
-   HHOOK keyboardHook_ { nullptr }; ///< The handle to the keyboard hook used to be notified of keyboard events
-   HHOOK mouseHook_ { nullptr }; ///< The handle to the mouse hook used to be notified of mouse event
-   KeyStroke deadKey_ = { 0, 0, { 0 } }; ///< The currently active dead key
-   bool useLegacyKeyProcessing_ { false }; ///< Should we use the legacy key processing code
+   KeystrokeQueue keystrokeQueue_; ///< The queue receiving the keystrokes processed by the matching thread
+   UpInputSource inputSource_; ///< The input source
+   RecordingInputSource* recordingSource_ { nullptr }; ///< The input source if it is recording the events, or null
 };
 
 
@@ -0,0 +1,88 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the interface of the sources of keyboard and mouse input
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_INPUT_SOURCE_H
+#define BEEFTEXT_INPUT_SOURCE_H
+
+
+#include <memory>
+
+
+//**********************************************************************************************************************
+/// \brief A keystroke, as delivered by an input source
+//**********************************************************************************************************************
+struct KeyStroke
+{
+   enum {
+      KeyboardStateSize = 256, ///< The size of the keyboard state array
+   };
+   quint32 virtualKey; ///< The virtual keyCode
+   quint32 scanCode; ///< The scanCode
+   quint8 keyboardState[KeyboardStateSize]; ///< The state of the keyboard at the moment the keystroke occurred
+}; ///< A keystroke, as delivered by an input source
+
+
+//**********************************************************************************************************************
+/// \brief The fixed-size text produced by the translation of a keystroke
+//**********************************************************************************************************************
+struct KeyText
+{
+   enum {
+      Capacity = 10, ///< The maximum number of UTF-16 characters produced by a keystroke
+   };
+   wchar_t chars[Capacity]; ///< The characters. Only the first size characters are valid
+   qint32 size; ///< The number of characters
+}; ///< The fixed-size text produced by the translation of a keystroke
+
+
+//**********************************************************************************************************************
+/// \brief Interface for the receivers of the events delivered by an input source
+//**********************************************************************************************************************
+class InputSourceListener
+{
+public: // member functions
+   InputSourceListener() = default; ///< Default constructor
+   InputSourceListener(InputSourceListener const&) = delete; ///< Disabled copy constructor
+   InputSourceListener(InputSourceListener&&) = delete; ///< Disabled move constructor
+   virtual ~InputSourceListener() = default; ///< Default destructor
+   InputSourceListener& operator=(InputSourceListener const&) = delete; ///< Disabled assignment operator
+   InputSourceListener& operator=(InputSourceListener&&) = delete; ///< Disabled move assignment operator
+   virtual bool onKeyStroke(KeyStroke const& keyStroke) = 0; ///< Process a keystroke
+   virtual void onMouseClick() = 0; ///< Process a mouse click
+};
+
+
+//**********************************************************************************************************************
+/// \brief Interface for the sources of keyboard and mouse input consumed by the input manager
+///
+/// The events are delivered to the listener on the thread that started the source, which is the only producer of
+/// the keystroke queue. Because the text produced by a keystroke depends on the platform and on the keyboard layout
+/// that was active when the keystroke occurred, the translation of keystrokes is performed by the source.
+//**********************************************************************************************************************
+class InputSource
+{
+public: // member functions
+   InputSource() = default; ///< Default constructor
+   InputSource(InputSource const&) = delete; ///< Disabled copy constructor
+   InputSource(InputSource&&) = delete; ///< Disabled move constructor
+   virtual ~InputSource() = default; ///< Default destructor
+   InputSource& operator=(InputSource const&) = delete; ///< Disabled assignment operator
+   InputSource& operator=(InputSource&&) = delete; ///< Disabled move assignment operator
+   virtual void start(InputSourceListener& listener) = 0; ///< Start delivering events to a listener
+   virtual void stop() = 0; ///< Stop delivering events
+   virtual bool setKeyboardEventsEnabled(bool enabled) = 0; ///< Enable or disable the delivery of keyboard events
+   virtual void translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+      quint64& outKeyboardLayout) = 0; ///< Retrieve the text produced by a keystroke, and the keyboard layout used
+};
+
+
+typedef std::unique_ptr<InputSource> UpInputSource; ///< Type definition for unique pointer to input source
+
+
+#endif // #ifndef BEEFTEXT_INPUT_SOURCE_H
@@ -0,0 +1,67 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the lookup tables and types used to classify keystrokes in the keyboard hook
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeyClassification.h"
+
+
+//**********************************************************************************************************************
+/// The function is called from the keyboard hook, so it does not allocate. The events are pushed at once, so the
+/// consumer is woken up at most once, even if the keystroke produced several characters.
+///
+/// \param[in] text The text produced by the translation of the keystroke
+/// \param[in] queue The keystroke queue
+//**********************************************************************************************************************
+void enqueueKeyText(KeyText const& text, KeystrokeQueue& queue)
+{
+   KeystrokeEvent events[KeyText::Capacity];
+   qint32 const size = qBound<qint32>(0, text.size, KeyText::Capacity);
+   for (qint32 i = 0; i < size; ++i)
+   {
+      QChar const c(ushort(text.chars[i]));
+      KeystrokeEvent& event = events[i];
+      event.c = c;
+      if (QChar('\b') == c)
+         event.type = KeystrokeEvent::Backspace;
+      else if (c.isSpace() || (!c.isPrint()))
+         event.type = KeystrokeEvent::ComboBreaker;
+      else
+         event.type = KeystrokeEvent::Character;
+   }
+   queue.push(events, size);
+}
+
+
+//**********************************************************************************************************************
+/// This is the part of the processing of keystrokes that does not depend on the preferences, and it is shared by the
+/// input manager and the tools that replay keystrokes. It does not allocate.
+///
+/// \param[in] keyStroke The keystroke
+/// \param[in] source The input source that delivered the keystroke, and is used to translate it
+/// \param[in] queue The keystroke queue
+//**********************************************************************************************************************
+void enqueueKeyStroke(KeyStroke const& keyStroke, InputSource& source, KeystrokeQueue& queue)
+{
+   // on some layout (e.g. US International, direction key + alt lead to garbage char if ToUnicode is pressed, so
+   // we bypass normal processing for those keys(note this is different for the dead key issue described in
+   // WindowsInputSource::translateKey().
+   if (kBreakerVirtualKeys.contains(keyStroke.virtualKey))
+   {
+      KeystrokeEvent event;
+      event.type = KeystrokeEvent::ComboBreaker;
+      queue.push(event);
+      return;
+   }
+
+   bool isDeadKey = false;
+   KeyText text = { { 0 }, 0 };
+   quint64 keyboardLayout = 0;
+   source.translateKey(keyStroke, isDeadKey, text, keyboardLayout);
+   enqueueKeyText(text, queue);
+}
@@ -0,0 +1,104 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the lookup tables and types used to classify keystrokes in the keyboard hook
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEY_CLASSIFICATION_H
+#define BEEFTEXT_KEY_CLASSIFICATION_H
+
+
+#include "InputSource.h"
+#include "Combo/KeystrokeQueue.h"
+#include <cstddef>
+
+
+//**********************************************************************************************************************
+/// \brief The virtual key codes used by the keyboard hook
+///
+/// The values are the ones of the VK_* macros of the Windows API, which are not available on other platforms. They
+/// are checked against the macros when building the application.
+//**********************************************************************************************************************
+enum EVirtualKey {
+   VirtualKeyBack = 0x08, ///< The backspace key
+   VirtualKeyReturn = 0x0d, ///< The return key
+   VirtualKeyShift = 0x10, ///< The shift key
+   VirtualKeyControl = 0x11, ///< The control key
+   VirtualKeyMenu = 0x12, ///< The alt key
+   VirtualKeyCapital = 0x14, ///< The caps lock key
+   VirtualKeySpace = 0x20, ///< The space bar
+   VirtualKeyPrior = 0x21, ///< The page up key
+   VirtualKeyNext = 0x22, ///< The page down key
+   VirtualKeyEnd = 0x23, ///< The end key
+   VirtualKeyHome = 0x24, ///< The home key
+   VirtualKeyLeft = 0x25, ///< The left arrow key
+   VirtualKeyUp = 0x26, ///< The up arrow key
+   VirtualKeyRight = 0x27, ///< The right arrow key
+   VirtualKeyDown = 0x28, ///< The down arrow key
+   VirtualKeyInsert = 0x2d, ///< The insert key
+   VirtualKeyDelete = 0x2e, ///< The delete key
+   VirtualKeyLeftWin = 0x5b, ///< The left Windows key
+   VirtualKeyRightWin = 0x5c, ///< The right Windows key
+   VirtualKeyLeftShift = 0xa0, ///< The left shift key
+   VirtualKeyRightShift = 0xa1, ///< The right shift key
+   VirtualKeyLeftControl = 0xa2, ///< The left control key
+   VirtualKeyRightControl = 0xa3, ///< The right control key
+   VirtualKeyLeftMenu = 0xa4, ///< The left alt key
+   VirtualKeyRightMenu = 0xa5, ///< The right alt key
+   VirtualKeyPacket = 0xe7, ///< The pseudo-key used to send characters that are not produced by a key
+}; ///< The virtual key codes used by the keyboard hook
+
+
+//**********************************************************************************************************************
+/// \brief A set of virtual keys, stored as a 256-bit bitmap that is built at compile time
+//**********************************************************************************************************************
+class VirtualKeySet
+{
+public: // member functions
+   template <std::size_t N> constexpr explicit VirtualKeySet(quint8 const (&keys)[N]); ///< Constructor from an array of virtual keys
+   constexpr bool contains(quint32 virtualKey) const; ///< Check whether a virtual key is in the set
+
+private: // data members
+   quint32 bits_[8]; ///< The bitmap
+};
+
+
+//**********************************************************************************************************************
+/// \param[in] keys The virtual keys
+//**********************************************************************************************************************
+template <std::size_t N> constexpr VirtualKeySet::VirtualKeySet(quint8 const (&keys)[N])
+   : bits_ { 0, 0, 0, 0, 0, 0, 0, 0 }
+{
+   for (std::size_t i = 0; i < N; ++i)
+      bits_[keys[i] >> 5] |= quint32(1) << (keys[i] & 31);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] virtualKey The virtual key
+/// \return true if and only if the virtual key is in the set
+//**********************************************************************************************************************
+constexpr bool VirtualKeySet::contains(quint32 virtualKey) const
+{
+   return (virtualKey < 256) && (0 != (bits_[virtualKey >> 5] & (quint32(1) << (virtualKey & 31))));
+}
+
+
+constexpr quint8 kModifierVirtualKeys[] = { VirtualKeyShift, VirtualKeyLeftShift, VirtualKeyRightShift,
+   VirtualKeyControl, VirtualKeyLeftControl, VirtualKeyRightControl, VirtualKeyMenu, VirtualKeyLeftMenu,
+   VirtualKeyRightMenu, VirtualKeyRightWin, VirtualKeyLeftWin, VirtualKeyCapital }; ///< The keys whose state is fetched for each keystroke
+constexpr quint8 kIgnoredVirtualKeyArray[] = { VirtualKeyLeftShift, VirtualKeyRightShift, VirtualKeyCapital }; ///< The keys whose events are ignored
+constexpr quint8 kBreakerVirtualKeyArray[] = { VirtualKeyUp, VirtualKeyRight, VirtualKeyDown, VirtualKeyLeft,
+   VirtualKeyPrior, VirtualKeyNext, VirtualKeyHome, VirtualKeyEnd, VirtualKeyInsert, VirtualKeyDelete }; ///< The keys that are combo breakers and bypass the key translation
+constexpr VirtualKeySet kIgnoredVirtualKeys(kIgnoredVirtualKeyArray); ///< The set of keys whose events are ignored
+constexpr VirtualKeySet kBreakerVirtualKeys(kBreakerVirtualKeyArray); ///< The set of keys that are combo breakers
+
+
+void enqueueKeyText(KeyText const& text, KeystrokeQueue& queue); ///< Push the events corresponding to a translated keystroke
+void enqueueKeyStroke(KeyStroke const& keyStroke, InputSource& source, KeystrokeQueue& queue); ///< Translate a keystroke and push the corresponding events
+
+
+#endif // #ifndef BEEFTEXT_KEY_CLASSIFICATION_H
@@ -0,0 +1,40 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the interface of the translators of keystrokes into text
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEY_TRANSLATOR_H
+#define BEEFTEXT_KEY_TRANSLATOR_H
+
+
+#include "InputSource.h"
+
+
+//**********************************************************************************************************************
+/// \brief Interface for the translators of keystrokes into the text they produce
+///
+/// The keyboard layout is retrieved separately from the translation, so that the layout a translation was performed
+/// with is known by the caller, which can use it to cache translations.
+//**********************************************************************************************************************
+class KeyTranslator
+{
+public: // member functions
+   KeyTranslator() = default; ///< Default constructor
+   KeyTranslator(KeyTranslator const&) = delete; ///< Disabled copy constructor
+   KeyTranslator(KeyTranslator&&) = delete; ///< Disabled move constructor
+   virtual ~KeyTranslator() = default; ///< Default destructor
+   KeyTranslator& operator=(KeyTranslator const&) = delete; ///< Disabled assignment operator
+   KeyTranslator& operator=(KeyTranslator&&) = delete; ///< Disabled move assignment operator
+   virtual quint64 keyboardLayout() = 0; ///< Return the identifier of the keyboard layout keystrokes are currently translated with
+   virtual void translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey, KeyText& outText) = 0; ///< Retrieve the text produced by a keystroke with a keyboard layout
+};
+
+
+typedef std::unique_ptr<KeyTranslator> UpKeyTranslator; ///< Type definition for unique pointer to key translator
+
+
+#endif // #ifndef BEEFTEXT_KEY_TRANSLATOR_H
@@ -0,0 +1,309 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the reader and writer of keystroke trace files
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "KeystrokeTrace.h"
+
+
+namespace {
+
+
+char const kMagic[] = { 'B', 'T', 'K', 'T' }; ///< The magic number at the start of trace files
+quint8 const kFormatVersion = 1; ///< The version of the trace file format
+qint32 const kModifierCount = sizeof(kModifierVirtualKeys); ///< The number of keys whose state is recorded
+qint32 const kModifierByteCount = (2 * kModifierCount + 7) / 8; ///< The number of bytes storing the modifier states
+qint32 const kFlushThreshold = 16384; ///< The size of the buffer above which it is written to the file
+quint8 const kTypeMask = 0x03; ///< The mask of the record type in the tag of a record
+quint8 const kKeyStrokeRecord = 0; ///< The record type for keystrokes
+quint8 const kMouseClickRecord = 1; ///< The record type for mouse clicks
+quint8 const kKeyboardLayoutRecord = 2; ///< The record type for keyboard layout changes
+quint8 const kDeadKeyFlag = 0x04; ///< The flag of the tag of a record indicating a dead key
+
+
+//**********************************************************************************************************************
+/// \param[in] value The value
+/// \param[in,out] buffer The buffer the value is appended to
+//**********************************************************************************************************************
+void appendVarUInt(quint64 value, QByteArray& buffer)
+{
+   while (value >= 0x80)
+   {
+      buffer.append(char(quint8(value) | 0x80));
+      value >>= 7;
+   }
+   buffer.append(char(value));
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] data The data
+/// \param[in,out] pos The position of the value in the data, which is updated to point to the next byte
+/// \param[out] outValue The value
+/// \return true if and only if the value could be read
+//**********************************************************************************************************************
+bool readVarUInt(QByteArray const& data, qint32& pos, quint64& outValue)
+{
+   outValue = 0;
+   for (qint32 shift = 0; shift < 64; shift += 7)
+   {
+      if (pos >= data.size())
+         return false;
+      quint8 const byte = quint8(data[pos++]);
+      outValue |= quint64(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return true;
+   }
+   return false;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] data The data
+/// \param[in,out] pos The position of the byte in the data, which is updated to point to the next byte
+/// \param[out] outByte The byte
+/// \return true if and only if the byte could be read
+//**********************************************************************************************************************
+bool readByte(QByteArray const& data, qint32& pos, quint8& outByte)
+{
+   if (pos >= data.size())
+      return false;
+   outByte = quint8(data[pos++]);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] message The error message
+/// \param[out] outErrorMessage The variable receiving the error message, if not null
+/// \return false
+//**********************************************************************************************************************
+bool fail(QString const& message, QString* outErrorMessage)
+{
+   if (outErrorMessage)
+      *outErrorMessage = message;
+   return false;
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+KeystrokeTraceWriter::~KeystrokeTraceWriter()
+{
+   this->close();
+}
+
+
+//**********************************************************************************************************************
+/// If a file is already open, it is closed first.
+///
+/// \param[in] path The path of the trace file
+/// \param[out] outErrorMessage If not null and the function returns false, this variable receives an error message
+/// \return true if and only if the file was created
+//**********************************************************************************************************************
+bool KeystrokeTraceWriter::open(QString const& path, QString* outErrorMessage)
+{
+   this->close();
+   file_.setFileName(path);
+   if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate))
+      return fail(QString("The trace file '%1' could not be created.").arg(QDir::toNativeSeparators(path)),
+         outErrorMessage);
+   buffer_.clear();
+   buffer_.append(kMagic, sizeof(kMagic));
+   buffer_.append(char(kFormatVersion));
+   buffer_.append(char(kModifierCount));
+   lastTimestampUs_ = 0;
+   lastKeyboardLayout_ = 0;
+   eventCount_ = 0;
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if the trace file is open
+//**********************************************************************************************************************
+bool KeystrokeTraceWriter::isOpen() const
+{
+   return file_.isOpen();
+}
+
+
+//**********************************************************************************************************************
+/// Events must be written in chronological order. The call is ignored if the file is not open.
+///
+/// \param[in] event The event
+//**********************************************************************************************************************
+void KeystrokeTraceWriter::write(ReplayEvent const& event)
+{
+   if (!file_.isOpen())
+      return;
+   if (event.keyboardLayout != lastKeyboardLayout_)
+   {
+      buffer_.append(char(kKeyboardLayoutRecord));
+      appendVarUInt(event.keyboardLayout, buffer_);
+      lastKeyboardLayout_ = event.keyboardLayout;
+   }
+
+   bool const isKeyStroke = (ReplayEvent::KeyStrokeEvent == event.type);
+   buffer_.append(char((isKeyStroke ? kKeyStrokeRecord : kMouseClickRecord) |
+      ((isKeyStroke && event.isDeadKey) ? kDeadKeyFlag : 0)));
+   qint64 const timestampUs = event.timestampNs / 1000;
+   appendVarUInt(quint64(qMax<qint64>(0, timestampUs - lastTimestampUs_)), buffer_);
+   lastTimestampUs_ = qMax(lastTimestampUs_, timestampUs);
+   if (isKeyStroke)
+   {
+      appendVarUInt(event.virtualKey, buffer_);
+      appendVarUInt(event.scanCode, buffer_);
+      quint8 modifiers[kModifierByteCount] = { 0 };
+      for (qint32 i = 0; i < kModifierCount; ++i)
+      {
+         quint8 const state = event.modifierStates[i];
+         quint8 const bits = ((state & 0x80) ? 1 : 0) | ((state & 0x01) ? 2 : 0);
+         modifiers[(2 * i) / 8] |= quint8(bits << ((2 * i) % 8));
+      }
+      buffer_.append(reinterpret_cast<char const*>(modifiers), kModifierByteCount);
+      qint32 const size = qBound<qint32>(0, event.text.size, KeyText::Capacity);
+      buffer_.append(char(size));
+      for (qint32 i = 0; i < size; ++i)
+         appendVarUInt(quint16(event.text.chars[i]), buffer_);
+   }
+   ++eventCount_;
+   if (buffer_.size() >= kFlushThreshold)
+      this->flush();
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of events written since the file was opened
+//**********************************************************************************************************************
+qint32 KeystrokeTraceWriter::eventCount() const
+{
+   return eventCount_;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void KeystrokeTraceWriter::close()
+{
+   if (!file_.isOpen())
+      return;
+   this->flush();
+   file_.close();
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void KeystrokeTraceWriter::flush()
+{
+   if (file_.isOpen() && (!buffer_.isEmpty()))
+      file_.write(buffer_);
+   buffer_.clear();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] path The path of the trace file
+/// \param[out] outEvents The events
+/// \param[out] outErrorMessage If not null and the function returns false, this variable receives an error message
+/// \return true if and only if the trace was read successfully
+//**********************************************************************************************************************
+bool KeystrokeTraceReader::read(QString const& path, std::vector<ReplayEvent>& outEvents,
+   QString* outErrorMessage)
+{
+   QFile file(path);
+   if (!file.open(QIODevice::ReadOnly))
+      return fail(QString("The trace file '%1' could not be opened.").arg(QDir::toNativeSeparators(path)),
+         outErrorMessage);
+   return read(file.readAll(), outEvents, outErrorMessage);
+}
+
+
+//**********************************************************************************************************************
+/// The timestamps of the events are relative to the start of the recording.
+///
+/// \param[in] data The content of a trace file
+/// \param[out] outEvents The events
+/// \param[out] outErrorMessage If not null and the function returns false, this variable receives an error message
+/// \return true if and only if the trace was read successfully
+//**********************************************************************************************************************
+bool KeystrokeTraceReader::read(QByteArray const& data, std::vector<ReplayEvent>& outEvents,
+   QString* outErrorMessage)
+{
+   outEvents.clear();
+   qint32 const headerSize = sizeof(kMagic) + 2;
+   if ((data.size() < headerSize) || (!data.startsWith(QByteArray(kMagic, sizeof(kMagic)))))
+      return fail("The file is not a keystroke trace file.", outErrorMessage);
+   if (quint8(data[sizeof(kMagic)]) != kFormatVersion)
+      return fail("The version of the keystroke trace file is not supported.", outErrorMessage);
+   if (qint32(quint8(data[sizeof(kMagic) + 1])) != kModifierCount)
+      return fail("The keystroke trace file was recorded with an incompatible modifier key list.", outErrorMessage);
+
+   QString const truncatedMessage = "The keystroke trace file is truncated or corrupted.";
+   qint32 pos = headerSize;
+   qint64 timestampUs = 0;
+   quint64 keyboardLayout = 0;
+   while (pos < data.size())
+   {
+      quint8 tag = 0;
+      quint64 value = 0;
+      readByte(data, pos, tag);
+      quint8 const type = tag & kTypeMask;
+      if (kKeyboardLayoutRecord == type)
+      {
+         if (!readVarUInt(data, pos, keyboardLayout))
+            return fail(truncatedMessage, outErrorMessage);
+         continue;
+      }
+      if ((type != kKeyStrokeRecord) && (type != kMouseClickRecord))
+         return fail(truncatedMessage, outErrorMessage);
+      if (!readVarUInt(data, pos, value))
+         return fail(truncatedMessage, outErrorMessage);
+      timestampUs += qint64(value);
+      ReplayEvent event = (kMouseClickRecord == type) ? ReplayInputSource::mouseClickEvent() :
+         ReplayEvent { ReplayEvent::KeyStrokeEvent, 0, 0, { 0 }, false, { { 0 }, 0 }, 0, 0 };
+      event.timestampNs = timestampUs * 1000;
+      event.keyboardLayout = keyboardLayout;
+      if (kKeyStrokeRecord == type)
+      {
+         quint64 virtualKey = 0, scanCode = 0;
+         if ((!readVarUInt(data, pos, virtualKey)) || (!readVarUInt(data, pos, scanCode)) ||
+            (pos + kModifierByteCount >= data.size()))
+            return fail(truncatedMessage, outErrorMessage);
+         event.virtualKey = quint32(virtualKey);
+         event.scanCode = quint32(scanCode);
+         event.isDeadKey = (tag & kDeadKeyFlag);
+         for (qint32 i = 0; i < kModifierCount; ++i)
+         {
+            quint8 const bits = quint8(data[pos + (2 * i) / 8]) >> ((2 * i) % 8);
+            event.modifierStates[i] = ((bits & 1) ? 0x80 : 0) | ((bits & 2) ? 0x01 : 0);
+         }
+         pos += kModifierByteCount;
+         quint8 size = 0;
+         readByte(data, pos, size);
+         if (size > KeyText::Capacity)
+            return fail(truncatedMessage, outErrorMessage);
+         for (qint32 i = 0; i < size; ++i)
+         {
+            if (!readVarUInt(data, pos, value))
+               return fail(truncatedMessage, outErrorMessage);
+            event.text.chars[i] = wchar_t(quint16(value));
+         }
+         event.text.size = size;
+      }
+      outEvents.push_back(event);
+   }
+   return true;
+}
@@ -0,0 +1,73 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the reader and writer of keystroke trace files
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_KEYSTROKE_TRACE_H
+#define BEEFTEXT_KEYSTROKE_TRACE_H
+
+
+#include "ReplayInputSource.h"
+
+
+//**********************************************************************************************************************
+/// \brief A writer of keystroke trace files
+///
+/// A trace file is a compact binary stream of input events. Keystrokes are normalized: only the pressed and toggled
+/// states of the modifier keys are kept, along with the text the keystroke produced. Timestamps are stored as
+/// variable-length deltas in microseconds, and the keyboard layout is only stored when it changes. Events are
+/// buffered, and written to the file when the buffer is full or the writer is closed.
+//**********************************************************************************************************************
+class KeystrokeTraceWriter
+{
+public: // member functions
+   KeystrokeTraceWriter() = default; ///< Default constructor
+   KeystrokeTraceWriter(KeystrokeTraceWriter const&) = delete; ///< Disabled copy constructor
+   KeystrokeTraceWriter(KeystrokeTraceWriter&&) = delete; ///< Disabled move constructor
+   ~KeystrokeTraceWriter(); ///< Destructor
+   KeystrokeTraceWriter& operator=(KeystrokeTraceWriter const&) = delete; ///< Disabled assignment operator
+   KeystrokeTraceWriter& operator=(KeystrokeTraceWriter&&) = delete; ///< Disabled move assignment operator
+   bool open(QString const& path, QString* outErrorMessage = nullptr); ///< Create a trace file
+   bool isOpen() const; ///< Check whether the trace file is open
+   void write(ReplayEvent const& event); ///< Append an event to the trace
+   qint32 eventCount() const; ///< Return the number of events written since the file was opened
+   void close(); ///< Flush the buffered events and close the trace file
+
+private: // member functions
+   void flush(); ///< Write the buffered events to the file
+
+private: // data members
+   QFile file_; ///< The trace file
+   QByteArray buffer_; ///< The buffered data
+   qint64 lastTimestampUs_ { 0 }; ///< The timestamp of the last event, in microseconds
+   quint64 lastKeyboardLayout_ { 0 }; ///< The keyboard layout of the last event
+   qint32 eventCount_ { 0 }; ///< The number of events written since the file was opened
+};
+
+
+//**********************************************************************************************************************
+/// \brief A reader of keystroke trace files
+//**********************************************************************************************************************
+class KeystrokeTraceReader
+{
+public: // static member functions
+   static bool read(QString const& path, std::vector<ReplayEvent>& outEvents,
+      QString* outErrorMessage = nullptr); ///< Read the events of a trace file
+   static bool read(QByteArray const& data, std::vector<ReplayEvent>& outEvents,
+      QString* outErrorMessage = nullptr); ///< Read the events of a trace from memory
+
+public: // member functions
+   KeystrokeTraceReader() = delete; ///< Disabled default constructor
+   KeystrokeTraceReader(KeystrokeTraceReader const&) = delete; ///< Disabled copy constructor
+   KeystrokeTraceReader(KeystrokeTraceReader&&) = delete; ///< Disabled move constructor
+   ~KeystrokeTraceReader() = delete; ///< Disabled destructor
+   KeystrokeTraceReader& operator=(KeystrokeTraceReader const&) = delete; ///< Disabled assignment operator
+   KeystrokeTraceReader& operator=(KeystrokeTraceReader&&) = delete; ///< Disabled move assignment operator
+};
+
+
+#endif // #ifndef BEEFTEXT_KEYSTROKE_TRACE_H
@@ -0,0 +1,109 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the dialog displaying latency statistics
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "LatencyDialog.h"
+#include "LatencyMonitor.h"
+#include <XMiLib/XMiLibConstants.h>
+
+
+namespace {
+
+
+qint32 const kRefreshIntervalMs = 1000; ///< The interval between two refreshes of the statistics
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] parent The parent widget of the dialog
+//**********************************************************************************************************************
+LatencyDialog::LatencyDialog(QWidget* parent)
+   : QDialog(parent, xmilib::constants::kDefaultDialogFlags)
+   , ui_()
+{
+   ui_.setupUi(this);
+   ui_.tableStatistics->setRowCount(LatencyStageCount);
+   ui_.tableStatistics->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+   ui_.tableStatistics->horizontalHeader()->setStretchLastSection(true);
+   this->updateGui();
+   connect(&refreshTimer_, &QTimer::timeout, this, &LatencyDialog::updateGui);
+   refreshTimer_.start(kRefreshIntervalMs);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void LatencyDialog::updateGui() const
+{
+   LatencyMonitor const& monitor = LatencyMonitor::instance();
+   QTableWidget* table = ui_.tableStatistics;
+   for (qint32 row = 0; row < LatencyStageCount; ++row)
+   {
+      ELatencyStage const stage = ELatencyStage(row);
+      LatencyHistogram const& histogram = monitor.histogram(stage);
+      bool const empty = (0 == histogram.count());
+      QStringList const values = {
+         LatencyMonitor::stageName(stage),
+         QString::number(histogram.count()),
+         empty ? QString() : latencyToString(histogram.valueAtPercentile(50.0)),
+         empty ? QString() : latencyToString(histogram.valueAtPercentile(95.0)),
+         empty ? QString() : latencyToString(histogram.valueAtPercentile(99.0)),
+         empty ? QString() : latencyToString(histogram.meanValue()),
+         empty ? QString() : latencyToString(histogram.maxValue()),
+      };
+      for (qint32 column = 0; column < values.size(); ++column)
+      {
+         QTableWidgetItem* item = table->item(row, column);
+         if (!item)
+         {
+            item = new QTableWidgetItem;
+            if (column > 0)
+               item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            table->setItem(row, column, item);
+         }
+         item->setText(values[column]);
+      }
+   }
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] event The event
+//**********************************************************************************************************************
+void LatencyDialog::changeEvent(QEvent *event)
+{
+   if (QEvent::LanguageChange == event->type())
+   {
+      ui_.retranslateUi(this);
+      this->updateGui();
+   }
+   QDialog::changeEvent(event);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void LatencyDialog::onActionReset()
+{
+   LatencyMonitor::instance().reset();
+   this->updateGui();
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void LatencyDialog::onActionWriteToLog()
+{
+   LatencyMonitor::instance().writeToDebugLog();
+}
@@ -0,0 +1,45 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the dialog displaying latency statistics
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_LATENCY_DIALOG_H
+#define BEEFTEXT_LATENCY_DIALOG_H
+
+
+#include "ui_LatencyDialog.h"
+
+
+//**********************************************************************************************************************
+/// \brief A dialog displaying the percentiles of the latency of the stages timed by the latency monitor
+//**********************************************************************************************************************
+class LatencyDialog: public QDialog
+{
+   Q_OBJECT
+public: // member functions
+   explicit LatencyDialog(QWidget* parent = nullptr); ///< Default constructor
+   LatencyDialog(LatencyDialog const&) = delete; ///< Disabled copy constructor
+   LatencyDialog(LatencyDialog&&) = delete; ///< Disabled move constructor
+   ~LatencyDialog() = default; ///< Default destructor
+   LatencyDialog& operator=(LatencyDialog const&) = delete; ///< Disabled assignment operator
+   LatencyDialog& operator=(LatencyDialog&&) = delete; ///< Disabled move assignment operator
+
+private: // member functions
+   void updateGui() const; ///< Update the statistics displayed in the dialog
+   void changeEvent(QEvent *event) override; ///< Event change handler
+
+private slots:
+   void onActionReset(); ///< Slot for the 'Reset' action
+   static void onActionWriteToLog(); ///< Slot for the 'Write to Log' action
+
+private: // data members
+   Ui::LatencyDialog ui_; ///< The GUI for the dialog
+   QTimer refreshTimer_; ///< The timer used to refresh the statistics
+};
+
+
+#endif // #ifndef BEEFTEXT_LATENCY_DIALOG_H
@@ -0,0 +1,314 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the latency monitor, that measures the time spent in the stages of a substitution
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "LatencyMonitor.h"
+#include "BeeftextGlobals.h"
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+
+namespace {
+
+
+quint64 const kMaxValue = (quint64(1) << LatencyHistogram::MaxValueBits) - 1; ///< The largest recordable value
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+LatencyHistogram::LatencyHistogram()
+{
+   this->reset();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] ns The duration in nanoseconds. Negative values are recorded as 0, and values too large to be recorded
+/// are clamped
+//**********************************************************************************************************************
+void LatencyHistogram::record(qint64 ns)
+{
+   quint64 const value = qMin<quint64>(quint64(qMax<qint64>(ns, 0)), kMaxValue);
+   counts_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+   totalCount_.fetch_add(1, std::memory_order_relaxed);
+   totalNs_.fetch_add(value, std::memory_order_relaxed);
+   qint64 max = maxNs_.load(std::memory_order_relaxed);
+   while ((qint64(value) > max) && !maxNs_.compare_exchange_weak(max, qint64(value), std::memory_order_relaxed))
+      ;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void LatencyHistogram::reset()
+{
+   for (std::atomic<quint64>& count: counts_)
+      count.store(0, std::memory_order_relaxed);
+   totalCount_.store(0, std::memory_order_relaxed);
+   totalNs_.store(0, std::memory_order_relaxed);
+   maxNs_.store(0, std::memory_order_relaxed);
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of recorded durations
+//**********************************************************************************************************************
+quint64 LatencyHistogram::count() const
+{
+   return totalCount_.load(std::memory_order_relaxed);
+}
+
+
+//**********************************************************************************************************************
+/// \return The largest recorded duration in nanoseconds
+//**********************************************************************************************************************
+qint64 LatencyHistogram::maxValue() const
+{
+   return maxNs_.load(std::memory_order_relaxed);
+}
+
+
+//**********************************************************************************************************************
+/// \return The mean of the recorded durations in nanoseconds
+/// \return 0 if no duration was recorded
+//**********************************************************************************************************************
+qint64 LatencyHistogram::meanValue() const
+{
+   quint64 const count = this->count();
+   return count ? qint64(totalNs_.load(std::memory_order_relaxed) / count) : 0;
+}
+
+
+//**********************************************************************************************************************
+/// The returned value is the largest value counted in the bucket containing the percentile, so it is an upper bound
+/// of the actual value, with a relative error below 1 / SubBucketCount.
+///
+/// \param[in] percentile The percentile, between 0 and 100
+/// \return The duration in nanoseconds at the given percentile
+/// \return 0 if no duration was recorded
+//**********************************************************************************************************************
+qint64 LatencyHistogram::valueAtPercentile(double percentile) const
+{
+   // the counts are copied first, so that the rank is computed from the same values as the walk of the buckets
+   std::vector<quint64> counts(BucketCount);
+   quint64 total = 0;
+   for (qint32 i = 0; i < BucketCount; ++i)
+   {
+      counts[i] = counts_[i].load(std::memory_order_relaxed);
+      total += counts[i];
+   }
+   if (!total)
+      return 0;
+   quint64 const rank = qMax<quint64>(1, quint64(std::ceil(qBound(0.0, percentile, 100.0) / 100.0 * double(total))));
+   quint64 cumulated = 0;
+   for (qint32 i = 0; i < BucketCount; ++i)
+   {
+      cumulated += counts[i];
+      if (cumulated >= rank)
+         return qMin<qint64>(qint64(highestEquivalentValue(i)), this->maxValue());
+   }
+   return this->maxValue();
+}
+
+
+//**********************************************************************************************************************
+/// Values below SubBucketCount have their own bucket. Above, each power of two is split into SubBucketCount buckets
+/// of equal width.
+///
+/// \param[in] value The value, which must not be larger than the largest recordable value
+/// \return The index of the bucket for the value
+//**********************************************************************************************************************
+qint32 LatencyHistogram::bucketIndex(quint64 value)
+{
+   if (value < SubBucketCount)
+      return qint32(value);
+   qint32 const shift = (63 - qCountLeadingZeroBits(value)) - SubBucketBits;
+   return SubBucketCount * (shift + 1) + qint32(value >> shift) - SubBucketCount;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] index The index of the bucket
+/// \return The largest value counted in the bucket
+//**********************************************************************************************************************
+quint64 LatencyHistogram::highestEquivalentValue(qint32 index)
+{
+   if (index < SubBucketCount)
+      return quint64(index);
+   qint32 const shift = index / SubBucketCount - 1;
+   quint64 const lowest = quint64(SubBucketCount + index % SubBucketCount) << shift;
+   return lowest + (quint64(1) << shift) - 1;
+}
+
+
+//**********************************************************************************************************************
+/// \return The only allowed instance of the class
+//**********************************************************************************************************************
+LatencyMonitor& LatencyMonitor::instance()
+{
+   static LatencyMonitor instance;
+   return instance;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] stage The stage
+/// \return The display name of the stage
+//**********************************************************************************************************************
+QString LatencyMonitor::stageName(ELatencyStage stage)
+{
+   switch (stage)
+   {
+   case KeyStrokeStage: return QObject::tr("Keystroke processing");
+   case ComboMatchedStage: return QObject::tr("Combo match handling");
+   case EmojiShortcodeStage: return QObject::tr("Emoji shortcode handling");
+   case SnippetEvaluationStage: return QObject::tr("Snippet evaluation");
+   case TextSubstitutionStage: return QObject::tr("Text substitution");
+   case KeyStrokeToSubstitutionStage: return QObject::tr("Keystroke to substitution");
+   default: return QString();
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The clock is steady, so the measures are not affected by changes of the system time.
+///
+/// \return The current value of the monotonic clock, in nanoseconds
+//**********************************************************************************************************************
+qint64 LatencyMonitor::timestampNs()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] stage The stage
+/// \param[in] ns The duration of the stage in nanoseconds
+//**********************************************************************************************************************
+void LatencyMonitor::record(ELatencyStage stage, qint64 ns)
+{
+   if ((stage >= 0) && (stage < LatencyStageCount))
+      histograms_[stage].record(ns);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] stage The stage, which must be valid
+/// \return The histogram of the stage
+//**********************************************************************************************************************
+LatencyHistogram const& LatencyMonitor::histogram(ELatencyStage stage) const
+{
+   Q_ASSERT((stage >= 0) && (stage < LatencyStageCount));
+   return histograms_[stage];
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void LatencyMonitor::reset()
+{
+   for (LatencyHistogram& histogram: histograms_)
+      histogram.reset();
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void LatencyMonitor::writeToDebugLog() const
+{
+   xmilib::DebugLog& log = globals::debugLog();
+   log.addInfo("Latency statistics:");
+   for (qint32 i = 0; i < LatencyStageCount; ++i)
+   {
+      LatencyHistogram const& histogram = histograms_[i];
+      quint64 const count = histogram.count();
+      QString const name = stageName(ELatencyStage(i));
+      if (!count)
+      {
+         log.addInfo(QString("   %1: no sample.").arg(name));
+         continue;
+      }
+      log.addInfo(QString("   %1: %2 samples, p50 = %3, p95 = %4, p99 = %5, mean = %6, max = %7.").arg(name)
+         .arg(count).arg(latencyToString(histogram.valueAtPercentile(50.0)))
+         .arg(latencyToString(histogram.valueAtPercentile(95.0)))
+         .arg(latencyToString(histogram.valueAtPercentile(99.0))).arg(latencyToString(histogram.meanValue()))
+         .arg(latencyToString(histogram.maxValue())));
+   }
+}
+
+
+//**********************************************************************************************************************
+/// \return The timestamp of the last keystroke typed, as returned by timestampNs()
+//**********************************************************************************************************************
+qint64 LatencyMonitor::lastKeyStrokeTimestampNs() const
+{
+   return lastKeyStrokeNs_.load(std::memory_order_relaxed);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] timestampNs The timestamp of the last keystroke typed, as returned by timestampNs()
+//**********************************************************************************************************************
+void LatencyMonitor::setLastKeyStrokeTimestampNs(qint64 timestampNs)
+{
+   lastKeyStrokeNs_.store(timestampNs, std::memory_order_relaxed);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] stage The timed stage
+//**********************************************************************************************************************
+LatencyTimer::LatencyTimer(ELatencyStage stage)
+   : stage_(stage)
+   , startNs_(LatencyMonitor::timestampNs())
+{
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+LatencyTimer::~LatencyTimer()
+{
+   LatencyMonitor::instance().record(stage_, LatencyMonitor::timestampNs() - startNs_);
+}
+
+
+//**********************************************************************************************************************
+/// \return The timestamp of the start of the stage, as returned by LatencyMonitor::timestampNs()
+//**********************************************************************************************************************
+qint64 LatencyTimer::startTimestampNs() const
+{
+   return startNs_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] ns The duration in nanoseconds
+/// \return A human readable representation of the duration, using the most appropriate unit
+//**********************************************************************************************************************
+QString latencyToString(qint64 ns)
+{
+   if (ns < 1000)
+      return QString("%1 ns").arg(ns);
+   if (ns < 1000000)
+      return QString("%1 %2s").arg(double(ns) / 1e3, 0, 'f', 1).arg(QChar(0x00b5));
+   if (ns < 1000000000)
+      return QString("%1 ms").arg(double(ns) / 1e6, 0, 'f', 1);
+   return QString("%1 s").arg(double(ns) / 1e9, 0, 'f', 2);
+}
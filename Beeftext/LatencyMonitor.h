@@ -0,0 +1,130 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the latency monitor, that measures the time spent in the stages of a substitution
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_LATENCY_MONITOR_H
+#define BEEFTEXT_LATENCY_MONITOR_H
+
+
+#include <atomic>
+
+
+//**********************************************************************************************************************
+/// \brief Enumeration for the stages of the processing of keystrokes and substitutions that are timed
+//**********************************************************************************************************************
+enum ELatencyStage {
+   KeyStrokeStage = 0, ///< The processing of a keystroke by the input manager
+   ComboMatchedStage = 1, ///< The handling of a combo match by the combo manager, substitution included
+   EmojiShortcodeStage = 2, ///< The handling of an emoji shortcode by the combo manager, substitution included
+   SnippetEvaluationStage = 3, ///< The evaluation of the snippet of a combo being substituted
+   TextSubstitutionStage = 4, ///< The replacement of the typed keyword by the new text
+   KeyStrokeToSubstitutionStage = 5, ///< The time from the last typed keystroke to the end of a substitution
+   LatencyStageCount = 6, ///< The number of stages
+}; ///< Enumeration for the stages of the processing of keystrokes and substitutions that are timed
+
+
+//**********************************************************************************************************************
+/// \brief A lock-free histogram of durations with a bounded relative error
+///
+/// The histogram follows the layout of HDR histograms: durations are counted in buckets whose width is proportional
+/// to their magnitude, so the memory is fixed and a value is retrieved with a relative error below 1 / SubBucketCount
+/// for any duration between one nanosecond and several minutes. Recording is wait-free and can be done concurrently
+/// from any thread. Queries are not atomic with respect to recording, which is acceptable for statistics.
+//**********************************************************************************************************************
+class LatencyHistogram
+{
+public: // data types
+   enum {
+      SubBucketBits = 5, ///< The number of bits of the sub-buckets of each power of two
+      SubBucketCount = 1 << SubBucketBits, ///< The number of sub-buckets of each power of two
+      MaxValueBits = 40, ///< The number of bits of the largest recordable value, in nanoseconds (about 18 minutes)
+      BucketCount = SubBucketCount * (MaxValueBits - SubBucketBits + 1), ///< The total number of buckets
+   };
+
+public: // member functions
+   LatencyHistogram(); ///< Default constructor
+   LatencyHistogram(LatencyHistogram const&) = delete; ///< Disabled copy constructor
+   LatencyHistogram(LatencyHistogram&&) = delete; ///< Disabled move constructor
+   ~LatencyHistogram() = default; ///< Default destructor
+   LatencyHistogram& operator=(LatencyHistogram const&) = delete; ///< Disabled assignment operator
+   LatencyHistogram& operator=(LatencyHistogram&&) = delete; ///< Disabled move assignment operator
+   void record(qint64 ns); ///< Record a duration
+   void reset(); ///< Reset the histogram
+   quint64 count() const; ///< Return the number of recorded durations
+   qint64 maxValue() const; ///< Return the largest recorded duration
+   qint64 meanValue() const; ///< Return the mean of the recorded durations
+   qint64 valueAtPercentile(double percentile) const; ///< Return the duration at a given percentile
+
+private: // static member functions
+   static qint32 bucketIndex(quint64 value); ///< Return the index of the bucket for a value
+   static quint64 highestEquivalentValue(qint32 index); ///< Return the largest value counted in a bucket
+
+private: // data members
+   std::atomic<quint64> counts_[BucketCount]; ///< The counts of the buckets
+   std::atomic<quint64> totalCount_ { 0 }; ///< The number of recorded durations
+   std::atomic<quint64> totalNs_ { 0 }; ///< The sum of the recorded durations
+   std::atomic<qint64> maxNs_ { 0 }; ///< The largest recorded duration
+};
+
+
+//**********************************************************************************************************************
+/// \brief The monitor of the latency of the stages of the processing of keystrokes and substitutions
+//**********************************************************************************************************************
+class LatencyMonitor
+{
+public: // static member functions
+   static LatencyMonitor& instance(); ///< Return the only allowed instance of the class
+   static QString stageName(ELatencyStage stage); ///< Return the display name of a stage
+   static qint64 timestampNs(); ///< Return the current value of the monotonic clock used for timing
+
+public: // member functions
+   LatencyMonitor(LatencyMonitor const&) = delete; ///< Disabled copy constructor
+   LatencyMonitor(LatencyMonitor&&) = delete; ///< Disabled move constructor
+   ~LatencyMonitor() = default; ///< Default destructor
+   LatencyMonitor& operator=(LatencyMonitor const&) = delete; ///< Disabled assignment operator
+   LatencyMonitor& operator=(LatencyMonitor&&) = delete; ///< Disabled move assignment operator
+   void record(ELatencyStage stage, qint64 ns); ///< Record the duration of a stage
+   LatencyHistogram const& histogram(ELatencyStage stage) const; ///< Return the histogram of a stage
+   void reset(); ///< Reset the histograms of all stages
+   void writeToDebugLog() const; ///< Write the statistics of all stages to the debug log
+   qint64 lastKeyStrokeTimestampNs() const; ///< Return the timestamp of the last keystroke typed
+   void setLastKeyStrokeTimestampNs(qint64 timestampNs); ///< Set the timestamp of the last keystroke typed
+
+private: // member functions
+   LatencyMonitor() = default; ///< Default constructor
+
+private: // data members
+   LatencyHistogram histograms_[LatencyStageCount]; ///< The histograms of the stages
+   std::atomic<qint64> lastKeyStrokeNs_ { 0 }; ///< The timestamp of the last keystroke typed
+};
+
+
+//**********************************************************************************************************************
+/// \brief A scoped timer recording in the latency monitor the time elapsed between its construction and destruction
+//**********************************************************************************************************************
+class LatencyTimer
+{
+public: // member functions
+   explicit LatencyTimer(ELatencyStage stage); ///< Default constructor
+   LatencyTimer(LatencyTimer const&) = delete; ///< Disabled copy constructor
+   LatencyTimer(LatencyTimer&&) = delete; ///< Disabled move constructor
+   ~LatencyTimer(); ///< Destructor
+   LatencyTimer& operator=(LatencyTimer const&) = delete; ///< Disabled assignment operator
+   LatencyTimer& operator=(LatencyTimer&&) = delete; ///< Disabled move assignment operator
+   qint64 startTimestampNs() const; ///< Return the timestamp of the start of the stage
+
+private: // data members
+   ELatencyStage stage_; ///< The timed stage
+   qint64 startNs_; ///< The timestamp of the start of the stage
+};
+
+
+QString latencyToString(qint64 ns); ///< Return a human readable representation of a duration
+
+
+#endif // #ifndef BEEFTEXT_LATENCY_MONITOR_H
@@ -10,6 +10,7 @@
 #include "stdafx.h"
 #include "MainWindow.h"
 #include "AboutDialog.h"
+#include "LatencyDialog.h"
 #include "PreferencesDialog.h"
 #include "PreferencesManager.h"
 #include "Combo/ComboManager.h"
@@ -17,6 +18,7 @@
 #include "Group/GroupListWidget.h"
 #include "BeeftextUtils.h"
 #include "BeeftextConstants.h"
+#include "BeeftextGlobals.h"
 #include "InputManager.h"
 #include <XMiLib/Exception.h>
 
@@ -337,6 +339,46 @@ void MainWindow::onActionOpenLogFile()
 }
 
 
+//**********************************************************************************************************************
+// 
+//**********************************************************************************************************************
+void MainWindow::onActionShowLatencyStatistics()
+{
+   LatencyDialog().exec();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] checked Is the action checked
+//**********************************************************************************************************************
+void MainWindow::onActionRecordKeystrokeTrace(bool checked)
+{
+   InputManager& inputManager = InputManager::instance();
+   if (!checked)
+   {
+      if (inputManager.isRecordingTrace())
+         globals::debugLog().addInfo(QString("Keystroke trace recording stopped. %1 events were recorded.")
+            .arg(inputManager.stopTraceRecording()));
+      return;
+   }
+
+   QString const path = QFileDialog::getSaveFileName(this, tr("Record Keystroke Trace"),
+      QDir(QStandardPaths::writableLocation(QStandardPaths::DesktopLocation)).absoluteFilePath(
+      QString("Beeftext.%1").arg(constants::keystrokeTraceFileExtension)), constants::keystrokeTraceFileDialogFilter());
+   QString errMsg;
+   if (path.isEmpty() || (!inputManager.startTraceRecording(path, &errMsg)))
+   {
+      QSignalBlocker blocker(ui_.actionRecordKeystrokeTrace);
+      ui_.actionRecordKeystrokeTrace->setChecked(false);
+      if (!errMsg.isEmpty())
+         QMessageBox::critical(this, tr("Error"), errMsg);
+      return;
+   }
+   globals::debugLog().addInfo(QString("Keystroke trace recording started to '%1'.")
+      .arg(QDir::toNativeSeparators(path)));
+}
+
+
 //**********************************************************************************************************************
 //
 //**********************************************************************************************************************
@@ -60,6 +60,8 @@ private slots:
    static void onActionShowAboutDialog(); ///< Slot for the 'Show About dialog' action
    void onActionShowPreferencesDialog(); ///< Slot for the 'Show Preferences dialog' action
    static void onActionOpenLogFile(); ///< Slot for the 'Open Log File' action
+   static void onActionShowLatencyStatistics(); ///< Slot for the 'Show Latency Statistics' action
+   void onActionRecordKeystrokeTrace(bool checked); ///< Slot for the 'Record Keystroke Trace' action
    void onActionBackup(); ///< Slot for the 'Backup' action.
    void onActionRestore(); ///< Slot for the 'Restore' action.
    void onActionGenerateCheatSheet(); ///< Slot for the 'Generate Cheat Sheet' action.
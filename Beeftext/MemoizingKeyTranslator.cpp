@@ -0,0 +1,146 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the key translator caching the translations of another translator
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "MemoizingKeyTranslator.h"
+#include "KeyClassification.h"
+
+
+static_assert(0 == (MemoizingKeyTranslator::CacheSize & (MemoizingKeyTranslator::CacheSize - 1)),
+   "The size of the key translation cache must be a power of two");
+static_assert(2 * sizeof(kModifierVirtualKeys) <= 32, "The modifier mask cannot hold the state of all modifier keys");
+
+
+//**********************************************************************************************************************
+/// \param[in] translator The decorated translator. Must not be null
+//**********************************************************************************************************************
+MemoizingKeyTranslator::MemoizingKeyTranslator(UpKeyTranslator translator)
+   : KeyTranslator()
+   , translator_(std::move(translator))
+   , entries_(CacheSize)
+{
+   Q_ASSERT(translator_);
+   this->clear();
+}
+
+
+//**********************************************************************************************************************
+/// \return The identifier of the keyboard layout, as returned by the decorated translator
+//**********************************************************************************************************************
+quint64 MemoizingKeyTranslator::keyboardLayout()
+{
+   return translator_->keyboardLayout();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The key stroke
+/// \param[in] layout The identifier of the keyboard layout
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+//**********************************************************************************************************************
+void MemoizingKeyTranslator::translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey,
+   KeyText& outText)
+{
+   if (0 == layout)
+   {
+      ++missCount_;
+      translator_->translateKey(keyStroke, layout, outIsDeadKey, outText);
+      return;
+   }
+   if (layout != layout_)
+   {
+      this->clear();
+      layout_ = layout;
+   }
+
+   quint32 const mask = modifierMask(keyStroke);
+   quint32 const hash = (keyStroke.virtualKey * 0x9e3779b1u) ^ (keyStroke.scanCode * 0x85ebca6bu) ^
+      (mask * 0xc2b2ae35u);
+   quint32 const home = (hash ^ (hash >> 16)) & (CacheSize - 1);
+   Entry* freeEntry = nullptr;
+   for (quint32 i = 0; i < MaxProbeCount; ++i)
+   {
+      Entry& entry = entries_[(home + i) & (CacheSize - 1)];
+      if (!entry.used)
+      {
+         freeEntry = &entry; // entries are never removed individually, so the keystroke is not further in the cache
+         break;
+      }
+      if ((entry.virtualKey == keyStroke.virtualKey) && (entry.scanCode == keyStroke.scanCode) &&
+         (entry.modifierMask == mask))
+      {
+         ++hitCount_;
+         outIsDeadKey = false;
+         outText = entry.text;
+         return;
+      }
+   }
+
+   ++missCount_;
+   translator_->translateKey(keyStroke, layout, outIsDeadKey, outText);
+   if (outIsDeadKey)
+      return;
+   Entry& entry = freeEntry ? *freeEntry : entries_[home]; // when all probed entries are used, the first one is evicted
+   entry.virtualKey = keyStroke.virtualKey;
+   entry.scanCode = keyStroke.scanCode;
+   entry.modifierMask = mask;
+   entry.used = true;
+   entry.text = outText;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void MemoizingKeyTranslator::clear()
+{
+   for (Entry& entry: entries_)
+      entry.used = false;
+   layout_ = 0;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of translations retrieved from the cache
+//**********************************************************************************************************************
+quint64 MemoizingKeyTranslator::hitCount() const
+{
+   return hitCount_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of translations forwarded to the decorated translator
+//**********************************************************************************************************************
+quint64 MemoizingKeyTranslator::missCount() const
+{
+   return missCount_;
+}
+
+
+//**********************************************************************************************************************
+/// Both the down bit (0x80) and the toggle bit (0x01) of each modifier key are kept, as the toggle bit of caps lock
+/// affects the translation.
+///
+/// \param[in] keyStroke The keystroke
+/// \return The mask of the state of the keys listed in kModifierVirtualKeys
+//**********************************************************************************************************************
+quint32 MemoizingKeyTranslator::modifierMask(KeyStroke const& keyStroke)
+{
+   quint32 result = 0;
+   quint32 bit = 0;
+   for (quint8 const key: kModifierVirtualKeys)
+   {
+      quint8 const state = keyStroke.keyboardState[key];
+      result |= (quint32((state & 0x80) ? 1 : 0) << bit) | (quint32(state & 0x01) << (bit + 1));
+      bit += 2;
+   }
+   return result;
+}
@@ -0,0 +1,70 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the key translator caching the translations of another translator
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_MEMOIZING_KEY_TRANSLATOR_H
+#define BEEFTEXT_MEMOIZING_KEY_TRANSLATOR_H
+
+
+#include "KeyTranslator.h"
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief A key translator caching the translations performed by another translator
+///
+/// The translations are keyed by keyboard layout, virtual key, scan code, and state of the keys listed in
+/// kModifierVirtualKeys, so the decorated translator must be stateless and must not depend on the state of other keys.
+/// Dead keys, and keystrokes translated with an unknown layout (0), are never cached. The cache only holds the
+/// translations of a single layout, and is cleared when the layout changes. The table has a fixed size and is
+/// allocated once, so translating a keystroke never allocates memory.
+//**********************************************************************************************************************
+class MemoizingKeyTranslator: public KeyTranslator
+{
+public: // data types
+   enum {
+      CacheSize = 1024, ///< The number of entries in the cache. Must be a power of two
+      MaxProbeCount = 4, ///< The maximum number of entries inspected when looking up a keystroke
+   };
+
+public: // member functions
+   explicit MemoizingKeyTranslator(UpKeyTranslator translator); ///< Default constructor
+   MemoizingKeyTranslator(MemoizingKeyTranslator const&) = delete; ///< Disabled copy constructor
+   MemoizingKeyTranslator(MemoizingKeyTranslator&&) = delete; ///< Disabled move constructor
+   ~MemoizingKeyTranslator() = default; ///< Default destructor
+   MemoizingKeyTranslator& operator=(MemoizingKeyTranslator const&) = delete; ///< Disabled assignment operator
+   MemoizingKeyTranslator& operator=(MemoizingKeyTranslator&&) = delete; ///< Disabled move assignment operator
+   quint64 keyboardLayout() override; ///< Return the identifier of the keyboard layout keystrokes are currently translated with
+   void translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey, KeyText& outText) override; ///< Retrieve the text produced by a keystroke with a keyboard layout
+   void clear(); ///< Clear the cache
+   quint64 hitCount() const; ///< Return the number of translations retrieved from the cache
+   quint64 missCount() const; ///< Return the number of translations forwarded to the decorated translator
+
+private: // data types
+   struct Entry
+   {
+      quint32 virtualKey; ///< The virtual key
+      quint32 scanCode; ///< The scan code
+      quint32 modifierMask; ///< The mask of the state of the modifier keys
+      bool used; ///< Is the entry used
+      KeyText text; ///< The translation
+   }; ///< An entry in the cache
+
+private: // static member functions
+   static quint32 modifierMask(KeyStroke const& keyStroke); ///< Return the mask of the state of the modifier keys for a keystroke
+
+private: // data members
+   UpKeyTranslator translator_; ///< The decorated translator
+   std::vector<Entry> entries_; ///< The entries of the cache
+   quint64 layout_ { 0 }; ///< The keyboard layout of the cached translations
+   quint64 hitCount_ { 0 }; ///< The number of translations retrieved from the cache
+   quint64 missCount_ { 0 }; ///< The number of translations forwarded to the decorated translator
+};
+
+
+#endif // #ifndef BEEFTEXT_MEMOIZING_KEY_TRANSLATOR_H
@@ -112,6 +112,12 @@ void PreferencesDialog::loadPreferences() const
    ui_.checkUseCustomTheme->setChecked(prefs_.useCustomTheme());
    blocker = QSignalBlocker(ui_.spinDelayBetweenKeystrokes);
    ui_.spinDelayBetweenKeystrokes->setValue(prefs_.delayBetweenKeystrokesMs());
+   blocker = QSignalBlocker(ui_.comboMatchResolutionPolicy);
+   ui_.comboMatchResolutionPolicy->setCurrentIndex(prefs_.matchResolutionPolicy());
+   blocker = QSignalBlocker(ui_.checkCaseInsensitiveMatching);
+   ui_.checkCaseInsensitiveMatching->setChecked(prefs_.caseInsensitiveMatching());
+   blocker = QSignalBlocker(ui_.checkNormalizationInsensitiveMatching);
+   ui_.checkNormalizationInsensitiveMatching->setChecked(prefs_.normalizationInsensitiveMatching());
    ui_.editComboListFolder->setText(QDir::toNativeSeparators(prefs_.comboListFolderPath()));
    ui_.checkAutoBackup->setChecked(prefs_.autoBackup());
    blocker = QSignalBlocker(ui_.checkUseCustomBackupLocation);
@@ -456,6 +462,33 @@ void PreferencesDialog::onSpinDelayBetweenKeystrokesChanged(int value) const
 }
 
 
+//**********************************************************************************************************************
+/// \param[in] index The index of the new value.
+//**********************************************************************************************************************
+void PreferencesDialog::onComboMatchResolutionPolicyChanged(int index) const
+{
+   prefs_.setMatchResolutionPolicy(EMatchResolutionPolicy(index));
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] checked Is the check box checked?
+//**********************************************************************************************************************
+void PreferencesDialog::onCheckCaseInsensitiveMatching(bool checked) const
+{
+   prefs_.setCaseInsensitiveMatching(checked);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] checked Is the check box checked?
+//**********************************************************************************************************************
+void PreferencesDialog::onCheckNormalizationInsensitiveMatching(bool checked) const
+{
+   prefs_.setNormalizationInsensitiveMatching(checked);
+}
+
+
 //**********************************************************************************************************************
 // 
 //**********************************************************************************************************************
@@ -60,6 +60,9 @@ private slots:
    void onComboLanguageValueChanged(int index) const; ///< Slot for the change of the value in the language combo.
    void onCheckUseCustomTheme(bool checked) const; ///< Slot for the 'Use custom theme' checkbox.
    void onSpinDelayBetweenKeystrokesChanged(int value) const; ///< Slot for the 'Delay between keystrokes' spin value change.
+   void onComboMatchResolutionPolicyChanged(int index) const; ///< Slot for the change of the value in the match resolution policy combo.
+   void onCheckCaseInsensitiveMatching(bool checked) const; ///< Slot for the 'Case insensitive matching' checkbox.
+   void onCheckNormalizationInsensitiveMatching(bool checked) const; ///< Slot for the 'Normalization insensitive matching' checkbox.
    void onChangeComboListFolder(); ///< Slot for the 'Change combo list folder' action
    void onResetComboListFolder(); ///< Slot for the 'Reset combo list folder' action
    void onOpenComboListFolder() const; ///< Slot for the 'Open' button of the combo list folder.
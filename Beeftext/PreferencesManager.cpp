@@ -42,6 +42,7 @@ QString const kKeyComboPickerShortcutScanCode = "ComboPickerShortcutScanCode"; /
 QString const kKeyComboTriggerShortcutModifiers = "ComboTriggerShortcutModifiers"; ///< The setting key for the combo trigger shortcut modifiers
 QString const kKeyComboTriggerShortcutKeyCode = "ComboTriggerShortcutKeyCode"; ///< The setting key for the combo trigger shortcut key code
 QString const kKeyComboTriggerShortcutScanCode = "ComboTriggerShortcutScanCode"; ///< The setting key for the combo trigger shortcut scan code
+QString const kKeyCaseInsensitiveMatching = "CaseInsensitiveMatching"; ///< The setting key for the 'Case insensitive matching' preference
 QString const kKeyCustomBackupLocation = "CustomBackupLocation"; ///< The settings key for the 'Custom backup location' preference.
 QString const kKeyCustomSoundPath = "CustomSoundPath"; ///< The settings key for the 'Custom sound path' preference.
 QString const kKeyDelayBetweenKeystrokes = "DelayBetweenKeystrokes"; ///< The setting key for the 'Delay between keystrokes'preferences value
@@ -54,6 +55,8 @@ QString const kKeyGeometry = "Geometry"; ///< The settings key for storing the g
 QString const kKeyLastComboImportExportPath = "LastComboImportExportPath"; ///< The setting key for 'Last combo import/export path' preference
 QString const kKeyLastUpdateCheckDateTime = "LastUpdateCheck"; ///< The setting key for the last update check date/time
 QString const kKeyLocale = "Locale"; ///< The settings key for the locale
+QString const kKeyMatchResolutionPolicy = "MatchResolutionPolicy"; ///< The setting key for the 'Match resolution policy' preference
+QString const kKeyNormalizationInsensitiveMatching = "NormalizationInsensitiveMatching"; ///< The setting key for the 'Normalization insensitive matching' preference
 QString const kKeyPlaySoundOnCombo = "PlaySoundOnCombo"; ///< The settings key for the 'Play sound on combo' preference
 QString const kKeySplitterState = "MainWindowSplitterState"; ///< The setting key for storing the main window splitter state.
 QString const kKeyUseAutomaticSubstitution = "UseAutomaticSubstitution"; ///< The setting key for the 'Use automatic substitution' preference
@@ -70,6 +73,7 @@ bool const kDefaultAutoBackup = true; ///< The default value for the 'Auto backu
 bool const kDefaultAutoCheckForUpdates = true; ///< The default value for the 'Auto check for update preference
 bool const kDefaultAutoStartAtLogin = false; ///< The default value for the 'Autostart at login' preference
 bool const kDefaultBeeftextEnabled = true; ///< The default value for the 'Beeftext is enabled' preference.
+bool const kDefaultCaseInsensitiveMatching = false; ///< The default value for the 'Case insensitive matching' preference
 bool const kDefaultComboPickerEnabled = true; ///< The default value for the 'Combo picker enabled' preference.
 SpShortcut const kDefaultComboTriggerShortcut = std::make_shared<Shortcut>(Qt::AltModifier | Qt::ShiftModifier
    | Qt::ControlModifier, 'B', 0x30); ///< The default value for the 'combo trigger shortcut' preference
@@ -80,8 +84,10 @@ bool const kDefaultEmojiShortcodesEnabled = false; ///< The default value for th
 bool const kDefaultEnableAppEnableDisableShortcut = false; ///< The default value for the 'enable app enable/disable shortcut' preference.
 QString const kDefaultLastComboImportExportPath = QDir(QStandardPaths::writableLocation(
    QStandardPaths::DesktopLocation)).absoluteFilePath("Combos.json");///< The default value for the 'Last combo import/export path' preference
+EMatchResolutionPolicy const kDefaultMatchResolutionPolicy = RandomResolution; ///< The default value for the 'Match resolution policy' preference
 qint32 const kMinValueDelayBetweenKeystrokesMs = 0; ///< The default valur for the 'Delay between keystrokes' preference.
 qint32 const kMaxValueDelayBetweenKeystrokesMs = 500; ///< The default valur for the 'Delay between keystrokes' preference.
+bool const kDefaultNormalizationInsensitiveMatching = false; ///< The default value for the 'Normalization insensitive matching' preference
 bool const kDefaultPlaySoundOnCombo = true; ///< The default value for the 'Play sound on combo' preference
 bool const kDefaultUseAutomaticSubstitution = true; ///< The default value for the 'Use automatic substitution' preference
 bool const kDefaultUseCustomBackupLocation = false; ///< The default value for the 'Use custom backup location' preference.
@@ -152,10 +158,18 @@ void PreferencesManager::init()
    cachedEnableAppEnableDisableShortcut_ = this->readSettings<bool>(kKeyEnableAppEnableDisableShortcut, 
       kDefaultEnableAppEnableDisableShortcut);
    this->cacheAppEnableDisableShortcut();
+   this->compileShortcutTable();
    cachedEmojiLeftDelimiter_ = this->readSettings<QString>(kKeyEmojiLeftDelimiter, kDefaultEmojiLeftDelimiter);
    cachedEmojiRightDelimiter_ = this->readSettings<QString>(kKeyEmojiRightDelimiter,
       kDefaultEmojiRightDelimiter);
    cachedBeeftextEnabled_ = this->readSettings<bool>(kKeyBeeftextEnabled, kDefaultBeeftextEnabled);
+   cachedMatchResolutionPolicy_ = EMatchResolutionPolicy(qBound<qint32>(0, this->readSettings<qint32>(
+      kKeyMatchResolutionPolicy, kDefaultMatchResolutionPolicy), MatchResolutionPolicyCount - 1));
+   cachedCaseInsensitiveMatching_ = this->readSettings<bool>(kKeyCaseInsensitiveMatching,
+      kDefaultCaseInsensitiveMatching);
+   cachedNormalizationInsensitiveMatching_ = this->readSettings<bool>(kKeyNormalizationInsensitiveMatching,
+      kDefaultNormalizationInsensitiveMatching);
+   emit substitutionPreferencesChanged();
    // Some preferences setting need initialization
    this->applyCustomThemePreference();
    this->applyLocalePreference();
@@ -171,6 +185,7 @@ void PreferencesManager::reset()
    this->setAppEnableDisableShortcut(defaultAppEnableDisableShortcut());
    this->setAutoBackup(kDefaultAutoBackup);
    this->setAutoCheckForUpdates(kDefaultAutoCheckForUpdates);
+   this->setCaseInsensitiveMatching(kDefaultCaseInsensitiveMatching);
    this->setComboPickerEnabled(kDefaultComboPickerEnabled);
    this->setComboPickerShortcut(defaultComboPickerShortcut());
    this->setComboTriggerShortcut(kDefaultComboTriggerShortcut);
@@ -182,6 +197,8 @@ void PreferencesManager::reset()
    this->setEmojiShortcodeEnabled(kDefaultEmojiShortcodesEnabled);
    this->setEnableAppEnableDisableShortcut(kDefaultEnableAppEnableDisableShortcut);
    this->setLocale(I18nManager::instance().validateLocale(QLocale::system()));
+   this->setMatchResolutionPolicy(kDefaultMatchResolutionPolicy);
+   this->setNormalizationInsensitiveMatching(kDefaultNormalizationInsensitiveMatching);
    this->setPlaySoundOnCombo(kDefaultPlaySoundOnCombo);
    this->setUseAutomaticSubstitution(kDefaultUseAutomaticSubstitution);
    this->setUseCustomBackupLocation(kDefaultUseCustomBackupLocation);
@@ -323,6 +340,8 @@ void PreferencesManager::toJsonDocument(QJsonDocument& outDoc) const
       qint32(this->readSettings<quint32>(kKeyComboTriggerShortcutModifiers, 0));
    object[kKeyComboTriggerShortcutScanCode] = 
       qint32(this->readSettings<quint32>(kKeyComboTriggerShortcutScanCode, 0));
+   object[kKeyCaseInsensitiveMatching] = this->readSettings<bool>(kKeyCaseInsensitiveMatching, 
+      kDefaultCaseInsensitiveMatching);
    object[kKeyCustomBackupLocation] = this->readSettings<QString>(kKeyCustomBackupLocation, 
       globals::defaultBackupFolderPath());
    object[kKeyCustomSoundPath] = this->readSettings<QString>(kKeyCustomSoundPath, QString());
@@ -339,8 +358,12 @@ void PreferencesManager::toJsonDocument(QJsonDocument& outDoc) const
    object[kKeyLastUpdateCheckDateTime] = QString::fromLocal8Bit(variantToByteArray( 
       this->lastUpdateCheckDateTime()).toHex());
    object[kKeyLocale] = QString::fromLocal8Bit(variantToByteArray(this->locale()).toHex());
+   object[kKeyMatchResolutionPolicy] = this->readSettings<qint32>(kKeyMatchResolutionPolicy, 
+      kDefaultMatchResolutionPolicy);
    object[kKeySplitterState] = QString::fromLocal8Bit(this->readSettings<QByteArray>(kKeySplitterState, 
       QByteArray()).toHex());
+   object[kKeyNormalizationInsensitiveMatching] = this->readSettings<bool>(kKeyNormalizationInsensitiveMatching, 
+      kDefaultNormalizationInsensitiveMatching);
    object[kKeyPlaySoundOnCombo] = this->readSettings<bool>(kKeyPlaySoundOnCombo, kDefaultPlaySoundOnCombo);
    object[kKeyUseAutomaticSubstitution] = this->readSettings<bool>(kKeyUseAutomaticSubstitution, 
       kDefaultUseAutomaticSubstitution);
@@ -382,6 +405,7 @@ void PreferencesManager::fromJsonDocument(QJsonDocument const& doc)
    settings_->setValue(kKeyComboTriggerShortcutModifiers, objectValue<quint32>(object, 
       kKeyComboTriggerShortcutModifiers));
    settings_->setValue(kKeyComboTriggerShortcutScanCode, objectValue<quint32>(object, kKeyComboTriggerShortcutScanCode));
+   settings_->setValue(kKeyCaseInsensitiveMatching, objectValue<bool>(object, kKeyCaseInsensitiveMatching));
    settings_->setValue(kKeyCustomSoundPath, objectValue<QString>(object, kKeyCustomSoundPath));
    this->setCustomBackupLocation(objectValue<QString>(object, kKeyCustomBackupLocation)); // we call the function because it has side effects
    settings_->setValue(kKeyDelayBetweenKeystrokes, objectValue<qint32>(object, kKeyDelayBetweenKeystrokes));
@@ -396,8 +420,11 @@ void PreferencesManager::fromJsonDocument(QJsonDocument const& doc)
       objectValue<QString>(object, kKeyLastUpdateCheckDateTime).toLocal8Bit())));
    settings_->setValue(kKeyLocale, byteArrayToVariant<QLocale>(QByteArray::fromHex(objectValue<QString>(object, 
       kKeyLocale).toLocal8Bit())));
+   settings_->setValue(kKeyMatchResolutionPolicy, objectValue<qint32>(object, kKeyMatchResolutionPolicy));
    settings_->setValue(kKeyGeometry, QByteArray::fromHex(objectValue<QString>(object, 
       kKeySplitterState).toLocal8Bit()));
+   settings_->setValue(kKeyNormalizationInsensitiveMatching, objectValue<bool>(object, 
+      kKeyNormalizationInsensitiveMatching));
    settings_->setValue(kKeyPlaySoundOnCombo, objectValue<bool>(object, kKeyPlaySoundOnCombo));
    settings_->setValue(kKeyUseAutomaticSubstitution, objectValue<bool>(object, kKeyUseAutomaticSubstitution));
    this->setUseCustomBackupLocation(objectValue<bool>(object, kKeyUseCustomBackupLocation)); // we call the function because it has side effects
@@ -686,6 +713,8 @@ void PreferencesManager::setUseAutomaticSubstitution(bool value)
 {
    cachedUseAutomaticSubstitution_ = value;
    settings_->setValue(kKeyUseAutomaticSubstitution, value);
+   this->compileShortcutTable();
+   emit substitutionPreferencesChanged();
 }
 
 
@@ -772,6 +801,7 @@ void PreferencesManager::setComboTriggerShortcut(SpShortcut const& shortcut)
       settings_->setValue(kKeyComboTriggerShortcutKeyCode, shortcut->nativeVirtualKey());
       settings_->setValue(kKeyComboTriggerShortcutScanCode, shortcut->nativeScanCode());
       cachedComboTriggerShortcut_ = newShortcut;
+      this->compileShortcutTable();
    }
 }
 
@@ -929,6 +959,7 @@ void PreferencesManager::setEmojiShortcodeEnabled(bool value)
 {
    cachedEmojiShortcodesEnabled_ = value;
    settings_->setValue(kKeyEmojiShortcodesEnabled, value);
+   emit substitutionPreferencesChanged();
 }
 
 
@@ -949,6 +980,7 @@ void PreferencesManager::setEmojiLeftDelimiter(QString const& delimiter)
 {
    cachedEmojiLeftDelimiter_ = delimiter;
    settings_->setValue(kKeyEmojiLeftDelimiter, delimiter);
+   emit substitutionPreferencesChanged();
 }
 
 
@@ -969,6 +1001,7 @@ void PreferencesManager::setEmojiRightDelimiter(QString const& delimiter)
 {
    cachedEmojiRightDelimiter_ = delimiter;
    settings_->setValue(kKeyEmojiRightDelimiter, delimiter);
+   emit substitutionPreferencesChanged();
 }
 
 
@@ -1010,6 +1043,71 @@ qint32 PreferencesManager::maxDelayBetweenKeystrokesMs()
 }
 
 
+//**********************************************************************************************************************
+/// As the getter for this value is called every time combos match, it is cached
+///
+/// \return The value for the preference
+//**********************************************************************************************************************
+EMatchResolutionPolicy PreferencesManager::matchResolutionPolicy() const
+{
+   return cachedMatchResolutionPolicy_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] policy The value for the preference
+//**********************************************************************************************************************
+void PreferencesManager::setMatchResolutionPolicy(EMatchResolutionPolicy policy)
+{
+   cachedMatchResolutionPolicy_ = EMatchResolutionPolicy(qBound<qint32>(0, policy, MatchResolutionPolicyCount - 1));
+   settings_->setValue(kKeyMatchResolutionPolicy, qint32(cachedMatchResolutionPolicy_));
+}
+
+
+//**********************************************************************************************************************
+/// As the getter for this value is called every time the matching settings are updated, it is cached
+///
+/// \return The value for the preference
+//**********************************************************************************************************************
+bool PreferencesManager::caseInsensitiveMatching() const
+{
+   return cachedCaseInsensitiveMatching_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] value The value for the preference
+//**********************************************************************************************************************
+void PreferencesManager::setCaseInsensitiveMatching(bool value)
+{
+   cachedCaseInsensitiveMatching_ = value;
+   settings_->setValue(kKeyCaseInsensitiveMatching, value);
+   emit substitutionPreferencesChanged();
+}
+
+
+//**********************************************************************************************************************
+/// As the getter for this value is called every time the matching settings are updated, it is cached
+///
+/// \return The value for the preference
+//**********************************************************************************************************************
+bool PreferencesManager::normalizationInsensitiveMatching() const
+{
+   return cachedNormalizationInsensitiveMatching_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] value The value for the preference
+//**********************************************************************************************************************
+void PreferencesManager::setNormalizationInsensitiveMatching(bool value)
+{
+   cachedNormalizationInsensitiveMatching_ = value;
+   settings_->setValue(kKeyNormalizationInsensitiveMatching, value);
+   emit substitutionPreferencesChanged();
+}
+
+
 //**********************************************************************************************************************
 /// \return the value for the preference.
 //**********************************************************************************************************************
@@ -1026,6 +1124,7 @@ void PreferencesManager::setComboPickerEnabled(bool value)
 {
    cachedComboPickerEnabled_ = value;
    settings_->setValue(kKeyComboPickerEnabled, value);
+   this->compileShortcutTable();
 }
 
 
@@ -1053,6 +1152,7 @@ void PreferencesManager::setComboPickerShortcut(SpShortcut const& shortcut)
       settings_->setValue(kKeyComboPickerShortcutKeyCode, shortcut->nativeVirtualKey());
       settings_->setValue(kKeyComboPickerShortcutScanCode, shortcut->nativeScanCode());
       cachedComboPickerShortcut_ = newShortcut;
+      this->compileShortcutTable();
    }
 }
 
@@ -1109,6 +1209,24 @@ void PreferencesManager::cacheAppEnableDisableShortcut()
 }
 
 
+//**********************************************************************************************************************
+/// The table is read at every keystroke, so a new table is built and swapped in rather than modifying the published
+/// one. Shortcuts are added by decreasing priority, so that if two shortcuts collide, the one that was checked first
+/// when the shortcuts were compared one by one still wins.
+//**********************************************************************************************************************
+void PreferencesManager::compileShortcutTable()
+{
+   std::shared_ptr<ShortcutTable> const table = std::make_shared<ShortcutTable>();
+   if (cachedEnableAppEnableDisableShortcut_)
+      table->add(cachedAppEnableDisableShortcut_, ShortcutTable::AppEnableDisableAction);
+   if (!cachedUseAutomaticSubstitution_)
+      table->add(cachedComboTriggerShortcut_, ShortcutTable::ComboTriggerAction);
+   if (cachedComboPickerEnabled_)
+      table->add(cachedComboPickerShortcut_, ShortcutTable::ComboPickerAction);
+   std::atomic_store(&shortcutTable_, SpShortcutTable(table));
+}
+
+
 //**********************************************************************************************************************
 // 
 //**********************************************************************************************************************
@@ -1195,6 +1313,7 @@ void PreferencesManager::setEnableAppEnableDisableShortcut(bool enable)
 {
    settings_->setValue(kKeyEnableAppEnableDisableShortcut, enable);
    cachedEnableAppEnableDisableShortcut_ = enable;
+   this->compileShortcutTable();
 }
 
 
@@ -1222,6 +1341,7 @@ void PreferencesManager::setAppEnableDisableShortcut(SpShortcut const& shortcut)
       settings_->setValue(kKeyAppEnableShortcutKeyCode, shortcut->nativeVirtualKey());
       settings_->setValue(kKeyAppEnableShortcutScanCode, shortcut->nativeScanCode());
       cachedAppEnableDisableShortcut_ = newShortcut;
+      this->compileShortcutTable();
    }
 }
 
@@ -1235,6 +1355,17 @@ SpShortcut PreferencesManager::appEnableDisableShortcut() const
 }
 
 
+//**********************************************************************************************************************
+/// The table only contains the shortcuts that are enabled.
+///
+/// \return The table of the global shortcuts
+//**********************************************************************************************************************
+SpShortcutTable PreferencesManager::shortcutTable() const
+{
+   return std::atomic_load(&shortcutTable_);
+}
+
+
 //**********************************************************************************************************************
 //
 //**********************************************************************************************************************
@@ -12,6 +12,8 @@
 
 
 #include "Shortcut.h"
+#include "ShortcutTable.h"
+#include "Combo/MatchResolutionPolicy.h"
 
 
 //**********************************************************************************************************************
@@ -92,6 +94,12 @@ public: // member functions
    void  setDelayBetweenKeystrokesMs(qint32 value) const; ///< Set the 'delay between keystrokes'
    static qint32 minDelayBetweenKeystrokesMs(); ///< Get the minimum value for the 'delay beetween keystrokes' preference.
    static qint32 maxDelayBetweenKeystrokesMs(); ///< Get the maximum value for the 'delay beetween keystrokes' preference.
+   EMatchResolutionPolicy matchResolutionPolicy() const; ///< Get the value for the 'Match resolution policy' preference
+   void setMatchResolutionPolicy(EMatchResolutionPolicy policy); ///< Set the value for the 'Match resolution policy' preference
+   bool caseInsensitiveMatching() const; ///< Get the value for the 'Case insensitive matching' preference
+   void setCaseInsensitiveMatching(bool value); ///< Set the value for the 'Case insensitive matching' preference
+   bool normalizationInsensitiveMatching() const; ///< Get the value for the 'Normalization insensitive matching' preference
+   void setNormalizationInsensitiveMatching(bool value); ///< Set the value for the 'Normalization insensitive matching' preference
    bool comboPickerEnabled() const; ///< Get the value for the 'Combo picker enabled'  preference.
    void setComboPickerEnabled(bool value); ///< Set the value for the 'Combo picker enabled'  preference.
    void setComboPickerShortcut(SpShortcut const& shortcut); ///< Set the combo picker shortcut.
@@ -101,6 +109,7 @@ public: // member functions
    bool  enableAppEnableDisableShortcut() const; ///< Get the value for the 'Enable app enable/disable' shortcut.
    void setAppEnableDisableShortcut(SpShortcut const& shortcut); ///< Set the shortcut short to enable/disable the application.
    SpShortcut appEnableDisableShortcut() const; ///< Retrieve the shortcut to enable/disable the application.
+   SpShortcutTable shortcutTable() const; ///< Retrieve the table of the enabled global shortcuts
    static SpShortcut defaultAppEnableDisableShortcut(); ///< Return the default combo shortcut to enable/disable the application. 
    void setBeeftextEnabled(bool enabled); ///< Set if beeftext is enabled.
    bool beeftextEnabled() const; ///< Set if beeftext is enabled.
@@ -110,6 +119,7 @@ public: // member functions
 signals:
    void autoCheckForUpdatesChanged(bool value); ///< Signal emitted when the 'Auto check for updates' preference value changed
    void writeDebugLogFileChanged(bool value); ///< Signal emitted when the 'Write debug log file' preference value changed.s
+   void substitutionPreferencesChanged(); ///< Signal emitted when a preference used to detect substitutions changed
 
 private: // member functions
    PreferencesManager(); ///< Default constructor
@@ -119,6 +129,7 @@ private: // member functions
    void cacheComboTriggerShortcut(); ///< Read the combo trigger shortcut and cache it for faster access
    void cacheComboPickerShortcut(); ///< Read the combo picker shortcut and cache it for faster access
    void cacheAppEnableDisableShortcut(); ///< Read the app enable/disable shortcut and cache it for faster access.
+   void compileShortcutTable(); ///< Build and publish the table of the enabled global shortcuts
    void applyCustomThemePreference() const; ///< Apply the preference for the custom theme
    void applyAutoStartPreference() const; ///< Apply the preference for the auto-start
    void applyLocalePreference() const; ///< Apply the preference for the locale
@@ -135,9 +146,13 @@ private: // data members
    SpShortcut cachedComboPickerShortcut_; ///< Cached value for the 'combo picker shortcut' preference
    bool cachedEnableAppEnableDisableShortcut_ { true }; ///< Cached value for the 'app enable/disable shortcut' preference.
    SpShortcut cachedAppEnableDisableShortcut_; ///< Cached value for the 'app enable/disable shortcut' preference.
+   SpShortcutTable shortcutTable_; ///< The table of the enabled global shortcuts, accessed atomically
    bool cachedEmojiShortcodesEnabled_ { false }; ///< Cached value for the 'emoji shortcodes enabled' preference
    QString cachedEmojiLeftDelimiter_; ///< Cached value for the 'emoji left delimiter' preference.
    QString cachedEmojiRightDelimiter_; ///< Cached value for the 'emoji right delimiter' preference.
+   EMatchResolutionPolicy cachedMatchResolutionPolicy_ { RandomResolution }; ///< Cached value for the 'match resolution policy' preference.
+   bool cachedCaseInsensitiveMatching_ { false }; ///< Cached value for the 'case insensitive matching' preference.
+   bool cachedNormalizationInsensitiveMatching_ { false }; ///< Cached value for the 'normalization insensitive matching' preference.
    bool cachedBeeftextEnabled_ { true }; ///< Cached value for the 'Beeftext enabled' preference.
 };
 
@@ -0,0 +1,197 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the input source recording the events of another source to a trace file
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "RecordingInputSource.h"
+#include "BeeftextGlobals.h"
+
+
+namespace {
+
+
+qint32 const kRingCapacity = 4096; ///< The capacity of the ring of events waiting to be written. Must be a power of 2
+qint32 const kWriteIntervalMs = 100; ///< The interval between two writes of the events of the ring to the trace
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] source The recorded source. It must not be started
+/// \param[in] writer The writer of the trace file, which must be open
+//**********************************************************************************************************************
+RecordingInputSource::RecordingInputSource(UpInputSource source, std::unique_ptr<KeystrokeTraceWriter> writer)
+   : InputSource()
+   , InputSourceListener()
+   , source_(std::move(source))
+   , writer_(std::move(writer))
+   , ring_(kRingCapacity)
+{
+   elapsedTimer_.start();
+   writeTimer_.setInterval(kWriteIntervalMs);
+   QObject::connect(&writeTimer_, &QTimer::timeout, [this]() { this->writePendingEvents(); });
+   writeTimer_.start();
+}
+
+
+//**********************************************************************************************************************
+/// The source is stopped if it was started.
+///
+/// \return The recorded source
+//**********************************************************************************************************************
+UpInputSource RecordingInputSource::releaseSource()
+{
+   this->stop();
+   writeTimer_.stop();
+   this->writePendingEvents();
+   if (writer_)
+      writer_->close();
+   if (droppedEventCount_ > 0)
+      globals::debugLog().addWarning(QString("%1 events could not be recorded in the keystroke trace.")
+         .arg(droppedEventCount_));
+   return std::move(source_);
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of events recorded, including the ones that are not written to the trace yet
+//**********************************************************************************************************************
+qint32 RecordingInputSource::recordedEventCount() const
+{
+   return writer_ ? writer_->eventCount() + qint32(tail_.load(std::memory_order_acquire) -
+      head_.load(std::memory_order_acquire)) : 0;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] listener The listener
+//**********************************************************************************************************************
+void RecordingInputSource::start(InputSourceListener& listener)
+{
+   listener_ = &listener;
+   if (source_)
+      source_->start(*this);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void RecordingInputSource::stop()
+{
+   if (source_ && listener_)
+      source_->stop();
+   listener_ = nullptr;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] enabled Should keyboard events be delivered
+/// \return true if and only if keyboard events were delivered before the call
+//**********************************************************************************************************************
+bool RecordingInputSource::setKeyboardEventsEnabled(bool enabled)
+{
+   return source_ ? source_->setKeyboardEventsEnabled(enabled) : false;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The keystroke
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+/// \param[out] outKeyboardLayout The keyboard layout the keystroke was translated with, or 0 if unknown
+//**********************************************************************************************************************
+void RecordingInputSource::translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+   quint64& outKeyboardLayout)
+{
+   if (source_)
+      source_->translateKey(keyStroke, outIsDeadKey, outText, outKeyboardLayout);
+   else
+   {
+      outIsDeadKey = false;
+      outText.size = 0;
+      outKeyboardLayout = 0;
+   }
+   if (!hasPendingEvent_)
+      return;
+   keyboardLayout_ = outKeyboardLayout;
+   pendingEvent_.keyboardLayout = outKeyboardLayout;
+   pendingEvent_.isDeadKey = outIsDeadKey;
+   pendingEvent_.text = outText;
+   pendingEvent_.text.size = qBound<qint32>(0, outText.size, KeyText::Capacity);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The keystroke
+/// \return true if the event can be passed down to the keyboard hooked chain, and false it it should be removed
+//**********************************************************************************************************************
+bool RecordingInputSource::onKeyStroke(KeyStroke const& keyStroke)
+{
+   if (!listener_)
+      return true;
+   pendingEvent_ = ReplayInputSource::keyStrokeEvent(keyStroke, { { 0 }, 0 });
+   pendingEvent_.timestampNs = elapsedTimer_.nsecsElapsed();
+   pendingEvent_.keyboardLayout = keyboardLayout_; // replaced by the layout used if the keystroke is translated
+   hasPendingEvent_ = true;
+   bool const result = listener_->onKeyStroke(keyStroke);
+   hasPendingEvent_ = false;
+   this->record(pendingEvent_);
+   return result;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void RecordingInputSource::onMouseClick()
+{
+   if (!listener_)
+      return;
+   ReplayEvent event = ReplayInputSource::mouseClickEvent();
+   event.timestampNs = elapsedTimer_.nsecsElapsed();
+   event.keyboardLayout = keyboardLayout_;
+   this->record(event);
+   listener_->onMouseClick();
+}
+
+
+//**********************************************************************************************************************
+/// The function is called from the input hooks. It neither blocks nor allocates.
+///
+/// \param[in] event The event
+//**********************************************************************************************************************
+void RecordingInputSource::record(ReplayEvent const& event)
+{
+   if (!writer_)
+      return;
+   quint32 const tail = tail_.load(std::memory_order_relaxed);
+   if (tail - head_.load(std::memory_order_acquire) >= quint32(ring_.size()))
+   {
+      ++droppedEventCount_;
+      return;
+   }
+   ring_[tail & (quint32(ring_.size()) - 1)] = event;
+   tail_.store(tail + 1, std::memory_order_release);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void RecordingInputSource::writePendingEvents()
+{
+   if (!writer_)
+      return;
+   quint32 head = head_.load(std::memory_order_relaxed);
+   quint32 const tail = tail_.load(std::memory_order_acquire);
+   for (; head != tail; ++head)
+      writer_->write(ring_[head & (quint32(ring_.size()) - 1)]);
+   head_.store(tail, std::memory_order_release);
+}
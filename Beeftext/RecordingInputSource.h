@@ -0,0 +1,72 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the input source recording the events of another source to a trace file
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_RECORDING_INPUT_SOURCE_H
+#define BEEFTEXT_RECORDING_INPUT_SOURCE_H
+
+
+#include "InputSource.h"
+#include "KeystrokeTrace.h"
+#include <atomic>
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief An input source that records the events delivered by another source to a keystroke trace file
+///
+/// The source is inserted between an input source and its listener. Each keystroke is recorded once the listener has
+/// processed it, with the text the listener obtained by translating it, if any, so that replaying the trace reproduces
+/// the keystroke processing without depending on the keyboard layout of the machine replaying it.
+///
+/// Events are delivered by the input hooks, which must return quickly. The hooks only copy the events into a
+/// preallocated single producer, single consumer ring, without allocating or querying the system. Each event carries
+/// the keyboard layout obtained by the recorded source when it translated the keystroke, or by the last keystroke it
+/// translated for the other events. A timer drains the ring periodically and passes the events to the trace writer,
+/// which encodes them and writes them to the file. If the ring is full, events are dropped.
+//**********************************************************************************************************************
+class RecordingInputSource: public InputSource, public InputSourceListener
+{
+public: // member functions
+   RecordingInputSource(UpInputSource source, std::unique_ptr<KeystrokeTraceWriter> writer); ///< Default constructor
+   RecordingInputSource(RecordingInputSource const&) = delete; ///< Disabled copy constructor
+   RecordingInputSource(RecordingInputSource&&) = delete; ///< Disabled move constructor
+   ~RecordingInputSource() = default; ///< Default destructor
+   RecordingInputSource& operator=(RecordingInputSource const&) = delete; ///< Disabled assignment operator
+   RecordingInputSource& operator=(RecordingInputSource&&) = delete; ///< Disabled move assignment operator
+   UpInputSource releaseSource(); ///< Close the trace file and release the recorded source
+   qint32 recordedEventCount() const; ///< Return the number of events recorded
+   void start(InputSourceListener& listener) override; ///< Start delivering events to a listener
+   void stop() override; ///< Stop delivering events
+   bool setKeyboardEventsEnabled(bool enabled) override; ///< Enable or disable the delivery of keyboard events
+   void translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+      quint64& outKeyboardLayout) override; ///< Retrieve the text produced by a keystroke, and the keyboard layout used
+   bool onKeyStroke(KeyStroke const& keyStroke) override; ///< Process a keystroke
+   void onMouseClick() override; ///< Process a mouse click
+
+private: // member functions
+   void record(ReplayEvent const& event); ///< Push an event in the ring of events waiting to be written
+   void writePendingEvents(); ///< Write the events of the ring to the trace
+
+private: // data members
+   UpInputSource source_; ///< The recorded source
+   std::unique_ptr<KeystrokeTraceWriter> writer_; ///< The trace writer
+   InputSourceListener* listener_ { nullptr }; ///< The listener, if the source is started
+   ReplayEvent pendingEvent_ {}; ///< The keystroke being processed by the listener
+   bool hasPendingEvent_ { false }; ///< Is a keystroke being processed by the listener
+   quint64 keyboardLayout_ { 0 }; ///< The keyboard layout of the last translated keystroke, or 0 if unknown
+   QElapsedTimer elapsedTimer_; ///< The timer measuring the time elapsed since the recording started
+   std::vector<ReplayEvent> ring_; ///< The ring of events waiting to be written. Its size is a power of 2
+   std::atomic<quint32> head_ { 0 }; ///< The number of events taken from the ring so far, written by the consumer
+   std::atomic<quint32> tail_ { 0 }; ///< The number of events pushed in the ring so far, written by the producer
+   qint32 droppedEventCount_ { 0 }; ///< The number of events dropped because the ring was full
+   QTimer writeTimer_; ///< The timer that periodically writes the events of the ring to the trace
+};
+
+
+#endif // #ifndef BEEFTEXT_RECORDING_INPUT_SOURCE_H
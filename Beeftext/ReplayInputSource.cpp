@@ -0,0 +1,356 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the input source replaying a recorded stream of input events
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "ReplayInputSource.h"
+#include <cmath>
+
+
+namespace {
+
+
+qint32 const kMaxEventsPerTick = 1024; ///< The maximum number of events delivered each time the timer fires
+qint32 const kModifierCount = sizeof(kModifierVirtualKeys); ///< The number of keys whose state is recorded
+
+
+//**********************************************************************************************************************
+/// \param[in] virtualKey The virtual key
+/// \param[out] outEvent The event whose modifier states are updated
+/// \param[in] state The state of the key
+//**********************************************************************************************************************
+void setModifierState(quint8 virtualKey, ReplayEvent& outEvent, quint8 state)
+{
+   for (qint32 i = 0; i < kModifierCount; ++i)
+      if (kModifierVirtualKeys[i] == virtualKey)
+         outEvent.modifierStates[i] = state;
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The keystroke
+/// \param[in] text The text produced by the keystroke
+/// \param[in] isDeadKey Was the keystroke a dead key
+/// \return The event
+//**********************************************************************************************************************
+ReplayEvent ReplayInputSource::keyStrokeEvent(KeyStroke const& keyStroke, KeyText const& text, bool isDeadKey)
+{
+   ReplayEvent result = { ReplayEvent::KeyStrokeEvent, keyStroke.virtualKey, keyStroke.scanCode, { 0 }, isDeadKey,
+      text, 0, 0 };
+   for (qint32 i = 0; i < kModifierCount; ++i)
+      result.modifierStates[i] = keyStroke.keyboardState[kModifierVirtualKeys[i]];
+   result.text.size = qBound<qint32>(0, text.size, KeyText::Capacity);
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \return The event
+//**********************************************************************************************************************
+ReplayEvent ReplayInputSource::mouseClickEvent()
+{
+   return { ReplayEvent::MouseClickEvent, 0, 0, { 0 }, false, { { 0 }, 0 }, 0, 0 };
+}
+
+
+//**********************************************************************************************************************
+/// Letters, digits, space, return and backspace are typed using their key on a US keyboard layout, and the shift key
+/// is reported as pressed for uppercase letters. Other characters are sent using the packet pseudo-key, the way
+/// Windows reports characters typed using an input method.
+///
+/// \param[in] text The text
+/// \return The keystroke events
+//**********************************************************************************************************************
+std::vector<ReplayEvent> ReplayInputSource::eventsFromText(QString const& text)
+{
+   std::vector<ReplayEvent> result;
+   result.reserve(size_t(text.size()));
+   for (QChar c: text)
+   {
+      ushort const u = c.unicode();
+      ReplayEvent event = { ReplayEvent::KeyStrokeEvent, VirtualKeyPacket, 0, { 0 }, false, { { wchar_t(u) }, 1 }, 0,
+         0 };
+      if ((u >= 'a') && (u <= 'z'))
+         event.virtualKey = u - 'a' + 'A';
+      else if (((u >= 'A') && (u <= 'Z')) || ((u >= '0') && (u <= '9')))
+         event.virtualKey = u;
+      else if (' ' == u)
+         event.virtualKey = VirtualKeySpace;
+      else if ('\b' == u)
+         event.virtualKey = VirtualKeyBack;
+      else if (('\r' == u) || ('\n' == u))
+      {
+         event.virtualKey = VirtualKeyReturn;
+         event.text.chars[0] = L'\r';
+      }
+      if ((u >= 'A') && (u <= 'Z'))
+      {
+         setModifierState(VirtualKeyShift, event, 0x80);
+         setModifierState(VirtualKeyLeftShift, event, 0x80);
+      }
+      result.push_back(event);
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] parent The parent object of the source
+//**********************************************************************************************************************
+ReplayInputSource::ReplayInputSource(QObject* parent)
+   : QObject(parent)
+   , InputSource()
+{
+   timer_.setTimerType(Qt::PreciseTimer);
+   connect(&timer_, &QTimer::timeout, this, &ReplayInputSource::onTimer);
+}
+
+
+//**********************************************************************************************************************
+/// The stream is rewound.
+///
+/// \param[in] events The events to replay
+//**********************************************************************************************************************
+void ReplayInputSource::setEvents(std::vector<ReplayEvent> events)
+{
+   events_ = std::move(events);
+   this->rewind();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] events The events to append
+//**********************************************************************************************************************
+void ReplayInputSource::appendEvents(std::vector<ReplayEvent> const& events)
+{
+   events_.insert(events_.end(), events.begin(), events.end());
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of events to replay
+//**********************************************************************************************************************
+qint32 ReplayInputSource::eventCount() const
+{
+   return qint32(events_.size());
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of events replayed so far
+//**********************************************************************************************************************
+qint32 ReplayInputSource::replayedEventCount() const
+{
+   return nextEvent_;
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of events replayed per second, or 0 if events are replayed as fast as possible
+//**********************************************************************************************************************
+double ReplayInputSource::rate() const
+{
+   return rate_;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] eventsPerSecond The number of events replayed per second, or 0 to replay events as fast as possible
+//**********************************************************************************************************************
+void ReplayInputSource::setRate(double eventsPerSecond)
+{
+   rate_ = qMax(0.0, eventsPerSecond);
+   startEvent_ = nextEvent_;
+   elapsedTimer_.restart();
+   if (timer_.isActive())
+      timer_.start(((rate_ > 0.0) || useTimestamps_) ? 1 : 0);
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if events are replayed at the pace they were recorded
+//**********************************************************************************************************************
+bool ReplayInputSource::useTimestamps() const
+{
+   return useTimestamps_;
+}
+
+
+//**********************************************************************************************************************
+/// When enabled, the delay between two events is the difference of their timestamps, and the rate is ignored.
+///
+/// \param[in] use Should the events be replayed at the pace they were recorded
+//**********************************************************************************************************************
+void ReplayInputSource::setUseTimestamps(bool use)
+{
+   useTimestamps_ = use;
+   this->setRate(rate_);
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if all the events have been replayed
+//**********************************************************************************************************************
+bool ReplayInputSource::isFinished() const
+{
+   return nextEvent_ >= qint32(events_.size());
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void ReplayInputSource::rewind()
+{
+   nextEvent_ = 0;
+   startEvent_ = 0;
+   elapsedTimer_.restart();
+}
+
+
+//**********************************************************************************************************************
+/// The events are delivered on the calling thread, regardless of the rate, and the finished() signal is not emitted.
+///
+/// \param[in] listener The listener
+/// \return The number of events that were replayed
+//**********************************************************************************************************************
+qint32 ReplayInputSource::replayAll(InputSourceListener& listener)
+{
+   qint32 const first = nextEvent_;
+   while (!this->isFinished())
+      this->deliverEvent(listener);
+   return nextEvent_ - first;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] listener The listener
+//**********************************************************************************************************************
+void ReplayInputSource::start(InputSourceListener& listener)
+{
+   listener_ = &listener;
+   startEvent_ = nextEvent_;
+   elapsedTimer_.start();
+   timer_.start(((rate_ > 0.0) || useTimestamps_) ? 1 : 0);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void ReplayInputSource::stop()
+{
+   timer_.stop();
+   listener_ = nullptr;
+}
+
+
+//**********************************************************************************************************************
+/// Keystrokes replayed while keyboard events are disabled are discarded, the way the keyboard hook misses them.
+///
+/// \param[in] enabled Should keyboard events be delivered
+/// \return true if and only if keyboard events were delivered before the call
+//**********************************************************************************************************************
+bool ReplayInputSource::setKeyboardEventsEnabled(bool enabled)
+{
+   bool const result = keyboardEventsEnabled_;
+   keyboardEventsEnabled_ = enabled;
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// The text and the keyboard layout are the ones that were recorded with the keystroke being delivered.
+///
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+/// \param[out] outKeyboardLayout The keyboard layout the keystroke was translated with, or 0 if unknown
+//**********************************************************************************************************************
+void ReplayInputSource::translateKey(KeyStroke const&, bool& outIsDeadKey, KeyText& outText,
+   quint64& outKeyboardLayout)
+{
+   if ((currentEvent_ < 0) || (currentEvent_ >= qint32(events_.size())))
+   {
+      outIsDeadKey = false;
+      outText.size = 0;
+      outKeyboardLayout = 0;
+      return;
+   }
+   ReplayEvent const& event = events_[size_t(currentEvent_)];
+   outIsDeadKey = event.isDeadKey;
+   outText = event.text;
+   outKeyboardLayout = event.keyboardLayout;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] listener The listener
+//**********************************************************************************************************************
+void ReplayInputSource::deliverEvent(InputSourceListener& listener)
+{
+   ReplayEvent const& event = events_[size_t(nextEvent_)];
+   currentEvent_ = nextEvent_++;
+   if (ReplayEvent::MouseClickEvent == event.type)
+      listener.onMouseClick();
+   else if (keyboardEventsEnabled_)
+   {
+      KeyStroke keyStroke = { event.virtualKey, event.scanCode, { 0 } };
+      for (qint32 i = 0; i < kModifierCount; ++i)
+         keyStroke.keyboardState[kModifierVirtualKeys[i]] = event.modifierStates[i];
+      listener.onKeyStroke(keyStroke);
+   }
+   currentEvent_ = -1;
+}
+
+
+//**********************************************************************************************************************
+/// When a rate is set or timestamps are used, the timer fires every millisecond and delivers the events that are due.
+/// Otherwise, it fires whenever the event loop is idle and delivers a batch of events.
+//**********************************************************************************************************************
+void ReplayInputSource::onTimer()
+{
+   if (!listener_)
+      return;
+   qint32 dueEvent = qint32(events_.size());
+   if (useTimestamps_)
+      dueEvent = this->dueEventFromTimestamps();
+   else if (rate_ > 0.0)
+   {
+      double const due = double(startEvent_) + std::floor(double(elapsedTimer_.nsecsElapsed()) * rate_ / 1e9);
+      dueEvent = qint32(qMin(double(dueEvent), due));
+   }
+   dueEvent = qMin(dueEvent, nextEvent_ + kMaxEventsPerTick);
+   while ((nextEvent_ < dueEvent) && listener_)
+      this->deliverEvent(*listener_);
+   if (this->isFinished())
+   {
+      timer_.stop();
+      emit finished();
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The delays are measured from the event that was next when replay was started.
+///
+/// \return The index of the first event whose time has not come yet
+//**********************************************************************************************************************
+qint32 ReplayInputSource::dueEventFromTimestamps() const
+{
+   qint32 const count = qint32(events_.size());
+   if (startEvent_ >= count)
+      return count;
+   qint64 const due = events_[size_t(startEvent_)].timestampNs + elapsedTimer_.nsecsElapsed();
+   qint32 result = nextEvent_;
+   while ((result < count) && (events_[size_t(result)].timestampNs <= due))
+      ++result;
+   return result;
+}
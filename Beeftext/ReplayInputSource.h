@@ -0,0 +1,103 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the input source replaying a recorded stream of input events
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_REPLAY_INPUT_SOURCE_H
+#define BEEFTEXT_REPLAY_INPUT_SOURCE_H
+
+
+#include "InputSource.h"
+#include "KeyClassification.h"
+#include <vector>
+
+
+//**********************************************************************************************************************
+/// \brief A recorded input event
+//**********************************************************************************************************************
+struct ReplayEvent
+{
+   enum EType {
+      KeyStrokeEvent = 0, ///< A keystroke
+      MouseClickEvent = 1, ///< A mouse click
+   }; ///< The type of event
+
+   EType type; ///< The type of the event
+   quint32 virtualKey; ///< The virtual key code, for keystrokes
+   quint32 scanCode; ///< The scan code, for keystrokes
+   quint8 modifierStates[sizeof(kModifierVirtualKeys)]; ///< The state of the keys listed in kModifierVirtualKeys, for keystrokes
+   bool isDeadKey; ///< Was the keystroke a dead key
+   KeyText text; ///< The text that was produced by the keystroke
+   qint64 timestampNs; ///< The time of the event relative to the start of the recording, in nanoseconds
+   quint64 keyboardLayout; ///< The keyboard layout that was active when the event occurred, or 0 if unknown
+}; ///< A recorded input event
+
+
+//**********************************************************************************************************************
+/// \brief An input source replaying a recorded stream of input events
+///
+/// The source does not depend on the platform, so it can be used to drive, time and stress test the processing of
+/// keystrokes headless. Recorded keystrokes carry the text they produced, so the translation of keystrokes does not
+/// depend on the keyboard layout of the machine replaying them. Events are delivered from the event loop of the
+/// thread owning the source, either at a fixed rate, at the pace they were recorded, or as fast as possible, or
+/// synchronously by replayAll().
+//**********************************************************************************************************************
+class ReplayInputSource: public QObject, public InputSource
+{
+   Q_OBJECT
+public: // static member functions
+   static ReplayEvent keyStrokeEvent(KeyStroke const& keyStroke, KeyText const& text, bool isDeadKey = false); ///< Create a keystroke event
+   static ReplayEvent mouseClickEvent(); ///< Create a mouse click event
+   static std::vector<ReplayEvent> eventsFromText(QString const& text); ///< Create the keystroke events that would type a text
+
+public: // member functions
+   explicit ReplayInputSource(QObject* parent = nullptr); ///< Default constructor
+   ReplayInputSource(ReplayInputSource const&) = delete; ///< Disabled copy constructor
+   ReplayInputSource(ReplayInputSource&&) = delete; ///< Disabled move constructor
+   ~ReplayInputSource() = default; ///< Default destructor
+   ReplayInputSource& operator=(ReplayInputSource const&) = delete; ///< Disabled assignment operator
+   ReplayInputSource& operator=(ReplayInputSource&&) = delete; ///< Disabled move assignment operator
+   void setEvents(std::vector<ReplayEvent> events); ///< Set the events to replay
+   void appendEvents(std::vector<ReplayEvent> const& events); ///< Append events to replay
+   qint32 eventCount() const; ///< Return the number of events to replay
+   qint32 replayedEventCount() const; ///< Return the number of events replayed so far
+   double rate() const; ///< Return the rate at which events are replayed
+   void setRate(double eventsPerSecond); ///< Set the rate at which events are replayed
+   bool useTimestamps() const; ///< Check whether events are replayed at the pace they were recorded
+   void setUseTimestamps(bool use); ///< Set whether events are replayed at the pace they were recorded
+   bool isFinished() const; ///< Check whether all events have been replayed
+   void rewind(); ///< Rewind the stream, so that it is replayed again from the start
+   qint32 replayAll(InputSourceListener& listener); ///< Synchronously replay all the remaining events
+   void start(InputSourceListener& listener) override; ///< Start delivering events to a listener
+   void stop() override; ///< Stop delivering events
+   bool setKeyboardEventsEnabled(bool enabled) override; ///< Enable or disable the delivery of keyboard events
+   void translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+      quint64& outKeyboardLayout) override; ///< Retrieve the text produced by a keystroke, and the keyboard layout used
+
+signals:
+   void finished(); ///< Signal emitted when all the events have been replayed
+
+private: // member functions
+   void deliverEvent(InputSourceListener& listener); ///< Deliver the next event to a listener
+   void onTimer(); ///< Slot for the timer
+   qint32 dueEventFromTimestamps() const; ///< Return the index of the first event that is not due, based on timestamps
+
+private: // data members
+   std::vector<ReplayEvent> events_; ///< The events to replay
+   qint32 nextEvent_ { 0 }; ///< The index of the next event to replay
+   qint32 currentEvent_ { -1 }; ///< The index of the event being delivered, or -1
+   qint32 startEvent_ { 0 }; ///< The index of the next event when replay was started, used for pacing
+   double rate_ { 0.0 }; ///< The number of events replayed per second, or 0 to replay as fast as possible
+   bool useTimestamps_ { false }; ///< Are events replayed at the pace they were recorded. Takes precedence over rate_
+   bool keyboardEventsEnabled_ { true }; ///< Are keyboard events delivered
+   InputSourceListener* listener_ { nullptr }; ///< The listener, if the source is started
+   QTimer timer_; ///< The timer driving the replay
+   QElapsedTimer elapsedTimer_; ///< The timer measuring the time elapsed since replay was started, used for pacing
+};
+
+
+#endif // #ifndef BEEFTEXT_REPLAY_INPUT_SOURCE_H
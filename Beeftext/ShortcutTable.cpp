@@ -0,0 +1,95 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the table of global shortcuts
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "ShortcutTable.h"
+#include "KeyClassification.h"
+
+
+namespace {
+
+
+quint32 const kControlBit = 0x01; ///< The bit of the modifier mask for the control keys
+quint32 const kAltBit = 0x02; ///< The bit of the modifier mask for the alt keys
+quint32 const kWinBit = 0x04; ///< The bit of the modifier mask for the Windows keys
+quint32 const kShiftBit = 0x08; ///< The bit of the modifier mask for the shift keys
+quint32 const kModifierBitCount = 4; ///< The number of bits in the modifier mask
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+ShortcutTable::ShortcutTable()
+{
+   actions_.fill(NoAction);
+}
+
+
+//**********************************************************************************************************************
+/// If a shortcut with the same keystroke is already in the table, the table is not modified, so shortcuts must be
+/// added by decreasing priority.
+///
+/// \param[in] shortcut The shortcut
+/// \param[in] action The action of the shortcut
+/// \return true if and only if the shortcut was added
+//**********************************************************************************************************************
+bool ShortcutTable::add(SpShortcut const& shortcut, EAction action)
+{
+   if ((!shortcut) || (NoAction == action) || (shortcut->nativeVirtualKey() > 0xff))
+      return false;
+   quint8& entry = actions_[(shortcut->nativeVirtualKey() << kModifierBitCount) |
+      modifierMask(shortcut->nativeModifiers())];
+   if (entry != NoAction)
+      return false;
+   entry = quint8(action);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The keystroke
+/// \return The action of the shortcut matching the keystroke
+/// \return NoAction if the keystroke is not a shortcut
+//**********************************************************************************************************************
+ShortcutTable::EAction ShortcutTable::action(KeyStroke const& keyStroke) const
+{
+   if (keyStroke.virtualKey > 0xff)
+      return NoAction;
+   return EAction(actions_[(keyStroke.virtualKey << kModifierBitCount) | modifierMask(keyStroke.keyboardState)]);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] modifiers The modifiers of the shortcut
+/// \return The modifier mask
+//**********************************************************************************************************************
+quint32 ShortcutTable::modifierMask(Qt::KeyboardModifiers modifiers)
+{
+   return (modifiers.testFlag(Qt::ControlModifier) ? kControlBit : 0)
+      | (modifiers.testFlag(Qt::AltModifier) ? kAltBit : 0)
+      | (modifiers.testFlag(Qt::MetaModifier) ? kWinBit : 0)
+      | (modifiers.testFlag(Qt::ShiftModifier) ? kShiftBit : 0);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyboardState The keyboard state
+/// \return The modifier mask
+//**********************************************************************************************************************
+quint32 ShortcutTable::modifierMask(quint8 const* keyboardState)
+{
+   quint8 const* ks = keyboardState;
+   return (((ks[VirtualKeyLeftControl] | ks[VirtualKeyRightControl]) & 0x80) ? kControlBit : 0)
+      | (((ks[VirtualKeyLeftMenu] | ks[VirtualKeyRightMenu]) & 0x80) ? kAltBit : 0)
+      | (((ks[VirtualKeyLeftWin] | ks[VirtualKeyRightWin]) & 0x80) ? kWinBit : 0)
+      | (((ks[VirtualKeyLeftShift] | ks[VirtualKeyRightShift]) & 0x80) ? kShiftBit : 0);
+}
@@ -0,0 +1,59 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the table of global shortcuts
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_SHORTCUT_TABLE_H
+#define BEEFTEXT_SHORTCUT_TABLE_H
+
+
+#include "Shortcut.h"
+#include "InputSource.h"
+#include <array>
+
+
+//**********************************************************************************************************************
+/// \brief A table mapping the keystrokes of the global shortcuts to their action
+///
+/// The table is indexed by the virtual key and the state of the modifiers keys, so identifying the shortcut matching
+/// a keystroke takes a single lookup, whatever the number of shortcuts. Tables are immutable once published by the
+/// preferences manager.
+//**********************************************************************************************************************
+class ShortcutTable
+{
+public: // data types
+   enum EAction
+   {
+      NoAction = 0, ///< The keystroke is not a shortcut
+      AppEnableDisableAction = 1, ///< The shortcut that enables or disables the application
+      ComboTriggerAction = 2, ///< The shortcut that triggers manual substitution
+      ComboPickerAction = 3, ///< The shortcut that displays the combo picker window
+   }; ///< Enumeration for the actions of the shortcuts
+
+public: // member functions
+   ShortcutTable(); ///< Default constructor
+   ShortcutTable(ShortcutTable const&) = delete; ///< Disabled copy constructor
+   ShortcutTable(ShortcutTable&&) = delete; ///< Disabled move constructor
+   ~ShortcutTable() = default; ///< Default destructor
+   ShortcutTable& operator=(ShortcutTable const&) = delete; ///< Disabled assignment operator
+   ShortcutTable& operator=(ShortcutTable&&) = delete; ///< Disabled move assignment operator
+   bool add(SpShortcut const& shortcut, EAction action); ///< Add a shortcut to the table
+   EAction action(KeyStroke const& keyStroke) const; ///< Return the action of the shortcut matching a keystroke
+
+private: // static member functions
+   static quint32 modifierMask(Qt::KeyboardModifiers modifiers); ///< Return the modifier mask of a shortcut
+   static quint32 modifierMask(quint8 const* keyboardState); ///< Return the modifier mask of a keyboard state
+
+private: // data members
+   std::array<quint8, 4096> actions_; ///< The actions, indexed by the virtual key and the modifier mask
+};
+
+
+typedef std::shared_ptr<ShortcutTable const> SpShortcutTable; ///< Type definition for shared pointer to ShortcutTable
+
+
+#endif // #ifndef BEEFTEXT_SHORTCUT_TABLE_H
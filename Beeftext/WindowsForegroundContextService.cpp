@@ -0,0 +1,136 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the foreground context service based on the window events of Windows
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "WindowsForegroundContextService.h"
+#include <Psapi.h>
+#include <XMiLib/Exception.h>
+
+
+using namespace xmilib;
+
+
+WindowsForegroundContextService* WindowsForegroundContextService::activeService_ = nullptr;
+
+
+//**********************************************************************************************************************
+/// Restoring a minimized window does not always trigger a foreground event, so the end of minimization is watched
+/// too.
+//**********************************************************************************************************************
+WindowsForegroundContextService::WindowsForegroundContextService()
+   : ForegroundContextService()
+{
+   if (activeService_)
+      throw Exception("Another Windows foreground context service already exists.");
+   foregroundHook_ = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, winEventProcedure, 0,
+      0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+   minimizeHook_ = SetWinEventHook(EVENT_SYSTEM_MINIMIZEEND, EVENT_SYSTEM_MINIMIZEEND, nullptr, winEventProcedure, 0,
+      0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+   if ((!foregroundHook_) || (!minimizeHook_))
+   {
+      if (foregroundHook_)
+         UnhookWinEvent(foregroundHook_);
+      if (minimizeHook_)
+         UnhookWinEvent(minimizeHook_);
+      throw Exception("Could not register the foreground window event hooks.");
+   }
+   activeService_ = this;
+   this->update(GetForegroundWindow());
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+WindowsForegroundContextService::~WindowsForegroundContextService()
+{
+   UnhookWinEvent(foregroundHook_);
+   UnhookWinEvent(minimizeHook_);
+   activeService_ = nullptr;
+}
+
+
+//**********************************************************************************************************************
+/// The events are not reported for the windows of Beeftext, and they may not have been processed yet when the
+/// context is queried, so the cached window is checked against the foreground window, which does not require
+/// inspecting the process. The context is only updated if they differ.
+///
+/// \return The context of the foreground application
+//**********************************************************************************************************************
+ForegroundContext const& WindowsForegroundContextService::context()
+{
+   // ReSharper disable once CppLocalVariableMayBeConst
+   HWND hwnd = GetForegroundWindow();
+   if (quint64(reinterpret_cast<quintptr>(hwnd)) != context_.window)
+      this->update(hwnd);
+   return context_;
+}
+
+
+//**********************************************************************************************************************
+/// The keyboard layout can be changed without changing the foreground window, so it is not cached. It is retrieved
+/// from the thread ID of the foreground window, once the cached context has been checked against the foreground
+/// window, as it is by context().
+///
+/// \return The identifier of the keyboard layout of the foreground window
+/// \return 0 if there is no foreground window
+//**********************************************************************************************************************
+quint64 WindowsForegroundContextService::keyboardLayout()
+{
+   ForegroundContext const& context = this->context();
+   return context.window ? quint64(reinterpret_cast<quintptr>(GetKeyboardLayout(context.threadId))) : 0;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] hwnd The handle of the foreground window, which can be null
+//**********************************************************************************************************************
+void WindowsForegroundContextService::update(HWND hwnd)
+{
+   context_ = ForegroundContext();
+   if (!hwnd)
+      return;
+   DWORD processId = 0;
+   context_.window = quint64(reinterpret_cast<quintptr>(hwnd));
+   context_.threadId = GetWindowThreadProcessId(hwnd, &processId);
+   context_.processId = processId;
+   context_.isBeeftext = (QCoreApplication::applicationPid() == processId);
+   context_.executableFileName = executableFileName(processId);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] processId The ID of the process
+/// \return The name of the executable of the process, including its extension (e.g. "explorer.exe")
+/// \return A null string in case of failure
+//**********************************************************************************************************************
+QString WindowsForegroundContextService::executableFileName(quint32 processId)
+{
+   WCHAR buffer[MAX_PATH + 1] = { 0 };
+   // ReSharper disable once CppLocalVariableMayBeConst
+   HANDLE processHandle = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
+   if (!processHandle)
+      return QString();
+   bool const ok = GetModuleFileNameEx(processHandle, nullptr, buffer, MAX_PATH);
+   CloseHandle(processHandle);
+   return ok ? QFileInfo(QDir::fromNativeSeparators(QString::fromWCharArray(buffer))).fileName() : QString();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] hwnd The handle of the window that generated the event
+/// \param[in] idObject The identifier of the object associated with the event
+//**********************************************************************************************************************
+void CALLBACK WindowsForegroundContextService::winEventProcedure(HWINEVENTHOOK, DWORD, HWND hwnd, LONG idObject, LONG,
+   DWORD, DWORD)
+{
+   if (activeService_ && (OBJID_WINDOW == idObject) && hwnd &&
+      (reinterpret_cast<quintptr>(hwnd) != activeService_->context_.window))
+      activeService_->update(hwnd);
+}
@@ -0,0 +1,54 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the foreground context service based on the window events of Windows
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_WINDOWS_FOREGROUND_CONTEXT_SERVICE_H
+#define BEEFTEXT_WINDOWS_FOREGROUND_CONTEXT_SERVICE_H
+
+
+#include "ForegroundContextService.h"
+
+
+//**********************************************************************************************************************
+/// \brief A foreground context service updated by the foreground change events of Windows
+///
+/// The context is updated when Windows reports a change of foreground window, which is when the executable of the
+/// foreground process is looked up. The events are delivered by the message loop of the thread that created the
+/// service, so only one instance of the class can exist at a time, and it must be created on the GUI thread.
+//**********************************************************************************************************************
+class WindowsForegroundContextService: public ForegroundContextService
+{
+public: // member functions
+   WindowsForegroundContextService(); ///< Default constructor
+   WindowsForegroundContextService(WindowsForegroundContextService const&) = delete; ///< Disabled copy constructor
+   WindowsForegroundContextService(WindowsForegroundContextService&&) = delete; ///< Disabled move constructor
+   ~WindowsForegroundContextService(); ///< Destructor
+   WindowsForegroundContextService& operator=(WindowsForegroundContextService const&) = delete; ///< Disabled assignment operator
+   WindowsForegroundContextService& operator=(WindowsForegroundContextService&&) = delete; ///< Disabled move assignment operator
+   ForegroundContext const& context() override; ///< Return the context of the foreground application
+   quint64 keyboardLayout() override; ///< Return the identifier of the keyboard layout of the foreground window
+
+private: // member functions
+   void update(HWND hwnd); ///< Update the context for a foreground window
+
+private: // static member functions
+   static QString executableFileName(quint32 processId); ///< Return the file name of the executable of a process
+   static void CALLBACK winEventProcedure(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject, LONG idChild,
+      DWORD eventThread, DWORD eventTime); ///< The window event callback
+
+private: // static data members
+   static WindowsForegroundContextService* activeService_; ///< The existing instance of the class, if any
+
+private: // data members
+   HWINEVENTHOOK foregroundHook_ { nullptr }; ///< The hook notified of foreground window changes
+   HWINEVENTHOOK minimizeHook_ { nullptr }; ///< The hook notified of windows being restored
+   ForegroundContext context_; ///< The context
+};
+
+
+#endif // #ifndef BEEFTEXT_WINDOWS_FOREGROUND_CONTEXT_SERVICE_H
@@ -0,0 +1,234 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the input source based on the low level keyboard and mouse hooks of Windows
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "WindowsInputSource.h"
+#include "KeyClassification.h"
+#include "MemoizingKeyTranslator.h"
+#include "WindowsKeyTranslator.h"
+#include "BeeftextUtils.h"
+#include <XMiLib/Exception.h>
+
+
+using namespace xmilib;
+
+
+namespace {
+
+
+static_assert((VK_BACK == VirtualKeyBack) && (VK_RETURN == VirtualKeyReturn) && (VK_SPACE == VirtualKeySpace) &&
+   (VK_SHIFT == VirtualKeyShift) && (VK_CONTROL == VirtualKeyControl) &&
+   (VK_MENU == VirtualKeyMenu) && (VK_CAPITAL == VirtualKeyCapital) && (VK_PRIOR == VirtualKeyPrior) &&
+   (VK_NEXT == VirtualKeyNext) && (VK_END == VirtualKeyEnd) && (VK_HOME == VirtualKeyHome) &&
+   (VK_LEFT == VirtualKeyLeft) && (VK_UP == VirtualKeyUp) && (VK_RIGHT == VirtualKeyRight) &&
+   (VK_DOWN == VirtualKeyDown) && (VK_INSERT == VirtualKeyInsert) && (VK_DELETE == VirtualKeyDelete) &&
+   (VK_LWIN == VirtualKeyLeftWin) && (VK_RWIN == VirtualKeyRightWin) && (VK_LSHIFT == VirtualKeyLeftShift) &&
+   (VK_RSHIFT == VirtualKeyRightShift) && (VK_LCONTROL == VirtualKeyLeftControl) &&
+   (VK_RCONTROL == VirtualKeyRightControl) && (VK_LMENU == VirtualKeyLeftMenu) && (VK_RMENU == VirtualKeyRightMenu) &&
+   (VK_PACKET == VirtualKeyPacket), "The virtual key codes do not match the ones of the Windows API");
+
+
+} // anonymous namespace
+
+
+WindowsInputSource* WindowsInputSource::activeSource_ = nullptr;
+
+
+//**********************************************************************************************************************
+/// This static member function is registered to be called whenever a key event occurs.
+///
+/// \param[in] nCode A code the hook procedure uses to determine how to process the message
+/// \param[in] wParam The identifier of the keyboard message
+/// \param[in] lParam A pointer to a KBDLLHOOKSTRUCT structure.
+//**********************************************************************************************************************
+LRESULT CALLBACK WindowsInputSource::keyboardProcedure(int nCode, WPARAM wParam, LPARAM lParam)
+{
+   if (((WM_KEYDOWN == wParam) || (WM_SYSKEYDOWN == wParam)) && activeSource_ && activeSource_->listener_)
+   {
+      // The hook must return quickly, so nothing is allocated on this path
+      KeyStroke keyStroke = { 0, 0, { 0 } };
+      KBDLLHOOKSTRUCT* keyEvent = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
+
+      // we ignore shift / caps lock key events
+      if (kIgnoredVirtualKeys.contains(keyEvent->vkCode))
+         return CallNextHookEx(nullptr, nCode, wParam, lParam);
+      keyStroke.virtualKey = keyEvent->vkCode;
+      keyStroke.scanCode = keyEvent->scanCode;
+      // GetKeyboardState() do not properly report state for modifier keys if the key event in a window other that one
+      // from the current process, so we need to manually fetch the valid states manually using GetKeyState()
+      // We do not actually need the state of the other key, so we do not event bother calling GetKeyboardState()
+      for (quint8 const key: kModifierVirtualKeys)
+         keyStroke.keyboardState[key] = quint8(GetKeyState(key));
+
+      // our event handler will return false if we want to 'intercept' the keystroke and not pass it to the next hook,
+      // but the MSDN documentation says we MUST do it if nCode < 0
+      if ((!activeSource_->listener_->onKeyStroke(keyStroke)) && (nCode >= 0))
+         return 0;
+   }
+   return CallNextHookEx(nullptr, nCode, wParam, lParam);
+}
+
+
+//**********************************************************************************************************************
+/// This static member function is registered to be called whenever a mouse event occurs.
+///
+/// \param[in] nCode A code the hook procedure uses to determine how to process the message
+/// \param[in] wParam The identifier of the mouse message
+/// \param[in] lParam A pointer to a M structure.
+//**********************************************************************************************************************
+LRESULT CALLBACK WindowsInputSource::mouseProcedure(int nCode, WPARAM wParam, LPARAM lParam)
+{
+   if (((WM_LBUTTONDOWN == wParam) || (WM_RBUTTONDOWN == wParam) || (WM_MOUSEWHEEL == wParam) ||
+      (WM_MBUTTONDOWN == wParam)) && activeSource_ && activeSource_->listener_) // note we consider mouse wheel moves as clicks
+   {
+      activeSource_->listener_->onMouseClick();
+   }
+   return CallNextHookEx(nullptr, nCode, wParam, lParam);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+WindowsInputSource::WindowsInputSource()
+   : InputSource()
+{
+   // Windows version before Windows 10 build 1607, there is not option to ensure that ToUnicode() / ToUnicodeEx does
+   // not modify the keyboard state, which forces us to perform a special treatment for dead keys.
+   if (isAppRunningOnWindows10OrHigher())
+      translator_ = std::make_unique<MemoizingKeyTranslator>(std::make_unique<WindowsKeyTranslator>());
+   else
+      translator_ = std::make_unique<LegacyWindowsKeyTranslator>();
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+WindowsInputSource::~WindowsInputSource()
+{
+   this->stop();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] listener The listener
+//**********************************************************************************************************************
+void WindowsInputSource::start(InputSourceListener& listener)
+{
+   if (activeSource_ && (activeSource_ != this))
+      throw Exception("Another Windows input source is already started.");
+   activeSource_ = this;
+   listener_ = &listener;
+   this->enableKeyboardHook();
+#ifdef NDEBUG
+   // to avoid being locked with all input unresponsive when in debug (because one forgot that breakpoints should be
+   // avoided, for instance), we only enable the low level mouse hook in release configuration
+   this->enableMouseHook();
+#endif
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void WindowsInputSource::stop()
+{
+   this->disableKeyboardHook();
+   this->disableMouseHook();
+   listener_ = nullptr;
+   if (this == activeSource_)
+      activeSource_ = nullptr;
+}
+
+
+//**********************************************************************************************************************
+/// The keyboard hook is removed while disabled, so that the keystrokes synthesized by the application are not seen
+/// by the hook.
+///
+/// \param[in] enabled The new state of the keyboard hook
+/// \return true if and only if the keyboard hook was enabled before the call
+//**********************************************************************************************************************
+bool WindowsInputSource::setKeyboardEventsEnabled(bool enabled)
+{
+   bool const result = keyboardHook_;
+   if (enabled && listener_)
+      this->enableKeyboardHook();
+   else
+      this->disableKeyboardHook();
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The key stroke
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+/// \param[out] outKeyboardLayout The keyboard layout the keystroke was translated with, or 0 if unknown
+//**********************************************************************************************************************
+void WindowsInputSource::translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+   quint64& outKeyboardLayout)
+{
+   outKeyboardLayout = translator_->keyboardLayout();
+   translator_->translateKey(keyStroke, outKeyboardLayout, outIsDeadKey, outText);
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void WindowsInputSource::enableKeyboardHook()
+{
+   if (keyboardHook_)
+      return;
+   HMODULE const moduleHandle = GetModuleHandle(nullptr);
+   keyboardHook_ = SetWindowsHookEx(WH_KEYBOARD_LL, keyboardProcedure, moduleHandle, 0);
+   if (!keyboardHook_)
+      throw Exception("Could not register a keyboard hook.");
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void WindowsInputSource::disableKeyboardHook()
+{
+   if (keyboardHook_)
+   {
+      UnhookWindowsHookEx(keyboardHook_);
+      keyboardHook_ = nullptr;
+   }
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void WindowsInputSource::enableMouseHook()
+{
+   if (mouseHook_)
+      return;
+   HMODULE const moduleHandle = GetModuleHandle(nullptr);
+   mouseHook_ = SetWindowsHookEx(WH_MOUSE_LL, mouseProcedure, moduleHandle, 0);
+   if (!mouseHook_)
+      throw Exception("Could not register a mouse hook.");
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void WindowsInputSource::disableMouseHook()
+{
+   if (mouseHook_)
+   {
+      UnhookWindowsHookEx(mouseHook_);
+      mouseHook_ = nullptr;
+   }
+}
@@ -0,0 +1,59 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the input source based on the low level keyboard and mouse hooks of Windows
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_WINDOWS_INPUT_SOURCE_H
+#define BEEFTEXT_WINDOWS_INPUT_SOURCE_H
+
+
+#include "InputSource.h"
+#include "KeyTranslator.h"
+
+
+//**********************************************************************************************************************
+/// \brief An input source based on the low level keyboard and mouse hooks of Windows
+///
+/// The hooks are global to the process, so only one instance of the class can be started at a time.
+//**********************************************************************************************************************
+class WindowsInputSource: public InputSource
+{
+public: // member functions
+   WindowsInputSource(); ///< Default constructor
+   WindowsInputSource(WindowsInputSource const&) = delete; ///< Disabled copy constructor
+   WindowsInputSource(WindowsInputSource&&) = delete; ///< Disabled move constructor
+   ~WindowsInputSource(); ///< Destructor
+   WindowsInputSource& operator=(WindowsInputSource const&) = delete; ///< Disabled assignment operator
+   WindowsInputSource& operator=(WindowsInputSource&&) = delete; ///< Disabled move assignment operator
+   void start(InputSourceListener& listener) override; ///< Start delivering events to a listener
+   void stop() override; ///< Stop delivering events
+   bool setKeyboardEventsEnabled(bool enabled) override; ///< Enable or disable the delivery of keyboard events
+   void translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+      quint64& outKeyboardLayout) override; ///< Retrieve the text produced by a keystroke, and the keyboard layout used
+
+private: // member functions
+   void enableKeyboardHook(); ///< Enable the keyboard hook
+   void disableKeyboardHook(); ///< Disable the keyboard hook
+   void enableMouseHook(); ///< Enable the mouse hook
+   void disableMouseHook(); ///< Disable the mouse hook
+
+private: // static member functions
+   static LRESULT CALLBACK keyboardProcedure(int nCode, WPARAM wParam, LPARAM lParam); ///< The keyboard event callback
+   static LRESULT CALLBACK mouseProcedure(int nCode, WPARAM wParam, LPARAM lParam); ///< The mouse event callback
+
+private: // static data members
+   static WindowsInputSource* activeSource_; ///< The source that is currently started, if any
+
+private: // data members
+   InputSourceListener* listener_ { nullptr }; ///< The listener, if the source is started
+   HHOOK keyboardHook_ { nullptr }; ///< The handle to the keyboard hook used to be notified of keyboard events
+   HHOOK mouseHook_ { nullptr }; ///< The handle to the mouse hook used to be notified of mouse event
+   UpKeyTranslator translator_; ///< The translator of keystrokes into text
+};
+
+
+#endif // #ifndef BEEFTEXT_WINDOWS_INPUT_SOURCE_H
@@ -0,0 +1,101 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the key translators based on the Windows API
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "WindowsKeyTranslator.h"
+#include "ForegroundContextService.h"
+
+
+//**********************************************************************************************************************
+/// Windows allow each window to have its own input locale, so we try to obtain the locale (HKL) of the active window.
+/// The thread owning the foreground window is cached by the foreground context service.
+///
+/// \return The input locale of the foreground window
+/// \return 0 if the input locale of the foreground window could not be determined
+//**********************************************************************************************************************
+quint64 WindowsKeyTranslator::keyboardLayout()
+{
+   return ForegroundContextService::instance().keyboardLayout();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The key stroke
+/// \param[in] layout The input locale to use, or 0 to use the system-wide locale
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+//**********************************************************************************************************************
+void WindowsKeyTranslator::translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey,
+   KeyText& outText)
+{
+   // If we failed to obtain the locale of the foreground window we call ToUnicode instead, which use the system-wide
+   // locale. Bit 2 of the flags prevents the keyboard state of the kernel from being altered.
+   qint32 const size = layout
+      ? ToUnicodeEx(keyStroke.virtualKey, keyStroke.scanCode, keyStroke.keyboardState, outText.chars,
+         KeyText::Capacity, 1 << 2, reinterpret_cast<HKL>(quintptr(layout))) : ToUnicode(keyStroke.virtualKey,
+         keyStroke.scanCode, keyStroke.keyboardState, outText.chars, KeyText::Capacity, 1 << 2);
+   outIsDeadKey = (size < 0);
+   outText.size = qBound<qint32>(0, size, KeyText::Capacity);
+}
+
+
+//**********************************************************************************************************************
+/// \return 0, as the legacy translation always uses the system-wide locale
+//**********************************************************************************************************************
+quint64 LegacyWindowsKeyTranslator::keyboardLayout()
+{
+   return 0;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The key stroke
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+//**********************************************************************************************************************
+void LegacyWindowsKeyTranslator::translateKey(KeyStroke const& keyStroke, quint64, bool& outIsDeadKey,
+   KeyText& outText)
+{
+   // The core of this function is the call to ToUnicodeEx() - or ToUnicode() - who transforms a keystroke into
+   // an actual text output, taking into account the current input locale (a.k.a. keyboard layout).
+   // now the tricky part: ToUnicode() "consumes" the dead key that may be stored in the kernel-mode keyboard buffer
+   // so we need to manually restore the dead key by calling ToUnicode() again
+   WCHAR textBuffer[KeyText::Capacity] = { 0 };
+   outIsDeadKey = false;
+   outText.size = 0;
+   // for some unkown reasons, in this legacy code ToUnicodeEx cause failures with dead keys in some locales.
+   qint32 const size = ToUnicode(keyStroke.virtualKey, keyStroke.scanCode, keyStroke.keyboardState, outText.chars,
+      KeyText::Capacity, 0);
+
+   if (-1 == size)
+   {
+      // the key is a dead key. We have consumed it so we need to:
+      // 1 - Restore it by repeating the call to ToUnicode()
+      // 2 - Save the key because we will need to apply it again before the next 'normal' keystroke
+      ToUnicode(keyStroke.virtualKey, keyStroke.scanCode, keyStroke.keyboardState, textBuffer, KeyText::Capacity, 0);
+      deadKey_ = keyStroke;
+      outIsDeadKey = true;
+      return;
+   }
+
+   if (size > 0)
+   {
+      // The key is a normal key that will result in text output.
+      // if the previous key was a dead key, we have already consumed the dead key so we must restore it
+      outText.size = qMin<qint32>(size, KeyText::Capacity);
+      if (0 != deadKey_.virtualKey)
+      {
+         ToUnicode(deadKey_.virtualKey, deadKey_.scanCode, deadKey_.keyboardState, textBuffer, KeyText::Capacity, 0);
+         deadKey_.virtualKey = 0;
+      }
+   }
+
+   // final case: size is 0, the key is a modifier, we do nothing
+   // values of size < -1 also lead here but should not happen according to the documentation for ToUnicode()
+}
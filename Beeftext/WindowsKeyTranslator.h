@@ -0,0 +1,60 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the key translators based on the Windows API
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_WINDOWS_KEY_TRANSLATOR_H
+#define BEEFTEXT_WINDOWS_KEY_TRANSLATOR_H
+
+
+#include "KeyTranslator.h"
+
+
+//**********************************************************************************************************************
+/// \brief A key translator using the keyboard layout of the foreground window, that does not alter the keyboard state
+///
+/// The translator relies on a flag of ToUnicodeEx() that is only available starting with Windows 10 build 1607. It
+/// is stateless, so its translations can be cached.
+//**********************************************************************************************************************
+class WindowsKeyTranslator: public KeyTranslator
+{
+public: // member functions
+   WindowsKeyTranslator() = default; ///< Default constructor
+   WindowsKeyTranslator(WindowsKeyTranslator const&) = delete; ///< Disabled copy constructor
+   WindowsKeyTranslator(WindowsKeyTranslator&&) = delete; ///< Disabled move constructor
+   ~WindowsKeyTranslator() = default; ///< Default destructor
+   WindowsKeyTranslator& operator=(WindowsKeyTranslator const&) = delete; ///< Disabled assignment operator
+   WindowsKeyTranslator& operator=(WindowsKeyTranslator&&) = delete; ///< Disabled move assignment operator
+   quint64 keyboardLayout() override; ///< Return the identifier of the keyboard layout keystrokes are currently translated with
+   void translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey, KeyText& outText) override; ///< Retrieve the text produced by a keystroke with a keyboard layout
+};
+
+
+//**********************************************************************************************************************
+/// \brief The key translator for the versions of Windows prior to Windows 10 build 1607
+///
+/// The translation alters the dead key stored in the keyboard state of the kernel, which the translator restores.
+/// The translator is stateful, so its translations cannot be cached.
+//**********************************************************************************************************************
+class LegacyWindowsKeyTranslator: public KeyTranslator
+{
+public: // member functions
+   LegacyWindowsKeyTranslator() = default; ///< Default constructor
+   LegacyWindowsKeyTranslator(LegacyWindowsKeyTranslator const&) = delete; ///< Disabled copy constructor
+   LegacyWindowsKeyTranslator(LegacyWindowsKeyTranslator&&) = delete; ///< Disabled move constructor
+   ~LegacyWindowsKeyTranslator() = default; ///< Default destructor
+   LegacyWindowsKeyTranslator& operator=(LegacyWindowsKeyTranslator const&) = delete; ///< Disabled assignment operator
+   LegacyWindowsKeyTranslator& operator=(LegacyWindowsKeyTranslator&&) = delete; ///< Disabled move assignment operator
+   quint64 keyboardLayout() override; ///< Return the identifier of the keyboard layout keystrokes are currently translated with
+   void translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey, KeyText& outText) override; ///< Retrieve the text produced by a keystroke with a keyboard layout
+
+private: // data members
+   KeyStroke deadKey_ = { 0, 0, { 0 } }; ///< The currently active dead key
+};
+
+
+#endif // #ifndef BEEFTEXT_WINDOWS_KEY_TRANSLATOR_H
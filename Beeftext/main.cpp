@@ -18,6 +18,7 @@
 #include "I18nManager.h"
 #include "Combo/ComboManager.h"
 #include "Combo/LastUseFile.h"
+#include "WindowsForegroundContextService.h"
 #include <XMiLib/SingleInstanceApp.h>
 #include <XMiLib/SystemUtils.h>
 #include <XMiLib/Exception.h>
@@ -71,10 +72,12 @@ int main(int argc, char *argv[])
       debugLog.setMaxEntryCount(1);
       debugLog.addInfo(QString("%1 started.").arg(constants::kApplicationName));
       removeFileMarkedForDeletion();
+      ForegroundContextService::setInstance(std::make_unique<WindowsForegroundContextService>());
       ComboManager& comboManager = ComboManager::instance(); // we make sure the combo manager singleton is instanciated
       (void)UpdateManager::instance(); // we make sure the update manager singleton is instanciated
       (void)SensitiveApplicationManager::instance(); ///< We load the sensitive application files
       EmojiManager::instance().loadEmojis();
+      comboManager.updateMatchingSettings(); // the matching thread needs the length of the longest emoji shortcode
       MainWindow window;
 #ifdef Q_OS_WIN
       QWindowsWindowFunctions::setWindowActivationBehavior(QWindowsWindowFunctions::AlwaysActivateWindow);
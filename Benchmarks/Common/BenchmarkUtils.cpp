@@ -0,0 +1,214 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of utility functions for benchmarks
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "BenchmarkUtils.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+
+namespace {
+
+
+std::atomic<quint64> allocations { 0 }; ///< The number of allocations performed by the process
+
+
+} // anonymous namespace
+
+
+#if defined(__GLIBC__)
+
+
+// With the GNU C library, the allocation functions defined in the executable take precedence over the ones of the C
+// library, including for the calls made by shared libraries such as Qt. We count the calls and forward them to the
+// C library implementation.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+
+//**********************************************************************************************************************
+/// \param[in] size The size of the block
+/// \return The allocated block
+//**********************************************************************************************************************
+void* malloc(size_t size) noexcept
+{
+   allocations.fetch_add(1, std::memory_order_relaxed);
+   return __libc_malloc(size);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] count The number of elements
+/// \param[in] size The size of an element
+/// \return The allocated block
+//**********************************************************************************************************************
+void* calloc(size_t count, size_t size) noexcept
+{
+   allocations.fetch_add(1, std::memory_order_relaxed);
+   return __libc_calloc(count, size);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] ptr The block to reallocate
+/// \param[in] size The new size of the block
+/// \return The reallocated block
+//**********************************************************************************************************************
+void* realloc(void* ptr, size_t size) noexcept
+{
+   allocations.fetch_add(1, std::memory_order_relaxed);
+   return __libc_realloc(ptr, size);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] ptr The block to free
+//**********************************************************************************************************************
+void free(void* ptr) noexcept
+{
+   __libc_free(ptr);
+}
+} // extern "C"
+
+
+#else
+
+
+// On other platforms, only the allocations performed through the C++ global allocation functions are counted. Qt
+// containers, which use malloc, are therefore not taken into account.
+
+
+//**********************************************************************************************************************
+/// \param[in] size The size of the block
+/// \return The allocated block
+//**********************************************************************************************************************
+void* operator new(size_t size)
+{
+   allocations.fetch_add(1, std::memory_order_relaxed);
+   void* const result = std::malloc(size ? size : 1);
+   if (!result)
+      throw std::bad_alloc();
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] ptr The block to free
+//**********************************************************************************************************************
+void operator delete(void* ptr) noexcept
+{
+   std::free(ptr);
+}
+
+
+#endif
+
+
+namespace benchmark {
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+Stopwatch::Stopwatch()
+   : start_(std::chrono::steady_clock::now())
+{
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void Stopwatch::restart()
+{
+   start_ = std::chrono::steady_clock::now();
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of nanoseconds elapsed since the stopwatch was started
+//**********************************************************************************************************************
+qint64 Stopwatch::elapsedNs() const
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+
+//**********************************************************************************************************************
+/// \return The number of memory allocations performed by the process so far
+//**********************************************************************************************************************
+quint64 allocationCount()
+{
+   return allocations.load(std::memory_order_relaxed);
+}
+
+
+//**********************************************************************************************************************
+/// \return true if and only if the allocation count includes the calls to malloc, and not only the allocations
+/// performed through the C++ operator new
+//**********************************************************************************************************************
+bool allocationCountIncludesMalloc()
+{
+#if defined(__GLIBC__)
+   return true;
+#else
+   return false;
+#endif
+}
+
+
+//**********************************************************************************************************************
+/// \return The peak resident set size of the process, in bytes
+/// \return -1 if the information is not available
+//**********************************************************************************************************************
+qint64 peakResidentSetSize()
+{
+#if defined(Q_OS_WIN)
+   PROCESS_MEMORY_COUNTERS counters {};
+   if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+      return -1;
+   return qint64(counters.PeakWorkingSetSize);
+#else
+   rusage usage {};
+   if (0 != getrusage(RUSAGE_SELF, &usage))
+      return -1;
+#if defined(Q_OS_MACOS)
+   return qint64(usage.ru_maxrss); // bytes on macOS
+#else
+   return qint64(usage.ru_maxrss) * 1024; // kilobytes on Linux
+#endif
+#endif
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] bytes The number of bytes
+/// \return A string containing the formatted number of bytes
+//**********************************************************************************************************************
+QString formatBytes(qint64 bytes)
+{
+   if (bytes < 0)
+      return "n/a";
+   if (bytes < 1024 * 1024)
+      return QString::number(double(bytes) / 1024.0, 'f', 1) + " KiB";
+   return QString::number(double(bytes) / (1024.0 * 1024.0), 'f', 1) + " MiB";
+}
+
+
+} // namespace benchmark
@@ -0,0 +1,49 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of utility functions for benchmarks
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_BENCHMARK_UTILS_H
+#define BEEFTEXT_BENCHMARK_UTILS_H
+
+
+#include <chrono>
+
+
+namespace benchmark {
+
+
+//**********************************************************************************************************************
+/// \brief A simple monotonic stopwatch
+//**********************************************************************************************************************
+class Stopwatch
+{
+public: // member functions
+   Stopwatch(); ///< Default constructor
+   Stopwatch(Stopwatch const&) = default; ///< Default copy constructor
+   Stopwatch(Stopwatch&&) = default; ///< Default move constructor
+   ~Stopwatch() = default; ///< Default destructor
+   Stopwatch& operator=(Stopwatch const&) = default; ///< Default assignment operator
+   Stopwatch& operator=(Stopwatch&&) = default; ///< Default move assignment operator
+   void restart(); ///< Restart the stopwatch
+   qint64 elapsedNs() const; ///< Return the number of nanoseconds elapsed since the stopwatch was started
+
+private: // data members
+   std::chrono::steady_clock::time_point start_; ///< The start time
+};
+
+
+quint64 allocationCount(); ///< Return the number of memory allocations performed by the process so far
+bool allocationCountIncludesMalloc(); ///< Check whether the allocation count includes malloc calls
+qint64 peakResidentSetSize(); ///< Return the peak resident set size of the process, in bytes
+QString formatBytes(qint64 bytes); ///< Format a number of bytes for display
+
+
+} // namespace benchmark
+
+
+#endif // #ifndef BEEFTEXT_BENCHMARK_UTILS_H
@@ -0,0 +1,82 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Implementation of the input source listener feeding the keystroke processing pipeline in benchmarks
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "PipelineListener.h"
+#include "KeyClassification.h"
+#include <chrono>
+
+
+namespace benchmark {
+
+
+namespace {
+
+
+//**********************************************************************************************************************
+/// \return The current value of the monotonic clock, in nanoseconds
+//**********************************************************************************************************************
+qint64 nowNs()
+{
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] source The input source
+/// \param[in] queue The keystroke queue
+//**********************************************************************************************************************
+PipelineListener::PipelineListener(InputSource& source, KeystrokeQueue& queue)
+   : InputSourceListener()
+   , source_(source)
+   , queue_(queue)
+{
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The keystroke
+/// \return true
+//**********************************************************************************************************************
+bool PipelineListener::onKeyStroke(KeyStroke const& keyStroke)
+{
+   lastEventTimestampNs_.store(nowNs(), std::memory_order_relaxed);
+   enqueueKeyStroke(keyStroke, source_, queue_);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void PipelineListener::onMouseClick()
+{
+   lastEventTimestampNs_.store(nowNs(), std::memory_order_relaxed);
+   KeystrokeEvent event;
+   event.type = KeystrokeEvent::ComboBreaker;
+   queue_.push(event);
+}
+
+
+//**********************************************************************************************************************
+/// The timestamps are read from the steady clock. The function can be called from any thread.
+///
+/// \return The time the last event was received, in nanoseconds
+//**********************************************************************************************************************
+qint64 PipelineListener::lastEventTimestampNs() const
+{
+   return lastEventTimestampNs_.load(std::memory_order_relaxed);
+}
+
+
+} // namespace benchmark
@@ -0,0 +1,48 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of the input source listener feeding the keystroke processing pipeline in benchmarks
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_BENCHMARK_PIPELINE_LISTENER_H
+#define BEEFTEXT_BENCHMARK_PIPELINE_LISTENER_H
+
+
+#include "InputSource.h"
+#include "Combo/KeystrokeQueue.h"
+#include <atomic>
+
+
+namespace benchmark {
+
+
+//**********************************************************************************************************************
+/// \brief An input source listener that processes keystrokes the way the input manager does, minus the shortcuts
+//**********************************************************************************************************************
+class PipelineListener: public InputSourceListener
+{
+public: // member functions
+   PipelineListener(InputSource& source, KeystrokeQueue& queue); ///< Default constructor
+   PipelineListener(PipelineListener const&) = delete; ///< Disabled copy constructor
+   PipelineListener(PipelineListener&&) = delete; ///< Disabled move constructor
+   ~PipelineListener() = default; ///< Default destructor
+   PipelineListener& operator=(PipelineListener const&) = delete; ///< Disabled assignment operator
+   PipelineListener& operator=(PipelineListener&&) = delete; ///< Disabled move assignment operator
+   bool onKeyStroke(KeyStroke const& keyStroke) override; ///< Process a keystroke
+   void onMouseClick() override; ///< Process a mouse click
+   qint64 lastEventTimestampNs() const; ///< Return the time the last event was received
+
+private: // data members
+   InputSource& source_; ///< The input source
+   KeystrokeQueue& queue_; ///< The keystroke queue
+   std::atomic<qint64> lastEventTimestampNs_ { 0 }; ///< The time the last event was received, read by the matching thread
+};
+
+
+} // namespace benchmark
+
+
+#endif // #ifndef BEEFTEXT_BENCHMARK_PIPELINE_LISTENER_H
@@ -0,0 +1,20 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Declaration of pre-compiled headers for the benchmarks
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#ifndef BEEFTEXT_BENCHMARK_STDAFX_H
+#define BEEFTEXT_BENCHMARK_STDAFX_H
+
+
+#include <QtCore> // most of the application source files compiled in the benchmarks only depend on Qt Core
+#ifdef QT_GUI_LIB
+#include <QtGui> // the snippet templates depend on the text document classes of Qt GUI
+#endif
+
+
+#endif // BEEFTEXT_BENCHMARK_STDAFX_H
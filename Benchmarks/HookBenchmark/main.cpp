@@ -0,0 +1,639 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Benchmark of the per-event cost of the keyboard hook path, using a fake input source and key translator, and
+/// check of the memoizing key translator and of the keyboard layout switches of the foreground window
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "BenchmarkUtils.h"
+#include "FakeForegroundContextService.h"
+#include "KeyClassification.h"
+#include "MemoizingKeyTranslator.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+
+//**********************************************************************************************************************
+/// \brief A key event, as received by the keyboard hook
+//**********************************************************************************************************************
+struct KeyEvent
+{
+   quint32 virtualKey; ///< The virtual key code
+   quint32 scanCode; ///< The scan code
+}; ///< A key event, as received by the keyboard hook
+
+
+//**********************************************************************************************************************
+/// \brief The result of a benchmark run
+//**********************************************************************************************************************
+struct RunResult
+{
+   qint64 ns { 0 }; ///< The time spent processing the events
+   quint64 allocations { 0 }; ///< The number of allocations performed while processing the events
+   quint64 queuedEvents { 0 }; ///< The number of events pushed in the keystroke queue
+   quint64 translations { 0 }; ///< The number of calls to the fake ToUnicodeEx() function
+}; ///< The result of a benchmark run
+
+
+qint32 const kDrainInterval = 1024; ///< The number of key events after which the keystroke queue is drained
+quint8 volatile gKeyStates[256] = { 0 }; ///< The fake key states returned by fakeGetKeyState()
+quint64 gTranslationCount = 0; ///< The number of calls to fakeToUnicode()
+quint64 const kFakeLayout = 0x04090409; ///< The identifier of the fake US keyboard layout
+quint64 const kFakeGermanLayout = 0x04070407; ///< The identifier of the fake German keyboard layout, swapping Y and Z
+quint32 const kFakeDeadKey = 0xde; ///< The virtual key of the dead key of the fake keyboard layouts (VK_OEM_7)
+
+
+//**********************************************************************************************************************
+/// \brief Fake version of the GetKeyState() function of the Windows API
+///
+/// \param[in] virtualKey The virtual key
+/// \return The state of the key
+//**********************************************************************************************************************
+short fakeGetKeyState(qint32 virtualKey)
+{
+   return short(gKeyStates[virtualKey & 0xff]);
+}
+
+
+//**********************************************************************************************************************
+/// \brief Fake key translator, standing for ToUnicodeEx() with a US or German keyboard layout
+///
+/// Letters are upper case if either shift is down or caps lock is toggled. The German layout swaps Y and Z.
+///
+/// \param[in] keyStroke The key stroke
+/// \param[in] layout The identifier of the keyboard layout
+/// \param[out] outChars The buffer receiving the characters
+/// \param[in] capacity The capacity of the buffer
+/// \return The number of characters written in the buffer
+//**********************************************************************************************************************
+qint32 fakeToUnicode(KeyStroke const& keyStroke, quint64 layout, wchar_t* outChars, qint32 capacity)
+{
+   ++gTranslationCount;
+   if (capacity < 1)
+      return 0;
+   quint32 vk = keyStroke.virtualKey;
+   bool const upper = (0 != (keyStroke.keyboardState[VirtualKeyShift] & 0x80)) !=
+      (0 != (keyStroke.keyboardState[VirtualKeyCapital] & 0x01));
+   if ((kFakeGermanLayout == layout) && (('Y' == vk) || ('Z' == vk)))
+      vk = ('Y' == vk) ? 'Z' : 'Y';
+   if ((vk >= 'A') && (vk <= 'Z'))
+      outChars[0] = wchar_t(upper ? vk : vk - 'A' + 'a');
+   else if ((vk >= '0') && (vk <= '9'))
+      outChars[0] = wchar_t(vk);
+   else if (quint32(VirtualKeySpace) == vk)
+      outChars[0] = L' ';
+   else if (quint32(VirtualKeyReturn) == vk)
+      outChars[0] = L'\r';
+   else if (VirtualKeyBack == vk)
+      outChars[0] = L'\b';
+   else
+      return 0;
+   return 1;
+}
+
+
+//**********************************************************************************************************************
+/// \brief A key translator based on fakeToUnicode()
+//**********************************************************************************************************************
+class FakeKeyTranslator: public KeyTranslator
+{
+public: // member functions
+   FakeKeyTranslator() = default; ///< Default constructor
+   FakeKeyTranslator(FakeKeyTranslator const&) = delete; ///< Disabled copy constructor
+   FakeKeyTranslator(FakeKeyTranslator&&) = delete; ///< Disabled move constructor
+   ~FakeKeyTranslator() = default; ///< Default destructor
+   FakeKeyTranslator& operator=(FakeKeyTranslator const&) = delete; ///< Disabled assignment operator
+   FakeKeyTranslator& operator=(FakeKeyTranslator&&) = delete; ///< Disabled move assignment operator
+   quint64 keyboardLayout() override; ///< Return the identifier of the keyboard layout of the foreground window
+   void translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey, KeyText& outText) override; ///< Translate a keystroke using fakeToUnicode()
+};
+
+
+//**********************************************************************************************************************
+/// Like the Windows key translator, the translator uses the layout reported by the foreground context service.
+///
+/// \return The identifier of the keyboard layout of the foreground window
+//**********************************************************************************************************************
+quint64 FakeKeyTranslator::keyboardLayout()
+{
+   return ForegroundContextService::instance().keyboardLayout();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The key stroke
+/// \param[in] layout The identifier of the keyboard layout
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+//**********************************************************************************************************************
+void FakeKeyTranslator::translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey, KeyText& outText)
+{
+   outIsDeadKey = (kFakeDeadKey == keyStroke.virtualKey);
+   outText.size = outIsDeadKey ? 0 : fakeToUnicode(keyStroke, layout, outText.chars, KeyText::Capacity);
+}
+
+
+//**********************************************************************************************************************
+/// \brief A key translator based on fakeToUnicode() that performs the allocations the keyboard hook made before it
+/// was made allocation-free
+///
+/// The former hook built the list of the modifier keys for each keystroke, and converted the typed text to a QString.
+//**********************************************************************************************************************
+class AllocatingKeyTranslator: public KeyTranslator
+{
+public: // member functions
+   AllocatingKeyTranslator() = default; ///< Default constructor
+   AllocatingKeyTranslator(AllocatingKeyTranslator const&) = delete; ///< Disabled copy constructor
+   AllocatingKeyTranslator(AllocatingKeyTranslator&&) = delete; ///< Disabled move constructor
+   ~AllocatingKeyTranslator() = default; ///< Default destructor
+   AllocatingKeyTranslator& operator=(AllocatingKeyTranslator const&) = delete; ///< Disabled assignment operator
+   AllocatingKeyTranslator& operator=(AllocatingKeyTranslator&&) = delete; ///< Disabled move assignment operator
+   quint64 keyboardLayout() override; ///< Return the identifier of the keyboard layout of the foreground window
+   void translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey, KeyText& outText) override; ///< Translate a keystroke using fakeToUnicode()
+};
+
+
+//**********************************************************************************************************************
+/// \return The identifier of the keyboard layout of the foreground window
+//**********************************************************************************************************************
+quint64 AllocatingKeyTranslator::keyboardLayout()
+{
+   return ForegroundContextService::instance().keyboardLayout();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The key stroke
+/// \param[in] layout The identifier of the keyboard layout
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+//**********************************************************************************************************************
+void AllocatingKeyTranslator::translateKey(KeyStroke const& keyStroke, quint64 layout, bool& outIsDeadKey,
+   KeyText& outText)
+{
+   KeyStroke stroke = { keyStroke.virtualKey, keyStroke.scanCode, { 0 } };
+   QList<quint32> const keyList = {
+      VirtualKeyShift, VirtualKeyLeftShift, VirtualKeyRightShift, VirtualKeyControl, VirtualKeyLeftControl,
+      VirtualKeyRightControl, VirtualKeyMenu, VirtualKeyLeftMenu, VirtualKeyRightMenu, VirtualKeyRightWin,
+      VirtualKeyLeftWin, VirtualKeyCapital
+   };
+   for (quint32 const key: keyList)
+      stroke.keyboardState[key] = keyStroke.keyboardState[key];
+
+   outIsDeadKey = false;
+   wchar_t textBuffer[KeyText::Capacity];
+   qint32 const size = fakeToUnicode(stroke, layout, textBuffer, KeyText::Capacity);
+   QString const text = size > 0 ? QString::fromWCharArray(textBuffer, size) : QString();
+   outText.size = qMin<qint32>(text.size(), KeyText::Capacity);
+   for (qint32 i = 0; i < outText.size; ++i)
+      outText.chars[i] = wchar_t(text[i].unicode());
+}
+
+
+//**********************************************************************************************************************
+/// \brief An input source delivering simulated key events through the same steps as the keyboard hook
+//**********************************************************************************************************************
+class BenchmarkInputSource: public InputSource
+{
+public: // member functions
+   explicit BenchmarkInputSource(UpKeyTranslator translator); ///< Default constructor
+   BenchmarkInputSource(BenchmarkInputSource const&) = delete; ///< Disabled copy constructor
+   BenchmarkInputSource(BenchmarkInputSource&&) = delete; ///< Disabled move constructor
+   ~BenchmarkInputSource() override = default; ///< Default destructor
+   BenchmarkInputSource& operator=(BenchmarkInputSource const&) = delete; ///< Disabled assignment operator
+   BenchmarkInputSource& operator=(BenchmarkInputSource&&) = delete; ///< Disabled move assignment operator
+   void start(InputSourceListener& listener) override; ///< Start delivering events to a listener
+   void stop() override; ///< Stop delivering events
+   bool setKeyboardEventsEnabled(bool enabled) override; ///< Enable or disable the delivery of keyboard events
+   void translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+      quint64& outKeyboardLayout) override; ///< Retrieve the text produced by a keystroke, and the keyboard layout used
+   void simulateKeyEvent(KeyEvent const& event); ///< Deliver a key event the way the keyboard hook does
+
+private: // data members
+   UpKeyTranslator translator_; ///< The key translator
+   InputSourceListener* listener_ { nullptr }; ///< The listener
+   bool keyboardEventsEnabled_ { true }; ///< Are keyboard events delivered
+};
+
+
+//**********************************************************************************************************************
+/// \param[in] translator The key translator
+//**********************************************************************************************************************
+BenchmarkInputSource::BenchmarkInputSource(UpKeyTranslator translator)
+   : InputSource()
+   , translator_(std::move(translator))
+{
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] listener The listener
+//**********************************************************************************************************************
+void BenchmarkInputSource::start(InputSourceListener& listener)
+{
+   listener_ = &listener;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void BenchmarkInputSource::stop()
+{
+   listener_ = nullptr;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] enabled Should keyboard events be delivered
+/// \return true
+//**********************************************************************************************************************
+bool BenchmarkInputSource::setKeyboardEventsEnabled(bool enabled)
+{
+   keyboardEventsEnabled_ = enabled;
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The keystroke
+/// \param[out] outIsDeadKey Is the key a dead key
+/// \param[out] outText The text resulting of the keystroke
+/// \param[out] outKeyboardLayout The keyboard layout the keystroke was translated with
+//**********************************************************************************************************************
+void BenchmarkInputSource::translateKey(KeyStroke const& keyStroke, bool& outIsDeadKey, KeyText& outText,
+   quint64& outKeyboardLayout)
+{
+   outKeyboardLayout = translator_->keyboardLayout();
+   translator_->translateKey(keyStroke, outKeyboardLayout, outIsDeadKey, outText);
+}
+
+
+//**********************************************************************************************************************
+/// The steps are those of WindowsInputSource::keyboardProcedure(), with fakeGetKeyState() instead of GetKeyState().
+///
+/// \param[in] event The key event
+//**********************************************************************************************************************
+void BenchmarkInputSource::simulateKeyEvent(KeyEvent const& event)
+{
+   if ((!listener_) || (!keyboardEventsEnabled_) || kIgnoredVirtualKeys.contains(event.virtualKey))
+      return;
+   KeyStroke keyStroke = { 0, 0, { 0 } };
+   keyStroke.virtualKey = event.virtualKey;
+   keyStroke.scanCode = event.scanCode;
+   for (quint8 const key: kModifierVirtualKeys)
+      keyStroke.keyboardState[key] = quint8(fakeGetKeyState(key));
+   listener_->onKeyStroke(keyStroke);
+}
+
+
+//**********************************************************************************************************************
+/// \brief An input source listener enqueueing the keystrokes the way the input manager does
+//**********************************************************************************************************************
+class BenchmarkListener: public InputSourceListener
+{
+public: // member functions
+   BenchmarkListener(InputSource& source, KeystrokeQueue& queue); ///< Default constructor
+   BenchmarkListener(BenchmarkListener const&) = delete; ///< Disabled copy constructor
+   BenchmarkListener(BenchmarkListener&&) = delete; ///< Disabled move constructor
+   ~BenchmarkListener() override = default; ///< Default destructor
+   BenchmarkListener& operator=(BenchmarkListener const&) = delete; ///< Disabled assignment operator
+   BenchmarkListener& operator=(BenchmarkListener&&) = delete; ///< Disabled move assignment operator
+   bool onKeyStroke(KeyStroke const& keyStroke) override; ///< Process a keystroke
+   void onMouseClick() override; ///< Process a mouse click
+
+private: // data members
+   InputSource& source_; ///< The input source
+   KeystrokeQueue& queue_; ///< The keystroke queue
+};
+
+
+//**********************************************************************************************************************
+/// \param[in] source The input source
+/// \param[in] queue The keystroke queue
+//**********************************************************************************************************************
+BenchmarkListener::BenchmarkListener(InputSource& source, KeystrokeQueue& queue)
+   : InputSourceListener()
+   , source_(source)
+   , queue_(queue)
+{
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keyStroke The keystroke
+/// \return true, so that the keystroke is passed to the next hook
+//**********************************************************************************************************************
+bool BenchmarkListener::onKeyStroke(KeyStroke const& keyStroke)
+{
+   enqueueKeyStroke(keyStroke, source_, queue_);
+   return true;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void BenchmarkListener::onMouseClick()
+{
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] count The number of events
+/// \param[in] seed The seed of the random number generator
+/// \return A random sequence of key events resembling typing
+//**********************************************************************************************************************
+std::vector<KeyEvent> generateEvents(qint32 count, quint32 seed)
+{
+   std::mt19937 rng(seed);
+   std::uniform_int_distribution<qint32> percent(0, 99);
+   std::uniform_int_distribution<quint32> letter('A', 'Z');
+   std::uniform_int_distribution<quint32> arrow(VirtualKeyLeft, VirtualKeyDown);
+   std::vector<KeyEvent> result;
+   result.reserve(size_t(count));
+   for (qint32 i = 0; i < count; ++i)
+   {
+      qint32 const p = percent(rng);
+      quint32 const vk = (p < 78) ? letter(rng) : (p < 90) ? quint32(VirtualKeySpace) : (p < 93) ? quint32(VirtualKeyBack) :
+         (p < 95) ? quint32(VirtualKeyReturn) : (p < 97) ? arrow(rng) : quint32(VirtualKeyLeftShift);
+      result.push_back({ vk, vk });
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] queue The keystroke queue
+/// \param[in,out] events The events popped from the queue are appended to this vector
+//**********************************************************************************************************************
+void drain(KeystrokeQueue& queue, std::vector<KeystrokeEvent>& events)
+{
+   KeystrokeEvent event;
+   while (queue.pop(event))
+      events.push_back(event);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] events The key events
+/// \param[in] translator The key translator used by the input source
+/// \param[out] outQueuedEvents The events pushed in the keystroke queue
+/// \return The result of the run
+//**********************************************************************************************************************
+RunResult run(std::vector<KeyEvent> const& events, UpKeyTranslator translator,
+   std::vector<KeystrokeEvent>& outQueuedEvents)
+{
+   RunResult result;
+   outQueuedEvents.clear();
+   outQueuedEvents.reserve(events.size()); // reserved before timing, so recording the events does not allocate
+   KeystrokeQueue queue(2 * kDrainInterval);
+   BenchmarkInputSource source(std::move(translator));
+   BenchmarkListener listener(source, queue);
+   source.start(listener);
+   quint64 const allocationsBefore = benchmark::allocationCount();
+   quint64 const translationsBefore = gTranslationCount;
+   benchmark::Stopwatch const stopwatch;
+   for (size_t i = 0; i < events.size(); ++i)
+   {
+      source.simulateKeyEvent(events[i]);
+      if (0 == (i + 1) % kDrainInterval)
+         drain(queue, outQueuedEvents);
+   }
+   drain(queue, outQueuedEvents);
+   result.ns = stopwatch.elapsedNs();
+   result.allocations = benchmark::allocationCount() - allocationsBefore;
+   result.translations = gTranslationCount - translationsBefore;
+   result.queuedEvents = outQueuedEvents.size();
+   source.stop();
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] first The first sequence of keystroke events
+/// \param[in] second The second sequence of keystroke events
+/// \return true if and only if the two sequences are identical
+//**********************************************************************************************************************
+bool sameEvents(std::vector<KeystrokeEvent> const& first, std::vector<KeystrokeEvent> const& second)
+{
+   return std::equal(first.begin(), first.end(), second.begin(), second.end(),
+      [](KeystrokeEvent const& x, KeystrokeEvent const& y) -> bool
+      { return (x.type == y.type) && ((KeystrokeEvent::Character != x.type) || (x.c == y.c)); });
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] virtualKey The virtual key
+/// \param[in] shift Is the shift key down
+/// \param[in] capsLock Is caps lock toggled
+/// \return The keystroke
+//**********************************************************************************************************************
+KeyStroke makeKeyStroke(quint32 virtualKey, bool shift, bool capsLock)
+{
+   KeyStroke result = { virtualKey, virtualKey, { 0 } };
+   result.keyboardState[VirtualKeyShift] = shift ? 0x80 : 0;
+   result.keyboardState[VirtualKeyLeftShift] = shift ? 0x80 : 0;
+   result.keyboardState[VirtualKeyCapital] = capsLock ? 0x01 : 0;
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] translator The memoizing translator
+/// \param[in] reference A translator of the same type as the one decorated by the memoizing translator
+/// \param[in] keyStroke The keystroke
+/// \param[in] layout The keyboard layout
+/// \return true if and only if both translators produce the same translation
+//**********************************************************************************************************************
+bool translationsMatch(MemoizingKeyTranslator& translator, KeyTranslator& reference, KeyStroke const& keyStroke,
+   quint64 layout)
+{
+   bool isDeadKey = false, referenceIsDeadKey = false;
+   KeyText text = { { 0 }, 0 }, referenceText = { { 0 }, 0 };
+   translator.translateKey(keyStroke, layout, isDeadKey, text);
+   reference.translateKey(keyStroke, layout, referenceIsDeadKey, referenceText);
+   return (isDeadKey == referenceIsDeadKey) && (text.size == referenceText.size) &&
+      std::equal(text.chars, text.chars + qBound<qint32>(0, text.size, KeyText::Capacity), referenceText.chars);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] message The description of the failed check
+/// \return false
+//**********************************************************************************************************************
+bool checkFailed(char const* message)
+{
+   std::printf("Key translator check failed: %s\n", message);
+   return false;
+}
+
+
+//**********************************************************************************************************************
+/// \brief Check the behaviour of the memoizing key translator against the translator it decorates
+///
+/// \return true if and only if all the checks passed
+//**********************************************************************************************************************
+bool checkMemoizingTranslator()
+{
+   FakeKeyTranslator reference;
+   MemoizingKeyTranslator translator(std::make_unique<FakeKeyTranslator>());
+   std::vector<KeyStroke> keyStrokes;
+   for (quint32 const virtualKey: { quint32('A'), quint32('Y'), quint32('Z'), quint32('5'), quint32(VirtualKeySpace) })
+      for (qint32 modifiers = 0; modifiers < 4; ++modifiers)
+         keyStrokes.push_back(makeKeyStroke(virtualKey, 0 != (modifiers & 1), 0 != (modifiers & 2)));
+
+   // the first pass fills the cache, the second one is served by it
+   for (qint32 pass = 0; pass < 2; ++pass)
+      for (KeyStroke const& keyStroke: keyStrokes)
+         if (!translationsMatch(translator, reference, keyStroke, kFakeLayout))
+            return checkFailed("a translation differs from the translation of the decorated translator.");
+   if ((translator.missCount() != keyStrokes.size()) || (translator.hitCount() != keyStrokes.size()))
+      return checkFailed("keystrokes with different modifier states do not have distinct cache entries.");
+
+   // a layout change invalidates the cache
+   KeyStroke const y = makeKeyStroke('Y', false, false);
+   quint64 const hitCount = translator.hitCount();
+   if ((!translationsMatch(translator, reference, y, kFakeGermanLayout)) ||
+      (!translationsMatch(translator, reference, y, kFakeLayout)) || (translator.hitCount() != hitCount))
+      return checkFailed("a translation cached for a keyboard layout was reused with another layout.");
+
+   // dead keys and the unknown layout bypass the cache
+   KeyStroke const deadKey = makeKeyStroke(kFakeDeadKey, false, false);
+   KeyStroke const a = makeKeyStroke('A', false, false);
+   quint64 const missCount = translator.missCount();
+   for (qint32 pass = 0; pass < 4; ++pass)
+      if (!translationsMatch(translator, reference, (pass < 2) ? deadKey : a, (pass < 2) ? kFakeLayout : 0))
+         return checkFailed("a dead key or a keystroke with an unknown layout was not translated correctly.");
+   if ((translator.hitCount() != hitCount) || (translator.missCount() != missCount + 4))
+      return checkFailed("a dead key or a keystroke with an unknown layout was cached.");
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \brief Check that translations follow the keyboard layout of the foreground window when it changes
+///
+/// The foreground context service plays a script of foreground windows with different layouts. The keyboard layout
+/// must be queried once per keystroke, and the foreground context, whose lookup inspects the foreground process, must
+/// not be queried at all.
+///
+/// \param[in] service The foreground context service used by the application
+/// \return true if and only if all the checks passed
+//**********************************************************************************************************************
+bool checkForegroundLayoutSwitches(FakeForegroundContextService& service)
+{
+   ForegroundContext notepad, word;
+   notepad.window = 1;
+   notepad.executableFileName = "notepad.exe";
+   word.window = 2;
+   word.executableFileName = "winword.exe";
+   service.setScript({ { notepad, kFakeLayout }, { word, kFakeGermanLayout }, { notepad, kFakeLayout } });
+   QChar const expected[] = { QChar('y'), QChar('z'), QChar('y') }; // the German layout swaps Y and Z
+
+   MemoizingKeyTranslator translator(std::make_unique<FakeKeyTranslator>());
+   KeyStroke const y = makeKeyStroke('Y', false, false);
+   qint32 const switchCount = service.switchCount();
+   qint32 const layoutQueryCount = service.keyboardLayoutQueryCount();
+   qint32 const contextQueryCount = service.contextQueryCount();
+   for (QChar const c: expected)
+   {
+      if (!service.advance())
+         return checkFailed("the script of foreground contexts ended early.");
+      for (qint32 pass = 0; pass < 2; ++pass) // the second translation is served by the cache
+      {
+         bool isDeadKey = false;
+         KeyText text = { { 0 }, 0 };
+         translator.translateKey(y, translator.keyboardLayout(), isDeadKey, text);
+         if ((1 != text.size) || (QChar(ushort(text.chars[0])) != c))
+            return checkFailed("a translation did not follow the keyboard layout of the foreground window.");
+      }
+   }
+   qint32 const translationCount = 2 * qint32(sizeof(expected) / sizeof(expected[0]));
+   if ((service.advance()) || (service.switchCount() - switchCount != translationCount / 2))
+      return checkFailed("the script of foreground contexts was not played as expected.");
+   if (translator.hitCount() != quint64(translationCount / 2))
+      return checkFailed("the cache was not used between two switches of the foreground window.");
+   if (service.keyboardLayoutQueryCount() - layoutQueryCount != translationCount)
+      return checkFailed("the keyboard layout was not queried once per keystroke.");
+   if (service.contextQueryCount() != contextQueryCount)
+      return checkFailed("translating keystrokes queried the foreground context.");
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] name The name of the hook path
+/// \param[in] eventCount The number of events
+/// \param[in] result The result of the run
+//**********************************************************************************************************************
+void printResult(char const* name, size_t eventCount, RunResult const& result)
+{
+   double const count = double(qMax<size_t>(eventCount, 1));
+   std::printf("%-14s %10.1f %14.4f %14.4f %12llu\n", name, double(result.ns) / count,
+      double(result.allocations) / count, double(result.translations) / count,
+      static_cast<unsigned long long>(result.queuedEvents));
+   std::fflush(stdout);
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \return The exit code of the application
+//**********************************************************************************************************************
+int main(int argc, char* argv[])
+{
+   qint32 eventCount = 5000000;
+   if (argc > 1)
+   {
+      bool ok = false;
+      eventCount = QString::fromLocal8Bit(argv[1]).toInt(&ok);
+      if ((!ok) || (eventCount <= 0) || (argc > 2))
+      {
+         std::printf("Usage: HookBenchmark [event count (default: 5000000)]\n");
+         return 1;
+      }
+   }
+
+   std::unique_ptr<FakeForegroundContextService> service = std::make_unique<FakeForegroundContextService>();
+   FakeForegroundContextService& foregroundService = *service;
+   ForegroundContextService::setInstance(std::move(service));
+   if ((!checkMemoizingTranslator()) || (!checkForegroundLayoutSwitches(foregroundService)))
+      return 1;
+   std::printf("Key translator checks passed.\n");
+   foregroundService.setContext(ForegroundContext(), kFakeLayout);
+   std::vector<KeyEvent> const events = generateEvents(eventCount, 42);
+   std::printf("Events: %d. Allocation count %s malloc.\n\n", eventCount,
+      benchmark::allocationCountIncludesMalloc() ? "includes" : "does not include");
+   std::printf("%-14s %10s %14s %14s %12s\n", "path", "ns/event", "allocs/event", "xlats/event", "queued");
+   std::vector<KeystrokeEvent> referenceEvents, queuedEvents;
+   printResult("allocating", events.size(), run(events, std::make_unique<AllocatingKeyTranslator>(),
+      referenceEvents));
+   printResult("table-driven", events.size(), run(events, std::make_unique<FakeKeyTranslator>(), queuedEvents));
+   if (!sameEvents(referenceEvents, queuedEvents))
+   {
+      std::printf("The table-driven path did not enqueue the same events as the allocating path.\n");
+      return 1;
+   }
+   printResult("memoized", events.size(), run(events, std::make_unique<MemoizingKeyTranslator>(
+      std::make_unique<FakeKeyTranslator>()), queuedEvents));
+   if (!sameEvents(referenceEvents, queuedEvents))
+   {
+      std::printf("The memoized path did not enqueue the same events as the allocating path.\n");
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,453 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Benchmark of the combo keyword matching performed on every keystroke
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "BenchmarkUtils.h"
+#include "Combo/KeywordIndex.h"
+#include "Combo/KeywordSnapshot.h"
+#include "Combo/KeywordMatcher.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+namespace {
+
+
+//**********************************************************************************************************************
+/// \brief A keystroke, as seen by the combo manager
+//**********************************************************************************************************************
+struct Keystroke
+{
+   enum EType {
+      Character = 0, ///< A character was typed
+      Backspace = 1, ///< The backspace key was pressed
+      Breaker = 2, ///< A combo breaker was typed
+   };
+   EType type { Character }; ///< The type of keystroke
+   QChar c; ///< The character, for keystrokes of type Character
+}; ///< A keystroke
+
+
+typedef std::vector<Keystroke> VecKeystroke; ///< Type definition for vector of keystrokes
+
+
+//**********************************************************************************************************************
+/// \brief The options of the benchmark
+//**********************************************************************************************************************
+struct Options
+{
+   std::vector<qint32> sizes { 1000, 10000, 100000, 1000000 }; ///< The sizes of the combo lists to generate
+   qint32 keystrokeCount { 2000000 }; ///< The number of keystrokes to generate
+   double strictRatio { 0.8 }; ///< The proportion of strict matching combos
+   double comboRatio { 0.02 }; ///< The proportion of generated words that are combo keywords
+   quint32 seed { 42 }; ///< The seed of the random number generator
+   QString tracePath; ///< The path of a file containing the typing to replay, if any
+   bool runIndex { true }; ///< Should the keyword index matching mode be benchmarked
+   bool runStreaming { true }; ///< Should the streaming matching mode be benchmarked
+}; ///< The options of the benchmark
+
+
+//**********************************************************************************************************************
+/// \brief The result of a benchmark run
+//**********************************************************************************************************************
+struct RunResult
+{
+   qint64 setupNs { 0 }; ///< The time spent preparing the matcher before the first keystroke
+   qint64 replayNs { 0 }; ///< The time spent replaying the keystrokes
+   quint64 allocations { 0 }; ///< The number of allocations performed while replaying the keystrokes
+   qint64 matchCount { 0 }; ///< The number of matches found
+}; ///< The result of a benchmark run
+
+
+char const* kPrefixes[] = { "", "", "", ";", "::", "#", "!", "." }; ///< Prefixes commonly used in combo keywords
+
+
+//**********************************************************************************************************************
+/// \param[in] rng The random number generator
+/// \param[in] minLength The minimum length of the word
+/// \param[in] maxLength The maximum length of the word
+/// \return A random lowercase word
+//**********************************************************************************************************************
+std::string randomWord(std::mt19937& rng, qint32 minLength, qint32 maxLength)
+{
+   qint32 const length = std::uniform_int_distribution<qint32>(minLength, maxLength)(rng);
+   std::uniform_int_distribution<qint32> letter(0, 25);
+   std::string result;
+   for (qint32 i = 0; i < length; ++i)
+      result.push_back(char('a' + letter(rng)));
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] size The number of keywords to generate
+/// \param[in] strictRatio The proportion of strict matching keywords
+/// \param[in] rng The random number generator
+/// \param[out] outIndex The keyword index, which is cleared before the keywords are inserted
+/// \param[out] outKeywords The generated keywords, by ID
+/// \return The time spent inserting the keywords in the index
+//**********************************************************************************************************************
+qint64 generateComboList(qint32 size, double strictRatio, std::mt19937& rng, KeywordIndex& outIndex,
+   std::vector<std::string>& outKeywords)
+{
+   std::uniform_int_distribution<qint32> prefix(0, qint32(sizeof(kPrefixes) / sizeof(kPrefixes[0])) - 1);
+   std::bernoulli_distribution strict(strictRatio);
+   std::unordered_set<std::string> used;
+   std::vector<std::pair<std::string, bool>> keywords;
+   keywords.reserve(size_t(size));
+   while (qint32(keywords.size()) < size)
+   {
+      std::string const keyword = kPrefixes[prefix(rng)] + randomWord(rng, 3, 10);
+      if (used.insert(keyword).second)
+         keywords.emplace_back(keyword, !strict(rng));
+   }
+
+   outIndex.clear();
+   outKeywords.clear();
+   benchmark::Stopwatch const stopwatch;
+   for (std::pair<std::string, bool> const& keyword: keywords)
+   {
+      qint32 const id = outIndex.insert(QString::fromLatin1(keyword.first.c_str()), keyword.second);
+      if (qint32(outKeywords.size()) <= id)
+         outKeywords.resize(size_t(id) + 1);
+      outKeywords[size_t(id)] = keyword.first;
+   }
+   return stopwatch.elapsedNs();
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] keywords The keywords of the combo list
+/// \param[in] options The options of the benchmark
+/// \param[in] rng The random number generator
+/// \return The generated keystrokes
+//**********************************************************************************************************************
+VecKeystroke generateTyping(std::vector<std::string> const& keywords, Options const& options, std::mt19937& rng)
+{
+   VecKeystroke result;
+   result.reserve(size_t(options.keystrokeCount) + 64);
+   std::bernoulli_distribution isCombo(options.comboRatio);
+   std::bernoulli_distribution isTypo(0.03);
+   std::uniform_int_distribution<size_t> keywordIndex(0, keywords.empty() ? 0 : keywords.size() - 1);
+   std::uniform_int_distribution<qint32> letter(0, 25);
+   while (qint32(result.size()) < options.keystrokeCount)
+   {
+      std::string const word = (isCombo(rng) && !keywords.empty()) ? keywords[keywordIndex(rng)] :
+         randomWord(rng, 1, 10);
+      for (char const c: word)
+      {
+         if (isTypo(rng))
+         {
+            Keystroke typo;
+            typo.c = QChar(char('a' + letter(rng)));
+            result.push_back(typo);
+            Keystroke backspace;
+            backspace.type = Keystroke::Backspace;
+            result.push_back(backspace);
+         }
+         Keystroke keystroke;
+         keystroke.c = QChar(c);
+         result.push_back(keystroke);
+      }
+      Keystroke breaker;
+      breaker.type = Keystroke::Breaker;
+      result.push_back(breaker);
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// In the trace file, which is encoded in UTF-8, white spaces are combo breakers and the backspace control character
+/// (U+0008) is a backspace. Any other character is a typed character.
+///
+/// \param[in] path The path of the trace file
+/// \param[out] outKeystrokes The keystrokes
+/// \return true if and only if the file was successfully read
+//**********************************************************************************************************************
+bool loadTrace(QString const& path, VecKeystroke& outKeystrokes)
+{
+   std::ifstream stream(path.toLocal8Bit().constData(), std::ios::binary);
+   if (!stream)
+      return false;
+   std::string const data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+   QString const text = QString::fromUtf8(data.c_str(), qint32(data.size()));
+   outKeystrokes.clear();
+   outKeystrokes.reserve(size_t(text.size()));
+   for (QChar const c: text)
+   {
+      Keystroke keystroke;
+      if (QChar(0x08) == c)
+         keystroke.type = Keystroke::Backspace;
+      else if (c.isSpace())
+         keystroke.type = Keystroke::Breaker;
+      else
+         keystroke.c = c;
+      outKeystrokes.push_back(keystroke);
+   }
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// The keystrokes are processed the way the combo manager processes them when automatic substitution is enabled:
+/// the matches are looked up after every character that can end a keyword, and the typed text is reset after a 
+/// match.
+///
+/// \param[in] snapshot The keyword snapshot
+/// \param[in] mode The matching mode
+/// \param[in] keystrokes The keystrokes
+/// \return The result of the run
+//**********************************************************************************************************************
+RunResult replay(KeywordSnapshot const& snapshot, KeywordMatcher::EMatchingMode mode, VecKeystroke const& keystrokes)
+{
+   RunResult result;
+   KeywordMatcher matcher(snapshot);
+   matcher.setMatchingMode(mode);
+   QVector<qint32> ids;
+   ids.reserve(64);
+
+   // the first keystroke triggers the construction of the automaton, we measure it separately
+   benchmark::Stopwatch stopwatch;
+   matcher.appendCharacter(QChar('a'));
+   matcher.findMatches(ids);
+   matcher.reset();
+   ids.clear();
+   result.setupNs = stopwatch.elapsedNs();
+
+   quint64 const allocationsBefore = benchmark::allocationCount();
+   stopwatch.restart();
+   for (Keystroke const& keystroke: keystrokes)
+   {
+      switch (keystroke.type)
+      {
+      case Keystroke::Character:
+         matcher.appendCharacter(keystroke.c);
+         if (!snapshot.canEndKeyword(keystroke.c))
+            break;
+         matcher.findMatches(ids);
+         if (!ids.isEmpty())
+         {
+            ++result.matchCount;
+            ids.clear();
+            matcher.reset();
+         }
+         break;
+      case Keystroke::Backspace:
+         matcher.removeLastCharacter();
+         break;
+      case Keystroke::Breaker:
+      default:
+         matcher.reset();
+         break;
+      }
+   }
+   result.replayNs = stopwatch.elapsedNs();
+   result.allocations = benchmark::allocationCount() - allocationsBefore;
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// The typed text buffer of the matcher only keeps the end of a long run of characters. When backspaces erase the
+/// whole run, a strict matching keyword typed afterwards must still match.
+///
+/// \return true if and only if a strict keyword matches after a run of characters longer than the typed text buffer
+/// has been erased, in every matching mode
+//**********************************************************************************************************************
+bool checkBackspaceAfterTruncation()
+{
+   KeywordIndex index;
+   index.insert(QString::fromLatin1("abc"), false);
+   KeywordSnapshot snapshot;
+   snapshot.build(index);
+
+   VecKeystroke keystrokes;
+   qint32 const runLength = 4 * snapshot.maxKeywordLength(); // longer than the typed text buffer
+   Keystroke keystroke;
+   keystroke.c = QChar('x');
+   keystrokes.insert(keystrokes.end(), size_t(runLength), keystroke);
+   keystroke.type = Keystroke::Backspace;
+   keystrokes.insert(keystrokes.end(), size_t(runLength), keystroke);
+   keystroke.type = Keystroke::Character;
+   for (char const c: std::string("abc"))
+   {
+      keystroke.c = QChar(c);
+      keystrokes.push_back(keystroke);
+   }
+
+   for (KeywordMatcher::EMatchingMode const mode: { KeywordMatcher::KeywordIndexMatching,
+      KeywordMatcher::StreamingMatching })
+      if (1 != replay(snapshot, mode, keystrokes).matchCount)
+         return false;
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] str The string
+/// \param[out] outSizes The list of sizes
+/// \return true if and only if the string is a valid comma-separated list of positive integers
+//**********************************************************************************************************************
+bool parseSizes(QString const& str, std::vector<qint32>& outSizes)
+{
+   outSizes.clear();
+   for (QString const& item: str.split(','))
+   {
+      bool ok = false;
+      qint32 const size = item.trimmed().toInt(&ok);
+      if ((!ok) || (size <= 0))
+         return false;
+      outSizes.push_back(size);
+   }
+   return !outSizes.empty();
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void printUsage()
+{
+   std::printf(
+      "Usage: MatchingBenchmark [options]\n"
+      "  --sizes <n1,n2,...>     Sizes of the generated combo lists (default: 1000,10000,100000,1000000)\n"
+      "  --keystrokes <n>        Number of generated keystrokes (default: 2000000)\n"
+      "  --strict-ratio <r>      Proportion of strict matching combos (default: 0.8)\n"
+      "  --combo-ratio <r>       Proportion of typed words that are combo keywords (default: 0.02)\n"
+      "  --seed <n>              Seed of the random number generator (default: 42)\n"
+      "  --trace <path>          Replay the typing recorded in a UTF-8 text file instead of generating it\n"
+      "  --mode <index|streaming|all>   Matching modes to benchmark (default: all)\n");
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \param[out] outOptions The options
+/// \return true if and only if the command line is valid
+//**********************************************************************************************************************
+bool parseCommandLine(int argc, char* argv[], Options& outOptions)
+{
+   for (qint32 i = 1; i < argc; ++i)
+   {
+      QString const arg = QString::fromLocal8Bit(argv[i]);
+      if (("--help" == arg) || ("-h" == arg))
+         return false;
+      if (i + 1 >= argc)
+         return false;
+      QString const value = QString::fromLocal8Bit(argv[++i]);
+      bool ok = true;
+      if ("--sizes" == arg)
+         ok = parseSizes(value, outOptions.sizes);
+      else if ("--keystrokes" == arg)
+         outOptions.keystrokeCount = value.toInt(&ok);
+      else if ("--strict-ratio" == arg)
+         outOptions.strictRatio = value.toDouble(&ok);
+      else if ("--combo-ratio" == arg)
+         outOptions.comboRatio = value.toDouble(&ok);
+      else if ("--seed" == arg)
+         outOptions.seed = value.toUInt(&ok);
+      else if ("--trace" == arg)
+         outOptions.tracePath = value;
+      else if ("--mode" == arg)
+      {
+         outOptions.runIndex = ("index" == value) || ("all" == value);
+         outOptions.runStreaming = ("streaming" == value) || ("all" == value);
+         ok = outOptions.runIndex || outOptions.runStreaming;
+      }
+      else
+         ok = false;
+      if (!ok)
+         return false;
+   }
+   return (outOptions.keystrokeCount > 0) && (outOptions.strictRatio >= 0.0) && (outOptions.strictRatio <= 1.0) &&
+      (outOptions.comboRatio >= 0.0) && (outOptions.comboRatio <= 1.0);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] combos The number of combos
+/// \param[in] modeName The name of the matching mode
+/// \param[in] keystrokes The number of keystrokes
+/// \param[in] result The result of the run
+//**********************************************************************************************************************
+void printResult(qint32 combos, char const* modeName, size_t keystrokes, RunResult const& result)
+{
+   double const count = double(qMax<size_t>(keystrokes, 1));
+   std::printf("%9d  %-10s %10.1f %12.4f %10lld %11.2f %12s\n", combos, modeName, double(result.replayNs) / count,
+      double(result.allocations) / count, static_cast<long long>(result.matchCount), double(result.setupNs) / 1e6,
+      benchmark::formatBytes(benchmark::peakResidentSetSize()).toUtf8().constData());
+   std::fflush(stdout);
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \return The exit code of the application
+//**********************************************************************************************************************
+int main(int argc, char* argv[])
+{
+   Options options;
+   if (!parseCommandLine(argc, argv, options))
+   {
+      printUsage();
+      return 1;
+   }
+
+   VecKeystroke traceKeystrokes;
+   if ((!options.tracePath.isEmpty()) && (!loadTrace(options.tracePath, traceKeystrokes)))
+   {
+      std::fprintf(stderr, "Could not read the trace file.\n");
+      return 1;
+   }
+   if (!checkBackspaceAfterTruncation())
+   {
+      std::fprintf(stderr, "A strict keyword did not match after backspacing over a truncated typed text.\n");
+      return 1;
+   }
+
+   std::printf("Strict ratio: %.2f. Allocation count %s malloc.\n\n", options.strictRatio,
+      benchmark::allocationCountIncludesMalloc() ? "includes" : "does not include");
+   std::printf("%9s  %-10s %10s %12s %10s %11s %12s\n", "combos", "mode", "ns/key", "allocs/key", "matches",
+      "setup (ms)", "peak RSS");
+   std::mt19937 rng(options.seed);
+   KeywordIndex index;
+   KeywordSnapshot snapshot;
+   std::vector<std::string> keywords;
+   for (qint32 const size: options.sizes)
+   {
+      qint64 const buildNs = generateComboList(size, options.strictRatio, rng, index, keywords);
+      VecKeystroke const keystrokes = options.tracePath.isEmpty() ? generateTyping(keywords, options, rng) :
+         traceKeystrokes;
+      std::printf("%9d  %-10s %10s %12s %10s %11.2f %12s\n", size, "(index)", "", "", "", double(buildNs) / 1e6,
+         benchmark::formatBytes(benchmark::peakResidentSetSize()).toUtf8().constData());
+      benchmark::Stopwatch const stopwatch;
+      snapshot.build(index);
+      qint64 const snapshotNs = stopwatch.elapsedNs();
+      std::printf("%9d  %-10s %10s %12s %10s %11.2f %12s\n", size, "(snapshot)", "", "", "",
+         double(snapshotNs) / 1e6, benchmark::formatBytes(benchmark::peakResidentSetSize()).toUtf8().constData());
+      if (options.runIndex)
+         printResult(size, "index", keystrokes.size(), replay(snapshot, KeywordMatcher::KeywordIndexMatching,
+            keystrokes));
+      if (options.runStreaming)
+         printResult(size, "streaming", keystrokes.size(), replay(snapshot, KeywordMatcher::StreamingMatching,
+            keystrokes));
+   }
+   return 0;
+}
@@ -0,0 +1,265 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Headless benchmark and stress test of the keystroke processing pipeline, driven by a replay input source
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "BenchmarkUtils.h"
+#include "PipelineListener.h"
+#include "ReplayInputSource.h"
+#include "Combo/KeywordIndex.h"
+#include "Combo/KeywordSnapshot.h"
+#include "Combo/MatchingWorker.h"
+#include <atomic>
+#include <cstdio>
+#include <random>
+
+
+namespace {
+
+
+//**********************************************************************************************************************
+/// \brief The options of the benchmark
+//**********************************************************************************************************************
+struct Options
+{
+   qint32 comboCount { 10000 }; ///< The number of combos to generate
+   qint32 keystrokeCount { 1000000 }; ///< The number of keystrokes to generate
+   double rate { 0.0 }; ///< The number of keystrokes replayed per second, or 0 to replay as fast as possible
+   double comboRatio { 0.02 }; ///< The proportion of generated words that are combo keywords
+   quint32 seed { 42 }; ///< The seed of the random number generator
+   QString tracePath; ///< The path of a file containing the typing to replay, if any
+}; ///< The options of the benchmark
+
+
+QString const kSentinelKeyword = "qqsentinelqq"; ///< The keyword typed at the end of the replay, whose match tells all keystrokes were processed
+qint32 const kTimeoutMs = 10000; ///< The time allowed for the matching thread to catch up after the replay ended
+
+
+//**********************************************************************************************************************
+/// \param[in] rng The random number generator
+/// \param[in] minLength The minimum length of the word
+/// \param[in] maxLength The maximum length of the word
+/// \return A random lowercase word
+//**********************************************************************************************************************
+QString randomWord(std::mt19937& rng, qint32 minLength, qint32 maxLength)
+{
+   qint32 const length = std::uniform_int_distribution<qint32>(minLength, maxLength)(rng);
+   std::uniform_int_distribution<qint32> letter(0, 25);
+   QString result;
+   for (qint32 i = 0; i < length; ++i)
+      result.append(QChar('a' + letter(rng)));
+   return result;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] options The options
+/// \param[in] rng The random number generator
+/// \param[out] outIndex The keyword index
+/// \param[out] outKeywords The generated keywords
+//**********************************************************************************************************************
+void generateComboList(Options const& options, std::mt19937& rng, KeywordIndex& outIndex,
+   QStringList& outKeywords)
+{
+   std::bernoulli_distribution loose(0.2);
+   QSet<QString> used;
+   outIndex.clear();
+   outKeywords.clear();
+   while (outKeywords.size() < options.comboCount)
+   {
+      QString const keyword = randomWord(rng, 3, 10);
+      if (used.contains(keyword))
+         continue;
+      used.insert(keyword);
+      outIndex.insert(keyword, loose(rng));
+      outKeywords.append(keyword);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// Words are separated by spaces, and about 3% of the characters are typos immediately corrected using backspace.
+///
+/// \param[in] keywords The keywords of the combo list
+/// \param[in] options The options
+/// \param[in] rng The random number generator
+/// \return The typed text
+//**********************************************************************************************************************
+QString generateTyping(QStringList const& keywords, Options const& options, std::mt19937& rng)
+{
+   QString result;
+   result.reserve(options.keystrokeCount + 64);
+   std::bernoulli_distribution isCombo(options.comboRatio);
+   std::bernoulli_distribution isTypo(0.03);
+   std::uniform_int_distribution<qint32> keywordIndex(0, qMax(0, keywords.size() - 1));
+   std::uniform_int_distribution<qint32> letter(0, 25);
+   while (result.size() < options.keystrokeCount)
+   {
+      QString const word = (isCombo(rng) && !keywords.isEmpty()) ? keywords[keywordIndex(rng)] :
+         randomWord(rng, 1, 10);
+      for (QChar const c: word)
+      {
+         if (isTypo(rng))
+            result.append(QChar('a' + letter(rng))).append(QChar('\b'));
+         result.append(c);
+      }
+      result.append(QChar(' '));
+   }
+   return result;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void printUsage()
+{
+   std::printf(
+      "Usage: ReplayBenchmark [options]\n"
+      "  --combos <n>            Number of generated combos (default: 10000)\n"
+      "  --keystrokes <n>        Number of generated keystrokes (default: 1000000)\n"
+      "  --rate <r>              Keystrokes replayed per second, 0 for as fast as possible (default: 0)\n"
+      "  --combo-ratio <r>       Proportion of typed words that are combo keywords (default: 0.02)\n"
+      "  --seed <n>              Seed of the random number generator (default: 42)\n"
+      "  --trace <path>          Replay the typing recorded in a UTF-8 text file instead of generating it\n");
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \param[out] outOptions The options
+/// \return true if and only if the command line is valid
+//**********************************************************************************************************************
+bool parseCommandLine(int argc, char* argv[], Options& outOptions)
+{
+   for (qint32 i = 1; i < argc; ++i)
+   {
+      QString const arg = QString::fromLocal8Bit(argv[i]);
+      if (("--help" == arg) || ("-h" == arg) || (i + 1 >= argc))
+         return false;
+      QString const value = QString::fromLocal8Bit(argv[++i]);
+      bool ok = true;
+      if ("--combos" == arg)
+         outOptions.comboCount = value.toInt(&ok);
+      else if ("--keystrokes" == arg)
+         outOptions.keystrokeCount = value.toInt(&ok);
+      else if ("--rate" == arg)
+         outOptions.rate = value.toDouble(&ok);
+      else if ("--combo-ratio" == arg)
+         outOptions.comboRatio = value.toDouble(&ok);
+      else if ("--seed" == arg)
+         outOptions.seed = value.toUInt(&ok);
+      else if ("--trace" == arg)
+         outOptions.tracePath = value;
+      else
+         ok = false;
+      if (!ok)
+         return false;
+   }
+   return (outOptions.comboCount >= 0) && (outOptions.keystrokeCount > 0) && (outOptions.rate >= 0.0) &&
+      (outOptions.comboRatio >= 0.0) && (outOptions.comboRatio <= 1.0);
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// The keystrokes are replayed on the main thread, processed the way the input manager processes them, and matched
+/// on a matching thread, as in the application. A sentinel keyword is typed at the end of the replay, and the time
+/// is measured until it is matched, which guarantees every keystroke went through the whole pipeline.
+///
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \return The exit code of the application
+//**********************************************************************************************************************
+int main(int argc, char* argv[])
+{
+   QCoreApplication app(argc, argv);
+   Options options;
+   if (!parseCommandLine(argc, argv, options))
+   {
+      printUsage();
+      return 1;
+   }
+
+   std::mt19937 rng(options.seed);
+   KeywordIndex index;
+   QStringList keywords;
+   generateComboList(options, rng, index, keywords);
+   qint32 const sentinelId = index.insert(kSentinelKeyword, false);
+   QString typing;
+   if (options.tracePath.isEmpty())
+      typing = generateTyping(keywords, options, rng);
+   else
+   {
+      QFile file(options.tracePath);
+      if (!file.open(QIODevice::ReadOnly))
+      {
+         std::fprintf(stderr, "Could not read the trace file.\n");
+         return 1;
+      }
+      typing = QString::fromUtf8(file.readAll());
+   }
+   typing += QString(" %1 ").arg(kSentinelKeyword);
+
+   KeystrokeQueue queue;
+   MatchingWorker worker(queue);
+   KeywordSnapshot snapshot;
+   snapshot.build(index);
+   worker.setKeywordSnapshot(std::move(snapshot));
+   worker.setSettings(MatchingWorker::Settings());
+   QThread matchingThread;
+   worker.moveToThread(&matchingThread);
+   QObject::connect(&matchingThread, &QThread::started, &worker, &MatchingWorker::run);
+
+   ReplayInputSource source;
+   source.setEvents(ReplayInputSource::eventsFromText(typing));
+   source.setRate(options.rate);
+   benchmark::PipelineListener listener(source, queue);
+
+   std::atomic<qint64> matchCount { 0 };
+   std::atomic<qint64> elapsedNs { -1 };
+   benchmark::Stopwatch stopwatch;
+   QObject::connect(&worker, &MatchingWorker::comboMatched, [&](QVector<qint32> const& ids, QStringList const&,
+      QVector<qint32> const&, quint64)
+   {
+      ++matchCount;
+      if (ids.contains(sentinelId))
+      {
+         elapsedNs = stopwatch.elapsedNs();
+         QMetaObject::invokeMethod(&app, "quit", Qt::QueuedConnection);
+      }
+   }); // the connection is direct: the lambda runs on the matching thread
+   QObject::connect(&source, &ReplayInputSource::finished, [&]() { QTimer::singleShot(kTimeoutMs, &app,
+      &QCoreApplication::quit); });
+
+   matchingThread.start();
+   stopwatch.restart();
+   source.start(listener);
+   app.exec();
+   source.stop();
+   worker.stop();
+   matchingThread.quit();
+   matchingThread.wait();
+
+   std::printf("Combos: %d. Keystrokes: %d. Target rate: %s.\n", options.comboCount, source.eventCount(),
+      options.rate > 0.0 ? QString("%1 keys/s").arg(options.rate).toUtf8().constData() : "unthrottled");
+   if (elapsedNs < 0)
+   {
+      std::printf("The pipeline did not process every keystroke (%d of %d replayed). Keystrokes were probably "
+         "dropped because the keystroke queue was full.\n", source.replayedEventCount(), source.eventCount());
+      return 1;
+   }
+   double const seconds = double(elapsedNs) / 1e9;
+   std::printf("Elapsed: %.3f s. Throughput: %.0f keys/s (%.1f ns/key). Matches: %lld.\n", seconds,
+      double(source.eventCount()) / qMax(seconds, 1e-9), double(elapsedNs) / double(qMax(source.eventCount(), 1)),
+      static_cast<long long>(matchCount - 1));
+   return 0;
+}
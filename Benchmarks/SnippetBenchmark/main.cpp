@@ -0,0 +1,355 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Benchmark of the evaluation of snippets
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "BenchmarkUtils.h"
+#include "Combo/SnippetTemplate.h"
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+
+//**********************************************************************************************************************
+/// \brief The options of the benchmark
+//**********************************************************************************************************************
+struct Options
+{
+   std::vector<qint32> sizes { 100, 1000, 10000, 100000 }; ///< The sizes of the generated snippets, in characters
+   qint32 variableSpacing { 100 }; ///< The average number of characters between two variables
+   qint32 minTimeMs { 200 }; ///< The minimum time spent measuring each evaluation path
+   quint32 seed { 42 }; ///< The seed of the random number generator
+   bool runPlainText { true }; ///< Should plain text snippets be benchmarked
+   bool runHtml { true }; ///< Should HTML snippets be benchmarked
+}; ///< The options of the benchmark
+
+
+char const* kVariables[] = { "#{date}", "#{time}", "#{input:Name}", "#{combo:sig}", "#{clipboard}",
+   "#{envVar:HOME}" }; ///< The variables inserted in the generated snippets
+qint32 const kMinIterations = 3; ///< The minimum number of evaluations for each measure
+
+
+//**********************************************************************************************************************
+/// \param[in] variable The variable
+/// \param[out] outIsHtml Is the value in HTML format
+/// \param[out] outCancelled Was the evaluation cancelled
+/// \return The value of the variable
+//**********************************************************************************************************************
+QString evaluateVariable(SnippetTemplate::Node const& variable, bool& outIsHtml, bool& outCancelled)
+{
+   outIsHtml = false;
+   outCancelled = false;
+   return QString("<value of %1>").arg(variable.text);
+}
+
+
+//**********************************************************************************************************************
+/// The snippet is made of random words and lines, with variables at random intervals and a cursor marker in the
+/// middle.
+///
+/// \param[in] size The size of the snippet, in characters
+/// \param[in] variableSpacing The average number of characters between two variables
+/// \param[in] rng The random number generator
+/// \param[out] outVariableCount The number of variables in the snippet
+/// \return The snippet
+//**********************************************************************************************************************
+QString generateSnippet(qint32 size, qint32 variableSpacing, std::mt19937& rng, qint32& outVariableCount)
+{
+   std::uniform_int_distribution<qint32> wordLength(1, 10);
+   std::uniform_int_distribution<qint32> letter(0, 25);
+   std::uniform_int_distribution<qint32> variable(0, qint32(sizeof(kVariables) / sizeof(kVariables[0])) - 1);
+   std::bernoulli_distribution isVariable(6.0 / double(qMax(variableSpacing, 6)));
+   std::bernoulli_distribution isNewLine(0.1);
+   QString result;
+   result.reserve(size + 16);
+   outVariableCount = 0;
+   bool cursorInserted = false;
+   while (result.size() < size)
+   {
+      if ((!cursorInserted) && (result.size() >= size / 2))
+      {
+         result += "#{cursor}";
+         cursorInserted = true;
+      }
+      else if (isVariable(rng))
+      {
+         result += kVariables[variable(rng)];
+         ++outVariableCount;
+      }
+      else
+      {
+         qint32 const length = wordLength(rng);
+         for (qint32 i = 0; i < length; ++i)
+            result.append(QChar('a' + letter(rng)));
+      }
+      result.append(isNewLine(rng) ? '\n' : ' ');
+   }
+   return result.left(size);
+}
+
+
+//**********************************************************************************************************************
+/// Each line of the plain text snippet becomes a paragraph, and some of its words are formatted.
+///
+/// \param[in] snippet The plain text snippet
+/// \param[in] rng The random number generator
+/// \return The HTML snippet
+//**********************************************************************************************************************
+QString htmlSnippet(QString const& snippet, std::mt19937& rng)
+{
+   std::uniform_int_distribution<qint32> format(0, 9);
+   QString result = "<html><body>";
+   for (QString const& line: snippet.split('\n'))
+   {
+      result += "<p>";
+      QStringList words = line.split(' ');
+      for (QString& word: words)
+      {
+         switch (format(rng))
+         {
+         case 0: word = QString("<b>%1</b>").arg(word.toHtmlEscaped()); break;
+         case 1: word = QString("<span style=\"color:#c00000;\">%1</span>").arg(word.toHtmlEscaped()); break;
+         default: word = word.toHtmlEscaped(); break;
+         }
+      }
+      result += words.join(' ') + "</p>";
+   }
+   return result + "</body></html>";
+}
+
+
+//**********************************************************************************************************************
+/// \brief Evaluate a snippet through a text document, the way snippets were evaluated before snippet templates were
+/// introduced
+///
+/// \param[in] snippet The snippet
+/// \param[in] isHtml Is the snippet in HTML format
+/// \param[out] outCursorOffset The position of the cursor in the plain text of the result
+/// \return The result of the evaluation
+//**********************************************************************************************************************
+QString evaluateWithTextDocument(QString const& snippet, bool isHtml, qint32& outCursorOffset)
+{
+   QTextDocument remainingText;
+   if (isHtml)
+      remainingText.setHtml(snippet);
+   else
+      remainingText.setPlainText(snippet);
+   QTextDocument result;
+   QTextCursor resultCursor(&result);
+   QRegularExpression const regexp(R"((#\{(.*?)(?<!\\)\}))");
+   while (true)
+   {
+      QTextCursor cursor = remainingText.find(regexp);
+      if (cursor.isNull())
+      {
+         resultCursor.movePosition(QTextCursor::End);
+         resultCursor.insertHtml(remainingText.toHtml());
+         return isHtml ? result.toHtml() : result.toPlainText();
+      }
+      QString variable = cursor.selection().toPlainText();
+      variable = variable.mid(2, variable.size() - 3);
+      cursor.removeSelectedText();
+      cursor.movePosition(QTextCursor::Start, QTextCursor::KeepAnchor);
+      resultCursor.movePosition(QTextCursor::End);
+      resultCursor.insertHtml(cursor.selection().toHtml());
+      cursor.removeSelectedText();
+      if ("cursor" == variable)
+      {
+         outCursorOffset = result.toPlainText().size();
+         continue;
+      }
+      resultCursor.movePosition(QTextCursor::End);
+      bool isHtml = false, cancelled = false;
+      QString const value = evaluateVariable(SnippetTemplate::variableNode(variable), isHtml, cancelled);
+      if (isHtml)
+         resultCursor.insertHtml(value);
+      else
+         resultCursor.insertText(value);
+   }
+}
+
+
+//**********************************************************************************************************************
+/// The function is called repeatedly until the minimum time has elapsed.
+///
+/// \param[in] function The function to measure
+/// \param[in] minTimeMs The minimum time spent measuring, in milliseconds
+/// \return The average time taken by a call to the function, in nanoseconds
+//**********************************************************************************************************************
+double measure(std::function<void()> const& function, qint32 minTimeMs)
+{
+   qint64 iterations = 0;
+   benchmark::Stopwatch const stopwatch;
+   while ((iterations < kMinIterations) || (stopwatch.elapsedNs() < qint64(minTimeMs) * 1000000))
+   {
+      function();
+      ++iterations;
+   }
+   return double(stopwatch.elapsedNs()) / double(iterations);
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] str The string
+/// \param[out] outSizes The list of sizes
+/// \return true if and only if the string is a valid comma-separated list of positive integers
+//**********************************************************************************************************************
+bool parseSizes(QString const& str, std::vector<qint32>& outSizes)
+{
+   outSizes.clear();
+   for (QString const& item: str.split(','))
+   {
+      bool ok = false;
+      qint32 const size = item.trimmed().toInt(&ok);
+      if ((!ok) || (size <= 0))
+         return false;
+      outSizes.push_back(size);
+   }
+   return !outSizes.empty();
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void printUsage()
+{
+   std::printf(
+      "Usage: SnippetBenchmark [options]\n"
+      "  --sizes <n1,n2,...>     Sizes of the generated snippets, in characters (default: 100,1000,10000,100000)\n"
+      "  --spacing <n>           Average number of characters between two variables (default: 100)\n"
+      "  --min-time <ms>         Minimum time spent measuring each evaluation path (default: 200)\n"
+      "  --format <plain|html|all>   Formats of the snippets to benchmark (default: all)\n"
+      "  --seed <n>              Seed of the random number generator (default: 42)\n");
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \param[out] outOptions The options
+/// \return true if and only if the command line is valid
+//**********************************************************************************************************************
+bool parseCommandLine(int argc, char* argv[], Options& outOptions)
+{
+   for (qint32 i = 1; i < argc; ++i)
+   {
+      QString const arg = QString::fromLocal8Bit(argv[i]);
+      if (("--help" == arg) || ("-h" == arg) || (i + 1 >= argc))
+         return false;
+      QString const value = QString::fromLocal8Bit(argv[++i]);
+      bool ok = true;
+      if ("--sizes" == arg)
+         ok = parseSizes(value, outOptions.sizes);
+      else if ("--spacing" == arg)
+         outOptions.variableSpacing = value.toInt(&ok);
+      else if ("--min-time" == arg)
+         outOptions.minTimeMs = value.toInt(&ok);
+      else if ("--seed" == arg)
+         outOptions.seed = value.toUInt(&ok);
+      else if ("--format" == arg)
+      {
+         outOptions.runPlainText = ("plain" == value) || ("all" == value);
+         outOptions.runHtml = ("html" == value) || ("all" == value);
+         ok = outOptions.runPlainText || outOptions.runHtml;
+      }
+      else
+         ok = false;
+      if (!ok)
+         return false;
+   }
+   return (outOptions.variableSpacing > 0) && (outOptions.minTimeMs >= 0);
+}
+
+
+//**********************************************************************************************************************
+/// The snippet is evaluated through a text document, as it was before snippet templates were introduced, and with the
+/// snippet template. The time taken to compile the template is reported separately, as it is only paid once per edit
+/// of the snippet. For HTML snippets, the plain text of the results are compared, as their serializations differ.
+///
+/// \param[in] snippet The snippet
+/// \param[in] isHtml Is the snippet in HTML format
+/// \param[in] variableCount The number of variables in the snippet
+/// \param[in] options The options
+/// \return true if and only if both evaluations produced the same result
+//**********************************************************************************************************************
+bool runSnippet(QString const& snippet, bool isHtml, qint32 variableCount, Options const& options)
+{
+   qint32 documentCursorOffset = -1, templateCursorOffset = -1;
+   QString documentResult, templateResult;
+   double const documentNs = measure([&]() { documentResult = evaluateWithTextDocument(snippet, isHtml,
+      documentCursorOffset); }, options.minTimeMs);
+   double const compileNs = measure([&]() { SnippetTemplate const snippetTemplate(snippet, isHtml); },
+      options.minTimeMs);
+   SnippetTemplate const snippetTemplate(snippet, isHtml);
+   double const templateNs = measure([&]()
+   {
+      bool cancelled = false;
+      templateResult = isHtml ? snippetTemplate.evaluateHtml(evaluateVariable, cancelled, &templateCursorOffset) :
+         snippetTemplate.evaluatePlainText(evaluateVariable, cancelled, &templateCursorOffset);
+   }, options.minTimeMs);
+   if (isHtml)
+   {
+      documentResult = QTextDocumentFragment::fromHtml(documentResult).toPlainText();
+      templateResult = QTextDocumentFragment::fromHtml(templateResult).toPlainText();
+   }
+   bool const identical = (documentResult == templateResult) && (documentCursorOffset == templateCursorOffset);
+   std::printf("%-6s %9d %9d %14.2f %14.2f %14.2f %8.1fx %10s\n", isHtml ? "html" : "plain", snippet.size(),
+      variableCount, documentNs / 1000.0, compileNs / 1000.0, templateNs / 1000.0, documentNs / qMax(templateNs, 1.0),
+      identical ? "yes" : "NO");
+   std::fflush(stdout);
+   return identical;
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// For each size, a plain text snippet is generated, and converted to HTML, then both snippets are benchmarked.
+///
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \return The exit code of the application
+//**********************************************************************************************************************
+int main(int argc, char* argv[])
+{
+   if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+      qputenv("QT_QPA_PLATFORM", "offscreen"); // text documents need a GUI application, but no display
+   QGuiApplication app(argc, argv);
+   Options options;
+   if (!parseCommandLine(argc, argv, options))
+   {
+      printUsage();
+      return 1;
+   }
+
+   std::printf("%-6s %9s %9s %14s %14s %14s %9s %10s\n", "format", "size", "variables", "document (us)",
+      "compile (us)", "template (us)", "speedup", "identical");
+   std::mt19937 rng(options.seed);
+   bool allIdentical = true;
+   for (qint32 const size: options.sizes)
+   {
+      qint32 variableCount = 0;
+      QString const snippet = generateSnippet(size, options.variableSpacing, rng, variableCount);
+      if (options.runPlainText)
+         allIdentical = runSnippet(snippet, false, variableCount, options) && allIdentical;
+      if (options.runHtml)
+         allIdentical = runSnippet(htmlSnippet(snippet, rng), true, variableCount, options) && allIdentical;
+   }
+   if (!allIdentical)
+   {
+      std::printf("The snippet templates and the text document produced different results.\n");
+      return 1;
+   }
+   return 0;
+}
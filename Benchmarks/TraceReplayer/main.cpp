@@ -0,0 +1,304 @@
+/// \file
+/// \author Xavier Michelon
+///
+/// \brief Deterministic replayer of keystroke trace files, used to reproduce and compare the performance of builds
+///  
+/// Copyright (c) Xavier Michelon. All rights reserved.  
+/// Licensed under the MIT License. See LICENSE file in the project root for full license information.  
+
+
+#include "stdafx.h"
+#include "BenchmarkUtils.h"
+#include "PipelineListener.h"
+#include "KeystrokeTrace.h"
+#include "Combo/KeywordIndex.h"
+#include "Combo/KeywordSnapshot.h"
+#include "Combo/MatchingWorker.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+
+namespace {
+
+
+//**********************************************************************************************************************
+/// \brief The options of the replayer
+//**********************************************************************************************************************
+struct Options
+{
+   QString tracePath; ///< The path of the trace file
+   QString comboListPath; ///< The path of the combo list file, if any
+   bool originalSpeed { false }; ///< Are the events replayed at the pace they were recorded
+   qint32 runCount { 1 }; ///< The number of times the trace is replayed
+}; ///< The options of the replayer
+
+
+//**********************************************************************************************************************
+/// \brief The result of a replay of the trace
+//**********************************************************************************************************************
+struct RunResult
+{
+   qint64 elapsedNs { -1 }; ///< The time taken to process the trace, or -1 if the pipeline did not complete
+   qint64 matchCount { 0 }; ///< The number of matches, excluding the sentinel
+   quint64 checksum { 0 }; ///< The checksum of the sequence of matches
+   std::vector<qint64> latenciesNs; ///< The time elapsed between the last event and each match. Only meaningful at original speed
+}; ///< The result of a replay of the trace
+
+
+QString const kSentinelKeyword = "qqsentinelqq"; ///< The keyword typed at the end of the replay, whose match tells all keystrokes were processed
+qint32 const kTimeoutMs = 10000; ///< The time allowed for the matching thread to catch up after the replay ended
+quint64 const kFnvOffsetBasis = 14695981039346656037ULL; ///< The offset basis of the FNV-1a hash function
+quint64 const kFnvPrime = 1099511628211ULL; ///< The prime of the FNV-1a hash function
+quint32 const kMatchSeparator = 0xffffffff; ///< The value added to the checksum after the IDs of each match
+
+
+//**********************************************************************************************************************
+/// \param[in] hash The current value of the hash
+/// \param[in] value The value to add to the hash
+/// \return The updated hash
+//**********************************************************************************************************************
+quint64 fnv1a(quint64 hash, quint32 value)
+{
+   for (qint32 i = 0; i < 4; ++i)
+      hash = (hash ^ ((value >> (8 * i)) & 0xff)) * kFnvPrime;
+   return hash;
+}
+
+
+//**********************************************************************************************************************
+/// Only the keywords and matching modes of the enabled combos are used.
+///
+/// \param[in] path The path of the combo list file
+/// \param[out] outIndex The keyword index
+/// \return true if and only if the combo list was loaded
+//**********************************************************************************************************************
+bool loadComboList(QString const& path, KeywordIndex& outIndex)
+{
+   QFile file(path);
+   if (!file.open(QIODevice::ReadOnly))
+      return false;
+   QJsonDocument const doc = QJsonDocument::fromJson(file.readAll());
+   if (!doc.isObject())
+      return false;
+   for (QJsonValue const& value: doc.object()["combos"].toArray())
+   {
+      QJsonObject const object = value.toObject();
+      QString const keyword = object.contains("keyword") ? object["keyword"].toString() :
+         object["comboText"].toString();
+      if ((!keyword.isEmpty()) && object["enabled"].toBool(true))
+         outIndex.insert(keyword, object["useLooseMatch"].toBool(false));
+   }
+   return true;
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] latenciesNs The sorted latencies
+/// \param[in] percentile The percentile
+/// \return The latency at the given percentile, in microseconds
+//**********************************************************************************************************************
+double latencyAtPercentileUs(std::vector<qint64> const& latenciesNs, double percentile)
+{
+   if (latenciesNs.empty())
+      return 0.0;
+   size_t const index = size_t(std::ceil(percentile / 100.0 * double(latenciesNs.size()))) - 1;
+   return double(latenciesNs[qMin(index, latenciesNs.size() - 1)]) / 1000.0;
+}
+
+
+//**********************************************************************************************************************
+/// The matching thread and the keystroke queue are created for each run, so runs do not depend on each other.
+///
+/// \param[in] events The events to replay
+/// \param[in] index The keyword index
+/// \param[in] sentinelId The ID of the sentinel keyword
+/// \param[in] options The options
+/// \return The result of the run
+//**********************************************************************************************************************
+RunResult replay(std::vector<ReplayEvent> const& events, KeywordIndex const& index, qint32 sentinelId,
+   Options const& options)
+{
+   KeystrokeQueue queue;
+   MatchingWorker worker(queue);
+   KeywordSnapshot snapshot;
+   snapshot.build(index);
+   worker.setKeywordSnapshot(std::move(snapshot));
+   worker.setSettings(MatchingWorker::Settings());
+   QThread matchingThread;
+   worker.moveToThread(&matchingThread);
+   QObject::connect(&matchingThread, &QThread::started, &worker, &MatchingWorker::run);
+
+   ReplayInputSource source;
+   source.setEvents(events);
+   source.setUseTimestamps(options.originalSpeed);
+   benchmark::PipelineListener listener(source, queue);
+
+   RunResult result;
+   result.checksum = kFnvOffsetBasis;
+   std::atomic<qint64> elapsedNs { -1 };
+   QEventLoop loop;
+   benchmark::Stopwatch stopwatch;
+   QObject::connect(&worker, &MatchingWorker::comboMatched, [&](QVector<qint32> const& ids, QStringList const&,
+      QVector<qint32> const&, quint64)
+   {
+      if (ids.contains(sentinelId))
+      {
+         elapsedNs = stopwatch.elapsedNs();
+         QMetaObject::invokeMethod(&loop, "quit", Qt::QueuedConnection);
+         return;
+      }
+      result.latenciesNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+         std::chrono::steady_clock::now().time_since_epoch()).count() - listener.lastEventTimestampNs());
+      ++result.matchCount;
+      QVector<qint32> sortedIds = ids;
+      std::sort(sortedIds.begin(), sortedIds.end());
+      for (qint32 const id: sortedIds)
+         result.checksum = fnv1a(result.checksum, quint32(id));
+      result.checksum = fnv1a(result.checksum, kMatchSeparator);
+   }); // the connection is direct: the lambda runs on the matching thread
+   QObject::connect(&source, &ReplayInputSource::finished, [&]() { QTimer::singleShot(kTimeoutMs, &loop,
+      &QEventLoop::quit); });
+
+   matchingThread.start();
+   stopwatch.restart();
+   source.start(listener);
+   loop.exec();
+   source.stop();
+   worker.stop();
+   matchingThread.quit();
+   matchingThread.wait();
+   result.elapsedNs = elapsedNs;
+   std::sort(result.latenciesNs.begin(), result.latenciesNs.end());
+   return result;
+}
+
+
+//**********************************************************************************************************************
+//
+//**********************************************************************************************************************
+void printUsage()
+{
+   std::printf(
+      "Usage: TraceReplayer --trace <path> [options]\n"
+      "  --trace <path>          The keystroke trace file recorded by Beeftext\n"
+      "  --combos <path>         The combo list file whose keywords are matched (default: none)\n"
+      "  --speed <original|max>  Replay the events at the pace they were recorded, or as fast as possible "
+      "(default: max)\n"
+      "  --runs <n>              Number of times the trace is replayed (default: 1)\n");
+}
+
+
+//**********************************************************************************************************************
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \param[out] outOptions The options
+/// \return true if and only if the command line is valid
+//**********************************************************************************************************************
+bool parseCommandLine(int argc, char* argv[], Options& outOptions)
+{
+   for (qint32 i = 1; i < argc; ++i)
+   {
+      QString const arg = QString::fromLocal8Bit(argv[i]);
+      if (("--help" == arg) || ("-h" == arg) || (i + 1 >= argc))
+         return false;
+      QString const value = QString::fromLocal8Bit(argv[++i]);
+      bool ok = true;
+      if ("--trace" == arg)
+         outOptions.tracePath = value;
+      else if ("--combos" == arg)
+         outOptions.comboListPath = value;
+      else if ("--speed" == arg)
+      {
+         ok = ("original" == value) || ("max" == value);
+         outOptions.originalSpeed = ("original" == value);
+      }
+      else if ("--runs" == arg)
+         outOptions.runCount = value.toInt(&ok);
+      else
+         ok = false;
+      if (!ok)
+         return false;
+   }
+   return (!outOptions.tracePath.isEmpty()) && (outOptions.runCount > 0);
+}
+
+
+} // anonymous namespace
+
+
+//**********************************************************************************************************************
+/// The trace is replayed on the main thread, processed the way the input manager processes it, and matched on a
+/// matching thread, as in the application. The keystrokes of a sentinel keyword are appended to the trace, and the
+/// time is measured until the sentinel is matched. The checksum of the ordered sequence of matched keywords must be
+/// identical for every run, and can be compared between builds, otherwise the replay is reported as not
+/// reproducible.
+///
+/// \param[in] argc The number of command line arguments
+/// \param[in] argv The command line arguments
+/// \return The exit code of the application
+//**********************************************************************************************************************
+int main(int argc, char* argv[])
+{
+   QCoreApplication app(argc, argv);
+   Options options;
+   if (!parseCommandLine(argc, argv, options))
+   {
+      printUsage();
+      return 1;
+   }
+
+   std::vector<ReplayEvent> events;
+   QString errorMessage;
+   if (!KeystrokeTraceReader::read(options.tracePath, events, &errorMessage))
+   {
+      std::fprintf(stderr, "%s\n", errorMessage.toLocal8Bit().constData());
+      return 1;
+   }
+   qint64 const traceDurationNs = events.empty() ? 0 : events.back().timestampNs;
+   qint32 const traceEventCount = qint32(events.size());
+   std::vector<ReplayEvent> sentinel = ReplayInputSource::eventsFromText(QString(" %1 ").arg(kSentinelKeyword));
+   for (ReplayEvent& event: sentinel)
+      event.timestampNs = traceDurationNs;
+   events.insert(events.end(), sentinel.begin(), sentinel.end());
+
+   KeywordIndex index;
+   if ((!options.comboListPath.isEmpty()) && (!loadComboList(options.comboListPath, index)))
+   {
+      std::fprintf(stderr, "Could not read the combo list file.\n");
+      return 1;
+   }
+   qint32 const comboCount = index.size();
+   qint32 const sentinelId = index.insert(kSentinelKeyword, false);
+
+   std::printf("Trace: %d events over %.3f s. Combos: %d. Speed: %s.\n", traceEventCount,
+      double(traceDurationNs) / 1e9, comboCount, options.originalSpeed ? "original" : "max");
+   quint64 referenceChecksum = 0;
+   bool reproducible = true;
+   for (qint32 run = 0; run < options.runCount; ++run)
+   {
+      RunResult const result = replay(events, index, sentinelId, options);
+      if (result.elapsedNs < 0)
+      {
+         std::printf("Run %d: the pipeline did not process every keystroke.\n", run + 1);
+         return 1;
+      }
+      if (0 == run)
+         referenceChecksum = result.checksum;
+      reproducible = reproducible && (result.checksum == referenceChecksum);
+      double const seconds = double(result.elapsedNs) / 1e9;
+      std::printf("Run %d: %.3f s (%.1f ns/event). Matches: %lld. Checksum: %016llx. Match latency p50/p99/max: "
+         "%.1f/%.1f/%.1f us.\n", run + 1, seconds, double(result.elapsedNs) / double(qMax<size_t>(events.size(), 1)),
+         static_cast<long long>(result.matchCount), static_cast<unsigned long long>(result.checksum),
+         latencyAtPercentileUs(result.latenciesNs, 50.0), latencyAtPercentileUs(result.latenciesNs, 99.0),
+         latencyAtPercentileUs(result.latenciesNs, 100.0));
+   }
+   if (!reproducible)
+   {
+      std::printf("The matches differ between runs: the replay is not reproducible.\n");
+      return 1;
+   }
+   return 0;
+}